@@ -0,0 +1,107 @@
+#pragma once
+#include "core/Statistics.h"
+#include <iomanip>
+
+namespace ProjectJ{
+    struct MicroBenchmarkResult{
+        std::string name;
+        uint64_t iterations;
+        double avgNs;
+        double p50Ns;
+        double p95Ns;
+        double p99Ns;
+        // 0 when the benchmark does not move data.
+        double bytesPerSecond;
+    };
+
+    // Calibrates a batch size so one sample takes a few tens of microseconds, then takes samples
+    // (ns per iteration) until minTimeMs has passed. Results are written as JSON lines so a run can
+    // be stored and handed back later with --baseline.
+    class MicroBenchmarkRunner{
+    public:
+        MicroBenchmarkRunner(double minTimeMs, std::string filter)
+            :mMinTimeNs(static_cast<uint64_t>(minTimeMs * 1e6)), mFilter(std::move(filter)){}
+
+        // op runs its body `iterations` times.
+        void Run(const std::string& name, const std::function<void(uint64_t iterations)>& op, uint64_t bytesPerIteration = 0){
+            if(!mFilter.empty() && name.find(mFilter) == std::string::npos){
+                return;
+            }
+            constexpr uint64_t kTargetSampleNs = 50000;
+            constexpr size_t kMaxSamples = 10000;
+            uint64_t start = Profiler::Now();
+            op(1);
+            uint64_t single = std::max<uint64_t>(Profiler::Now() - start, 1);
+            uint64_t batch = std::clamp<uint64_t>(kTargetSampleNs / single, 1, 1000000);
+
+            RollingStats samples(kMaxSamples);
+            uint64_t iterations = 0;
+            uint64_t elapsed = 0;
+            while((elapsed < mMinTimeNs || samples.Count() < 5) && samples.Count() < kMaxSamples){
+                uint64_t batchStart = Profiler::Now();
+                op(batch);
+                uint64_t batchNs = Profiler::Now() - batchStart;
+                samples.Add(static_cast<double>(batchNs) / batch);
+                iterations += batch;
+                elapsed += batchNs;
+            }
+            MicroBenchmarkResult result{};
+            result.name = name;
+            result.iterations = iterations;
+            result.avgNs = samples.Average();
+            result.p50Ns = samples.Percentile(0.5);
+            result.p95Ns = samples.Percentile(0.95);
+            result.p99Ns = samples.Percentile(0.99);
+            result.bytesPerSecond = bytesPerIteration > 0 ? bytesPerIteration * iterations / (elapsed / 1e9) : 0.0;
+            mResults.push_back(result);
+            JLOG_INFO("{}: p50 {:.1f} ns, p99 {:.1f} ns ({} iterations)", name, result.p50Ns, result.p99Ns, iterations);
+        }
+
+        const std::vector<MicroBenchmarkResult>& GetResults() const {return mResults;}
+
+        void WriteJsonLines(std::ostream& out) const{
+            out << std::fixed << std::setprecision(2);
+            for(const auto& r : mResults){
+                out << "{\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                    << ", \"avgNs\": " << r.avgNs << ", \"p50Ns\": " << r.p50Ns
+                    << ", \"p95Ns\": " << r.p95Ns << ", \"p99Ns\": " << r.p99Ns
+                    << ", \"bytesPerSecond\": " << r.bytesPerSecond << "}\n";
+            }
+        }
+
+        // Reads p50 values back from a previous WriteJsonLines output and writes the speedup to out.
+        void CompareWithBaseline(const std::string& path, std::ostream& out) const{
+            std::ifstream in(path);
+            if(!in.is_open()){
+                JLOG_ERROR("failed to open baseline {}", path);
+                return;
+            }
+            std::unordered_map<std::string, double> baseline;
+            std::string line;
+            while(std::getline(in, line)){
+                auto nameStart = line.find("\"name\": \"");
+                auto p50Start = line.find("\"p50Ns\": ");
+                if(nameStart == std::string::npos || p50Start == std::string::npos){
+                    continue;
+                }
+                nameStart += 9;
+                std::string name = line.substr(nameStart, line.find('"', nameStart) - nameStart);
+                baseline[name] = std::stod(line.substr(p50Start + 9));
+            }
+            out << std::fixed;
+            for(const auto& r : mResults){
+                auto it = baseline.find(r.name);
+                if(it == baseline.end() || r.p50Ns <= 0.0){
+                    continue;
+                }
+                out << r.name << ": p50 " << std::setprecision(1) << it->second << " ns -> " << r.p50Ns
+                    << " ns (" << std::setprecision(2) << it->second / r.p50Ns << "x)\n";
+            }
+            out.flush();
+        }
+    private:
+        uint64_t mMinTimeNs;
+        std::string mFilter;
+        std::vector<MicroBenchmarkResult> mResults;
+    };
+}
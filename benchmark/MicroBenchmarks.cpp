@@ -0,0 +1,267 @@
+#include <Jpch.h>
+#include "MicroBenchmark.h"
+#include "core/Scene.h"
+#include "core/Visibility.h"
+#include <random>
+#include "stb_image_write.h"
+
+// Microbenchmarks for the RHI hot paths, on a headless device. Writes one JSON object per line:
+//   ProjectJ-MicroBenchmarks --output baseline.jsonl
+//   ProjectJ-MicroBenchmarks --baseline baseline.jsonl [--filter Staging] [--min-time 500]
+// Run from the directory holding shaders/. Results and the baseline comparison go to stdout, logs to stderr.
+namespace{
+    using namespace ProjectJ;
+
+    // keeps results observable so the optimizer can not drop the work being measured.
+    volatile uint64_t gSink = 0;
+
+    void BenchmarkUniformBuffer(VulkanRHI& rhi, MicroBenchmarkRunner& runner){
+        VulkanUniformBuffer<UniformBufferObject> uniformBuffer(rhi, VK_SHADER_STAGE_VERTEX_BIT);
+        float angle = 0.0f;
+        runner.Run("UniformBuffer/ModifyAndSync", [&](uint64_t iterations){
+            for(uint64_t i = 0; i < iterations; i++){
+                angle += 0.01f;
+                uniformBuffer.ModifyAndSync([angle](UniformBufferObject& ubo){
+                    ubo.model = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f));
+                    ubo.view = glm::mat4(1.0f);
+                    ubo.proj = glm::mat4(1.0f);
+                });
+            }
+        }, sizeof(UniformBufferObject));
+    }
+
+    void BenchmarkStagingUpload(VulkanRHI& rhi, MicroBenchmarkRunner& runner){
+        for(size_t size : {size_t(4) << 10, size_t(64) << 10, size_t(1) << 20, size_t(16) << 20}){
+            std::vector<uint8_t> data(size, 0x5a);
+            VulkanVertexBuffer destination(rhi, size);
+            runner.Run("StagingUpload/" + std::to_string(size >> 10) + "KiB", [&](uint64_t iterations){
+                for(uint64_t i = 0; i < iterations; i++){
+                    VulkanStagingBuffer staging(rhi, data.data(), size);
+                    staging.CopyToBuffer(&destination);
+                }
+            }, size);
+        }
+    }
+
+    void BenchmarkPSOCreation(VulkanRHI& rhi, MicroBenchmarkRunner& runner){
+        VulkanPSODesc desc = rhi.GetDefaultPSODesc();
+        runner.Run("VulkanPSO/Create", [&](uint64_t iterations){
+            for(uint64_t i = 0; i < iterations; i++){
+                VulkanPSO pso(rhi.GetRenderPass(), rhi.GetDevice(), desc);
+            }
+        });
+    }
+
+    void BenchmarkDescriptorSets(VulkanRHI& rhi, MicroBenchmarkRunner& runner){
+        constexpr uint32_t kPoolSets = 1024;
+        VkDevice device = rhi.GetDevice();
+        TestShader shader(rhi, kPoolSets);
+        VulkanDynamicUniformBuffer<UniformBufferObject> uniformBuffer(rhi, 1, VK_SHADER_STAGE_VERTEX_BIT);
+        std::vector<uint8_t> pixels(16 * 16 * 4, 0xff);
+        VulkanSamplerDesc samplerDesc{};
+        samplerDesc.magFilter = samplerDesc.minFilter = VK_FILTER_LINEAR;
+        samplerDesc.u = samplerDesc.v = samplerDesc.w = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        auto texture = TextureLoader::CreateTexSamplerFromPixels(rhi, pixels.data(), 16, 16, samplerDesc, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = shader.GetDescriptorPool();
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &shader.GetDescriptorSetLayout();
+
+        // the pool reset is part of the measured cost, amortized over kPoolSets allocations.
+        uint32_t allocated = 0;
+        auto allocate = [&](){
+            if(allocated == kPoolSets){
+                vkResetDescriptorPool(device, shader.GetDescriptorPool(), 0);
+                allocated = 0;
+            }
+            VkDescriptorSet set;
+            VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, &set),"failed to allocate descriptor sets");
+            allocated++;
+            return set;
+        };
+        runner.Run("DescriptorSet/Allocate", [&](uint64_t iterations){
+            for(uint64_t i = 0; i < iterations; i++){
+                gSink = gSink + reinterpret_cast<uint64_t>(allocate());
+            }
+        });
+
+        VkDescriptorSet set = allocate();
+        VkDescriptorBufferInfo bufferInfo = uniformBuffer.GetBufferInfo();
+        VkDescriptorImageInfo imageInfo = texture->GetImageInfo();
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = set;
+        writes[0].dstBinding = 0;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        writes[0].descriptorCount = 1;
+        writes[0].pBufferInfo = &bufferInfo;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = set;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[1].descriptorCount = 1;
+        writes[1].pImageInfo = &imageInfo;
+        runner.Run("DescriptorSet/Update", [&](uint64_t iterations){
+            for(uint64_t i = 0; i < iterations; i++){
+                vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+            }
+        });
+        vkResetDescriptorPool(device, shader.GetDescriptorPool(), 0);
+    }
+
+    void BenchmarkReflection(MicroBenchmarkRunner& runner){
+        // the same walk VulkanShader does to build its descriptor set layout.
+        runner.Run("Reflection/ForEachMember", [&](uint64_t iterations){
+            for(uint64_t i = 0; i < iterations; i++){
+                uint64_t bindings = 0;
+                for_each_member(ShaderParam<TestShader>{}, [&bindings](int index, const auto& val){
+                    if constexpr (is_uniform_buffer<std::decay_t<decltype(val)> >::value){
+                        bindings += (index + 1) * 2;
+                    }
+                    else{
+                        bindings += index + 1;
+                    }
+                });
+                gSink = gSink + bindings;
+            }
+        });
+    }
+
+    void BenchmarkFrustumCulling(MicroBenchmarkRunner& runner){
+        // spheres scattered around the default camera, about one in a hundred on screen like in a large world.
+        constexpr uint32_t kObjectCount = 1000000;
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+        std::uniform_real_distribution<float> radius(0.01f, 0.2f);
+        BoundingSpheres bounds;
+        bounds.Resize(kObjectCount);
+        for(uint32_t i = 0; i < kObjectCount; i++){
+            bounds.Set(i, glm::vec3(position(random), position(random), position(random)), radius(random));
+        }
+        SceneView sceneView = ComputeSceneView(0.0f, 16.0f / 9.0f);
+        Frustum frustum = ExtractFrustum(sceneView.proj * sceneView.view);
+        std::vector<uint32_t> visible;
+        uint64_t boundsBytes = static_cast<uint64_t>(kObjectCount) * 4 * sizeof(float);
+
+        auto run = [&](FrustumCuller& culler, const std::string& name){
+            runner.Run("FrustumCulling/1M/" + name, [&](uint64_t iterations){
+                for(uint64_t i = 0; i < iterations; i++){
+                    culler.Cull(bounds, frustum, visible);
+                    gSink = gSink + visible.size();
+                }
+            }, boundsBytes);
+        };
+        FrustumCuller scalar(1, false);
+        run(scalar, "scalar");
+        FrustumCuller simd(1, true);
+        run(simd, simd.GetSimdName());
+        FrustumCuller parallel(0, true);
+        if(parallel.GetThreadCount() > 1){
+            run(parallel, std::string(parallel.GetSimdName()) + "/" + std::to_string(parallel.GetThreadCount()) + "threads");
+        }
+        JLOG_INFO("frustum culling: {} of {} objects visible", visible.size(), kObjectCount);
+    }
+
+    void BenchmarkTextureDecode(VulkanRHI& rhi, MicroBenchmarkRunner& runner){
+        SyntheticSceneDesc sceneDesc{};
+        sceneDesc.textureCount = 1;
+        sceneDesc.textureSize = 1024;
+        Scene scene = CreateSyntheticScene(sceneDesc);
+        const SceneTexture& source = scene.textures[0];
+
+        auto writeFile = [](void* context, void* data, int size){
+            static_cast<std::ofstream*>(context)->write(static_cast<const char*>(data), size);
+        };
+        auto directory = std::filesystem::temp_directory_path();
+        std::string pngPath = (directory / "ProjectJ-bench.png").string();
+        std::string jpgPath = (directory / "ProjectJ-bench.jpg").string();
+        {
+            std::ofstream png(pngPath, std::ios::binary);
+            stbi_write_png_to_func(writeFile, &png, source.width, source.height, 4, source.pixels.data(), source.width * 4);
+            std::ofstream jpg(jpgPath, std::ios::binary);
+            stbi_write_jpg_to_func(writeFile, &jpg, source.width, source.height, 4, source.pixels.data(), 90);
+        }
+        uint64_t imageBytes = static_cast<uint64_t>(source.width) * source.height * 4;
+        for(const auto& file : {std::make_pair("png", pngPath), std::make_pair("jpg", jpgPath)}){
+            runner.Run(std::string("TextureLoader/Decode/") + file.first, [&](uint64_t iterations){
+                for(uint64_t i = 0; i < iterations; i++){
+                    DecodedImage image = DecodeImage(file.second);
+                    gSink = gSink + image.pixels.get()[0];
+                }
+            }, imageBytes);
+        }
+        VulkanSamplerDesc samplerDesc{};
+        samplerDesc.magFilter = samplerDesc.minFilter = VK_FILTER_LINEAR;
+        samplerDesc.u = samplerDesc.v = samplerDesc.w = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        runner.Run("TextureLoader/CreateTexSamplerFromPath/png", [&](uint64_t iterations){
+            for(uint64_t i = 0; i < iterations; i++){
+                auto texture = TextureLoader::CreateTexSamplerFromPath(rhi, pngPath, samplerDesc, VK_SHADER_STAGE_FRAGMENT_BIT);
+            }
+        }, imageBytes);
+        std::error_code error;
+        std::filesystem::remove(pngPath, error);
+        std::filesystem::remove(jpgPath, error);
+    }
+}
+
+int main(int argc, char** argv){
+    std::string filter;
+    std::string outputPath;
+    std::string baselinePath;
+    double minTimeMs = 200.0;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--filter" && hasValue)           filter = argv[++i];
+        else if(arg == "--output" && hasValue)      outputPath = argv[++i];
+        else if(arg == "--baseline" && hasValue)    baselinePath = argv[++i];
+        else if(arg == "--min-time" && hasValue)    minTimeMs = std::stod(argv[++i]);
+    }
+    // stdout is kept for results, the JSON lines unless --output names a file.
+    LoggerConfig loggerConfig;
+    loggerConfig.toStderr = true;
+    Logger::InitGlobally(loggerConfig);
+
+    // smallest scene that still gives the RHI a material and a texture.
+    SyntheticSceneDesc sceneDesc{};
+    sceneDesc.objectCount = 1;
+    sceneDesc.textureCount = 1;
+    sceneDesc.materialCount = 1;
+    sceneDesc.textureSize = 4;
+    Scene scene = CreateSyntheticScene(sceneDesc);
+    RHIConfig config{};
+    config.enableValidationLayer = false;
+    config.window = nullptr;
+    config.headless = true;
+    config.width = 64;
+    config.height = 64;
+    config.scene = &scene;
+    {
+        auto rhi = RHI::Create(config);
+        MicroBenchmarkRunner runner(minTimeMs, filter);
+        BenchmarkUniformBuffer(*rhi, runner);
+        BenchmarkStagingUpload(*rhi, runner);
+        BenchmarkPSOCreation(*rhi, runner);
+        BenchmarkDescriptorSets(*rhi, runner);
+        BenchmarkReflection(runner);
+        BenchmarkFrustumCulling(runner);
+        BenchmarkTextureDecode(*rhi, runner);
+
+        if(outputPath.empty()){
+            runner.WriteJsonLines(std::cout);
+        }
+        else{
+            std::ofstream out(outputPath);
+            runner.WriteJsonLines(out);
+            JLOG_INFO("wrote {} results to {}", runner.GetResults().size(), outputPath);
+        }
+        if(!baselinePath.empty()){
+            // plain lines, a later --baseline reading this output skips them.
+            runner.CompareWithBaseline(baselinePath, std::cout);
+        }
+    }
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,473 @@
+#include <Jpch.h>
+#include "core/FramePacket.h"
+#include "core/JobSystem.h"
+#include "core/Scene.h"
+#include "core/Statistics.h"
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <thread>
+#ifdef J_WINDOWS
+    #include <malloc.h>
+#endif
+
+// Renders a synthetic scene offscreen for a fixed number of frames and writes frame-time
+// percentiles as JSON to stdout or --output, logs go to stderr, e.g.
+//   ProjectJ-RenderBenchmark --objects 10000 --textures 64 --materials 256 --frames 1000 --output result.json
+// Run from the directory holding shaders/.
+// Built with J_RHI_BACKEND=Null it measures engine side CPU cost only and adds the counted calls.
+// --sessions N renders N independent RHI instances concurrently, one thread each, and reports the
+// merged percentiles. --instancing draws mesh/material batches with indirect draws instead of one
+// draw per object, --frustum-culling adds per-frame culling of their instances on the CPU and
+// --gpu-culling in compute shaders with count-driven indirect draws, --occlusion-culling also against a
+// depth pyramid of the previous frame. --depth turns on the depth test,
+// --reverse-z flips its range and --depth-prepass lays depth down before shading. --lod draws each object
+// at the coarsest generated level within --lod-pixel-error pixels, --lod-budget-ms gives up more detail
+// while frames are over budget. --groups N parents the objects to N scene graph nodes and --move-groups
+// sets every group's transform each frame, which recomputes every object's world matrix. --render-thread
+// simulates on the session thread and draws on a second one, --frame-packets 2 or 3 frames apart; frame
+// times are then the intervals between finished draws. --mesh draws every object with an OBJ/glTF file
+// and reports its vertex cache ACMR before and after import optimization. heapAllocationsPerFrame counts
+// global operator new calls of the whole process during the measured frames, aligned ones included;
+// --require-no-allocations fails the run unless it is zero, ctest runs it that way on the Null backend.
+namespace{
+    // every global operator new of the process so far.
+    std::atomic<uint64_t> gHeapAllocations{0};
+}
+
+void* operator new(std::size_t size){
+    gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* memory = std::malloc(size == 0 ? 1 : size)){
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept{
+    std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept{
+    std::free(memory);
+}
+// over-aligned types, e.g. cache line aligned job data, come here instead; the array and nothrow forms
+// of both end up in these.
+void* operator new(std::size_t size, std::align_val_t alignment){
+    gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef J_WINDOWS
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    // aligned_alloc takes whole multiples of the alignment.
+    void* memory = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align);
+#endif
+    if(memory){
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* memory, std::align_val_t) noexcept{
+#ifdef J_WINDOWS
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept{
+    operator delete(memory, alignment);
+}
+
+namespace{
+    struct BenchmarkOptions{
+        ProjectJ::SyntheticSceneDesc scene;
+        uint32_t width = 1280;
+        uint32_t height = 720;
+        uint32_t warmupFrames = 60;
+        uint32_t frames = 1000;
+        uint32_t sessions = 1;
+        bool enableValidationLayer = false;
+        ProjectJ::VertexEncoding vertexEncoding = ProjectJ::VertexEncoding::Packed;
+        bool enableInstancing = false;
+        bool enableFrustumCulling = false;
+        bool enableGPUCulling = false;
+        bool enableDepth = false;
+        bool reverseZ = false;
+        bool enableDepthPrepass = false;
+        bool enableOcclusionCulling = false;
+        bool enableLod = false;
+        float lodPixelError = 1.0f;
+        float lodFrameBudgetMs = 0.0f;
+        bool moveGroups = false;
+        bool renderThread = false;
+        uint32_t framePackets = 2;
+        bool requireNoAllocations = false;
+        std::string meshPath;
+        std::string outputPath;
+    };
+
+    // nullopt after logging an unknown argument, a missing value or one that does not parse: a
+    // misspelt flag such as --require-no-allocation must not quietly run with the defaults.
+    std::optional<BenchmarkOptions> ParseOptions(int argc, char** argv){
+        BenchmarkOptions options;
+        for(int i = 1; i < argc; i++){
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            auto next = [&](){ return static_cast<uint32_t>(std::stoul(argv[++i])); };
+            try{
+                if(arg == "--objects" && hasValue)          options.scene.objectCount = next();
+                else if(arg == "--textures" && hasValue)    options.scene.textureCount = next();
+                else if(arg == "--materials" && hasValue)   options.scene.materialCount = next();
+                else if(arg == "--meshes" && hasValue)      options.scene.meshCount = next();
+                else if(arg == "--texture-size" && hasValue) options.scene.textureSize = next();
+                else if(arg == "--seed" && hasValue)        options.scene.seed = next();
+                else if(arg == "--groups" && hasValue)      options.scene.groupCount = next();
+                else if(arg == "--width" && hasValue)       options.width = next();
+                else if(arg == "--height" && hasValue)      options.height = next();
+                else if(arg == "--warmup" && hasValue)      options.warmupFrames = next();
+                else if(arg == "--frames" && hasValue)      options.frames = next();
+                else if(arg == "--sessions" && hasValue)    options.sessions = next();
+                else if(arg == "--validation")              options.enableValidationLayer = true;
+                else if(arg == "--vertex-format" && hasValue) options.vertexEncoding = ProjectJ::ParseVertexEncoding(argv[++i]);
+                else if(arg == "--instancing")              options.enableInstancing = true;
+                else if(arg == "--frustum-culling")         options.enableFrustumCulling = true;
+                else if(arg == "--gpu-culling")             options.enableGPUCulling = true;
+                else if(arg == "--depth")                   options.enableDepth = true;
+                else if(arg == "--reverse-z")               options.reverseZ = true;
+                else if(arg == "--depth-prepass")           options.enableDepthPrepass = true;
+                else if(arg == "--occlusion-culling")       options.enableOcclusionCulling = true;
+                else if(arg == "--lod")                     options.enableLod = true;
+                else if(arg == "--lod-pixel-error" && hasValue) options.lodPixelError = std::stof(argv[++i]);
+                else if(arg == "--lod-budget-ms" && hasValue) options.lodFrameBudgetMs = std::stof(argv[++i]);
+                else if(arg == "--move-groups")             options.moveGroups = true;
+                else if(arg == "--render-thread")           options.renderThread = true;
+                else if(arg == "--frame-packets" && hasValue) options.framePackets = next();
+                else if(arg == "--require-no-allocations")  options.requireNoAllocations = true;
+                else if(arg == "--mesh" && hasValue)        options.meshPath = argv[++i];
+                else if(arg == "--output" && hasValue)      options.outputPath = argv[++i];
+                else{
+                    JLOG_ERROR("unknown argument {}", arg);
+                    return std::nullopt;
+                }
+            }
+            catch(const std::exception& e){
+                JLOG_ERROR("invalid value {} for {}: {}", argv[i], arg, e.what());
+                return std::nullopt;
+            }
+        }
+        options.frames = std::max(1u, options.frames);
+        options.sessions = std::max(1u, options.sessions);
+        return options;
+    }
+
+    struct SessionResult{
+        std::vector<double> cpuFrameMs;
+        std::vector<double> gpuMs;
+        std::vector<double> fenceWaitMs;
+        std::vector<double> drawsPerSecond;
+        std::string deviceName;
+        bool gpuTimingSupported = false;
+        double seconds = 0.0;
+        // operator new calls over the measured frames, on any thread.
+        uint64_t heapAllocations = 0;
+#if defined(J_RHI_NULL)
+        ProjectJ::NullRHIStats nullStats;
+#endif
+    };
+
+    // one RHI instance, driven by the calling thread only, or drawn by a render thread of its own.
+    SessionResult RunSession(const BenchmarkOptions& options, const ProjectJ::Scene& scene){
+        using namespace ProjectJ;
+        RHIConfig config{};
+        config.enableValidationLayer = options.enableValidationLayer;
+        config.window = nullptr;
+        config.headless = true;
+        config.width = options.width;
+        config.height = options.height;
+        config.scene = &scene;
+        config.vertexEncoding = options.vertexEncoding;
+        config.enableInstancing = options.enableInstancing;
+        config.enableFrustumCulling = options.enableFrustumCulling;
+        config.enableGPUCulling = options.enableGPUCulling;
+        config.enableDepth = options.enableDepth;
+        config.reverseZ = options.reverseZ;
+        config.enableDepthPrepass = options.enableDepthPrepass;
+        config.enableOcclusionCulling = options.enableOcclusionCulling;
+        config.enableLod = options.enableLod;
+        config.lodPixelError = options.lodPixelError;
+        config.lodFrameBudgetMs = options.lodFrameBudgetMs;
+        auto rhi = RHI::Create(config);
+        // identity like the groups already are, the image stays the same but every group is dirty.
+        auto moveGroups = [&](FramePacket& packet){
+            if(options.moveGroups){
+                for(uint32_t g = 1; g <= options.scene.groupCount; g++){
+                    packet.transforms.push_back({g, glm::mat4(1.0f)});
+                }
+            }
+        };
+
+        SessionResult result;
+        result.cpuFrameMs.reserve(options.frames);
+        result.gpuMs.reserve(options.frames);
+        result.fenceWaitMs.reserve(options.frames);
+        result.drawsPerSecond.reserve(options.frames);
+        uint32_t drawCount = rhi->GetDrawCallCount();
+        uint32_t totalFrames = options.warmupFrames + options.frames;
+        uint64_t sessionStart = Profiler::Now();
+        uint64_t benchmarkStart = sessionStart;
+        uint64_t allocationsStart = gHeapAllocations.load();
+        uint64_t gpuSamples = rhi->GetGPUFrameSampleCount();
+        auto addFrame = [&](double frameMs){
+            result.cpuFrameMs.push_back(frameMs);
+            result.fenceWaitMs.push_back(rhi->GetLastFrameWaitMs());
+            // on Vulkan timestamps of a frame land a few frames later, a frame may bring none or the
+            // same one again; only count each resolved sample once.
+            uint64_t samples = rhi->GetGPUFrameSampleCount();
+            if(samples != gpuSamples){
+                gpuSamples = samples;
+                result.gpuMs.push_back(rhi->GetLastGPUFrameMs());
+            }
+            result.drawsPerSecond.push_back(frameMs > 0.0 ? drawCount / (frameMs / 1000.0) : 0.0);
+        };
+
+        if(options.renderThread){
+            FramePacketQueue packets(options.framePackets);
+            std::exception_ptr renderError;
+            std::thread renderThread([&](){
+                J_PROFILE_THREAD("Render");
+                try{
+                    // without warm-up frames the first interval and benchmarkStart start here, not at 0.
+                    uint64_t lastDone = Profiler::Now();
+                    for(uint32_t i = 0; FramePacket* packet = packets.BeginRead(); i++){
+                        if(i == options.warmupFrames){
+                            benchmarkStart = lastDone;
+                            allocationsStart = gHeapAllocations.load();
+                        }
+                        rhi->Draw(*packet);
+                        packets.EndRead();
+                        uint64_t done = Profiler::Now();
+                        if(i >= options.warmupFrames){
+                            addFrame((done - lastDone) / 1e6);
+                        }
+                        lastDone = done;
+                    }
+                }
+                catch(...){
+                    renderError = std::current_exception();
+                    packets.Close();
+                }
+            });
+            for(uint32_t i = 0; i < totalFrames; i++){
+                FramePacket* packet = packets.BeginWrite();
+                if(!packet){
+                    break;
+                }
+                packet->time = (Profiler::Now() - sessionStart) / 1e9f;
+                moveGroups(*packet);
+                packets.EndWrite();
+            }
+            packets.Close();
+            renderThread.join();
+            if(renderError){
+                std::rethrow_exception(renderError);
+            }
+        }
+        else{
+            FramePacket packet;
+            for(uint32_t i = 0; i < totalFrames; i++){
+                if(i == options.warmupFrames){
+                    benchmarkStart = Profiler::Now();
+                    allocationsStart = gHeapAllocations.load();
+                }
+                uint64_t frameStart = Profiler::Now();
+                packet.frameIndex = i;
+                packet.time = (frameStart - sessionStart) / 1e9f;
+                packet.transforms.clear();
+                moveGroups(packet);
+                rhi->Draw(packet);
+                if(i >= options.warmupFrames){
+                    addFrame((Profiler::Now() - frameStart) / 1e6);
+                }
+            }
+        }
+        result.seconds = (Profiler::Now() - benchmarkStart) / 1e9;
+        result.heapAllocations = gHeapAllocations.load() - allocationsStart;
+        result.deviceName = rhi->GetDeviceName();
+        result.gpuTimingSupported = rhi->IsGPUTimingSupported();
+#if defined(J_RHI_NULL)
+        result.nullStats = rhi->GetStats();
+#endif
+        return result;
+    }
+
+    // s as a JSON string literal, quotes included.
+    void WriteJsonString(std::ostream& out, const std::string& s){
+        out << '"';
+        for(char c : s){
+            if(c == '"' || c == '\\'){
+                out << '\\' << c;
+            }
+            else if(static_cast<unsigned char>(c) < 0x20){
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            }
+            else{
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    void WriteStats(std::ostream& out, const char* name, const std::vector<SessionResult>& results,
+        std::vector<double> SessionResult::* samples, bool last = false){
+        size_t count = 0;
+        for(const auto& result : results){
+            count += (result.*samples).size();
+        }
+        ProjectJ::RollingStats stats(count);
+        for(const auto& result : results){
+            for(double sample : result.*samples){
+                stats.Add(sample);
+            }
+        }
+        out << "    \"" << name << "\": {\"avg\": " << stats.Average()
+            << ", \"p50\": " << stats.Percentile(0.5)
+            << ", \"p95\": " << stats.Percentile(0.95)
+            << ", \"p99\": " << stats.Percentile(0.99) << "}" << (last ? "\n" : ",\n");
+    }
+}
+
+int main(int argc, char** argv){
+    using namespace ProjectJ;
+    // stdout only carries the JSON, a CI script can read it while warnings go to stderr.
+    LoggerConfig loggerConfig;
+    loggerConfig.toStderr = true;
+    Logger::InitGlobally(loggerConfig);
+    std::optional<BenchmarkOptions> parsed = ParseOptions(argc, argv);
+    if(!parsed){
+        Logger::Shutdown();
+        return 1;
+    }
+    const BenchmarkOptions& options = *parsed;
+    J_PROFILE_THREAD("Main");
+    // the sessions share one pool, created on the main thread.
+    JobSystem::Get();
+
+    Scene scene = CreateSyntheticScene(options.scene);
+    MeshOptimizeStats meshStats;
+    if(!options.meshPath.empty()){
+        scene.meshes.assign(1, {"", LoadMesh(options.meshPath, true, &meshStats), {}});
+        for(auto& object : scene.objects){
+            object.meshIndex = 0;
+        }
+    }
+    std::vector<SessionResult> results(options.sessions);
+    if(options.sessions == 1){
+        results[0] = RunSession(options, scene);
+    }
+    else{
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(options.sessions);
+        for(uint32_t i = 0; i < options.sessions; i++){
+            threads.emplace_back([&, i](){
+                J_PROFILE_THREAD("Session");
+                try{
+                    results[i] = RunSession(options, scene);
+                }
+                catch(...){
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for(auto& thread : threads){
+            thread.join();
+        }
+        for(auto& error : errors){
+            if(error){
+                std::rethrow_exception(error);
+            }
+        }
+    }
+    double totalSeconds = 0.0;
+    double framesPerSecond = 0.0;
+    uint64_t heapAllocations = 0;
+    for(const auto& result : results){
+        totalSeconds = std::max(totalSeconds, result.seconds);
+        framesPerSecond += result.seconds > 0.0 ? options.frames / result.seconds : 0.0;
+        heapAllocations += result.heapAllocations;
+    }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(4);
+    json << "{\n";
+    json << "    \"device\": ";
+    WriteJsonString(json, results[0].deviceName);
+    json << ",\n";
+    json << "    \"width\": " << options.width << ",\n";
+    json << "    \"height\": " << options.height << ",\n";
+    json << "    \"objects\": " << options.scene.objectCount << ",\n";
+    json << "    \"textures\": " << options.scene.textureCount << ",\n";
+    json << "    \"materials\": " << options.scene.materialCount << ",\n";
+    json << "    \"meshes\": " << options.scene.meshCount << ",\n";
+    json << "    \"groups\": " << options.scene.groupCount << ",\n";
+    if(!options.meshPath.empty()){
+        json << "    \"mesh\": {\"path\": ";
+        WriteJsonString(json, options.meshPath);
+        json << ", \"acmrBefore\": " << meshStats.acmrBefore
+            << ", \"acmrAfter\": " << meshStats.acmrAfter << ", \"overdrawClusters\": " << meshStats.clusters << "},\n";
+    }
+    json << "    \"moveGroups\": " << (options.moveGroups ? "true" : "false") << ",\n";
+    json << "    \"renderThread\": " << (options.renderThread ? "true" : "false") << ",\n";
+    json << "    \"framePackets\": " << (options.renderThread ? std::min(std::max(options.framePackets, 2u), MAX_FRAME_PACKETS) : 1u) << ",\n";
+    json << "    \"vertexFormat\": \"" << ProjectJ::ToString(options.vertexEncoding) << "\",\n";
+    json << "    \"instancing\": " << (options.enableInstancing ? "true" : "false") << ",\n";
+    json << "    \"frustumCulling\": " << (options.enableFrustumCulling ? "true" : "false") << ",\n";
+    json << "    \"gpuCulling\": " << (options.enableGPUCulling ? "true" : "false") << ",\n";
+    json << "    \"depth\": " << (options.enableDepth || options.enableDepthPrepass || options.enableOcclusionCulling ? "true" : "false") << ",\n";
+    json << "    \"reverseZ\": " << (options.reverseZ ? "true" : "false") << ",\n";
+    json << "    \"depthPrepass\": " << (options.enableDepthPrepass ? "true" : "false") << ",\n";
+    json << "    \"occlusionCulling\": " << (options.enableOcclusionCulling ? "true" : "false") << ",\n";
+    json << "    \"lod\": " << (options.enableLod ? "true" : "false") << ",\n";
+    json << "    \"lodPixelError\": " << options.lodPixelError << ",\n";
+    json << "    \"lodFrameBudgetMs\": " << options.lodFrameBudgetMs << ",\n";
+    json << "    \"frames\": " << options.frames << ",\n";
+    json << "    \"sessions\": " << options.sessions << ",\n";
+    json << "    \"totalSeconds\": " << totalSeconds << ",\n";
+    // summed over sessions.
+    json << "    \"framesPerSecond\": " << framesPerSecond << ",\n";
+    // concurrent sessions see each other's, with warm-ups overlapping measured frames.
+    json << "    \"heapAllocationsPerFrame\": " << heapAllocations / double(options.frames * options.sessions) << ",\n";
+    json << "    \"gpuTimingSupported\": " << (results[0].gpuTimingSupported ? "true" : "false") << ",\n";
+#if defined(J_RHI_NULL)
+    // what one session's last frame would have submitted, and what its Init would have created.
+    const NullRHIStats& calls = results[0].nullStats;
+    json << "    \"nullPerFrame\": {\"transformUpdates\": " << calls.transformUpdates << ", \"visibleObjects\": " << calls.visibleObjects << ", \"coarseLodObjects\": " << calls.coarseLodObjects
+        << ", \"computeDispatches\": " << calls.computeDispatches
+        << ", \"draws\": " << calls.drawCalls << ", \"descriptorSetBinds\": " << calls.descriptorSetBinds
+        << ", \"vertexBufferBinds\": " << calls.vertexBufferBinds
+        << ", \"indices\": " << calls.indices << ", \"uniformBytes\": " << calls.uniformBytes
+        << ", \"readbackBytes\": " << calls.readbackBytes << ", \"frameArenaBytes\": " << calls.frameArenaBytes << "},\n";
+    json << "    \"nullCreated\": {\"buffers\": " << calls.bufferCreations << ", \"textures\": " << calls.textureCreations
+        << ", \"descriptorSets\": " << calls.descriptorSetAllocations << ", \"descriptorWrites\": " << calls.descriptorWrites
+        << ", \"descriptorUpdates\": " << calls.descriptorUpdates
+        << ", \"uploadBytes\": " << calls.uploadBytes << ", \"hostBytes\": " << calls.hostBytes << "},\n";
+#endif
+    WriteStats(json, "cpuFrameMs", results, &SessionResult::cpuFrameMs);
+    WriteStats(json, "gpuMs", results, &SessionResult::gpuMs);
+    WriteStats(json, "fenceWaitMs", results, &SessionResult::fenceWaitMs);
+    WriteStats(json, "drawsPerSecond", results, &SessionResult::drawsPerSecond, true);
+    json << "}\n";
+
+    if(options.outputPath.empty()){
+        std::cout << json.str();
+    }
+    else{
+        std::ofstream out(options.outputPath);
+        out << json.str();
+        JLOG_INFO("wrote benchmark results to {}", options.outputPath);
+    }
+    int exitCode = 0;
+    if(options.requireNoAllocations && heapAllocations > 0){
+        JLOG_WARN("{} heap allocations during the measured frames, expected none.", heapAllocations);
+        exitCode = 1;
+    }
+    Logger::Shutdown();
+    return exitCode;
+}
@@ -0,0 +1,13 @@
+#version 450
+// Fragment shader of TestShader: the material texture, which the software
+// rasterizer samples the same way; the vertex color is passed through unused.
+layout(set = 0, binding = 1) uniform sampler2D texSampler;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main(){
+    outColor = texture(texSampler, fragTexCoord);
+}
@@ -0,0 +1,12 @@
+#version 450
+// frag.frag for InstancedShader, whose texture comes after the instance buffer.
+layout(set = 0, binding = 2) uniform sampler2D texSampler;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main(){
+    outColor = texture(texSampler, fragTexCoord);
+}
@@ -0,0 +1,24 @@
+#version 450
+// Per-object vertex shader of TestShader: model, view and projection from the object's slice of the
+// dynamic uniform buffer. gl_Position is invariant, vert_depth.vert computes it the same way.
+layout(set = 0, binding = 0) uniform UniformBufferObject{
+    // with packed positions the dequantization is folded in, see ApplyPositionDequantize.
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+invariant gl_Position;
+
+void main(){
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+}
@@ -0,0 +1,16 @@
+#version 450
+// Depth pre-pass version of vert.vert: the same set, only the position input and the same, invariant,
+// gl_Position, so the main pass' EQUAL test passes exactly where this one wrote.
+layout(set = 0, binding = 0) uniform UniformBufferObject{
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main(){
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+}
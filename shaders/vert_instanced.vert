@@ -0,0 +1,24 @@
+#version 450
+// Vertex shader of InstancedShader: view and projection once per frame, the model matrix per instance,
+// written by the CPU or the GPU culling passes. gl_Position is invariant like in vert.vert.
+layout(set = 0, binding = 0) uniform ViewUniformBufferObject{
+    mat4 view;
+    mat4 proj;
+} viewUbo;
+// InstanceData, with packed positions the dequantization is folded in.
+layout(set = 0, binding = 1, std430) readonly buffer Instances{ mat4 instances[]; };
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+invariant gl_Position;
+
+void main(){
+    gl_Position = viewUbo.proj * viewUbo.view * instances[gl_InstanceIndex] * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+}
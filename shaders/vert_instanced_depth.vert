@@ -0,0 +1,15 @@
+#version 450
+// Depth pre-pass version of vert_instanced.vert, see vert_depth.vert.
+layout(set = 0, binding = 0) uniform ViewUniformBufferObject{
+    mat4 view;
+    mat4 proj;
+} viewUbo;
+layout(set = 0, binding = 1, std430) readonly buffer Instances{ mat4 instances[]; };
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main(){
+    gl_Position = viewUbo.proj * viewUbo.view * instances[gl_InstanceIndex] * vec4(inPosition, 1.0);
+}
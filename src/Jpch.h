@@ -3,6 +3,9 @@
 #include <memory>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <stdexcept>
 #include <algorithm>
 #include <functional>
 #include <utility>
@@ -20,4 +23,5 @@
 #include <optional>
 
 #include "core/Logger.h"
+#include "core/Profiler.h"
 #include "core/RHI.h"
\ No newline at end of file
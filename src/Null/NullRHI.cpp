@@ -0,0 +1,447 @@
+#include <Jpch.h>
+#include "NullRHI.h"
+#include "core/Image.h"
+
+namespace ProjectJ{
+    NullRHI::NullRHI(const NullConfig& config)
+        :mConfig(config){
+    }
+    NullRHI::~NullRHI(){
+        if(mInitialized){
+            Cleanup();
+        }
+    }
+    void NullRHI::Init(){
+        J_PROFILE_FUNCTION();
+        mDeviceName = "Null device";
+        JLOG_INFO("rendering with {}, no GPU work is done.", mDeviceName);
+
+        Scene defaultScene;
+        if(mConfig.scene == nullptr){
+            defaultScene = CreateDefaultScene();
+        }
+        const Scene& scene = mConfig.scene ? *mConfig.scene : defaultScene;
+        mMeshPool = MeshPool(mConfig.vertexEncoding);
+        mGPUCulling = mConfig.enableGPUCulling && mConfig.enableInstancing;
+        bool lod = mConfig.enableLod && mConfig.enableInstancing && !mGPUCulling;
+        if(mConfig.enableLod && !lod){
+            JLOG_WARN("LOD selection needs instancing and no GPU culling, every object draws its full mesh.");
+        }
+        std::vector<LodChain> lodChains;
+        AddSceneMeshes(scene, mMeshPool, lod ? &lodChains : nullptr);
+        mMaterials = scene.materials;
+        mObjects = scene.objects;
+        std::vector<uint32_t> sceneOrder = SortObjectsForDrawing(mObjects, mMeshPool);
+        mSceneGraph.Build(scene.nodes, mObjects, sceneOrder);
+        mSceneGraph.Update();
+        for(uint32_t i = 0; i < static_cast<uint32_t>(mObjects.size()); i++){
+            mObjects[i].model = mSceneGraph.GetObjectWorld(i);
+        }
+        if(lod){
+            mLod = std::make_unique<LodSelector>(mConfig.lodPixelError);
+            mLod->Init(mObjects, mMeshPool, std::move(lodChains));
+        }
+        if(mConfig.enableInstancing){
+            mDrawBatches = BuildDrawBatches(mObjects);
+            if(mLod){
+                mLodBatches.Init(mDrawBatches, *mLod, mMeshPool);
+                mDrawBatches = mLodBatches.GetBatches();
+            }
+        }
+        if(mConfig.enableGPUCulling && !mConfig.enableInstancing){
+            JLOG_WARN("GPU culling needs instancing, every object is drawn.");
+        }
+        if(mConfig.enableOcclusionCulling){
+            if(mGPUCulling){
+                // VulkanRHI's pyramid: half the target rounded up, halved down to 1x1.
+                uint32_t width = mConfig.width;
+                uint32_t height = mConfig.height;
+                do{
+                    width = std::max(1u, (width + 1) / 2);
+                    height = std::max(1u, (height + 1) / 2);
+                    mDepthPyramidLevels++;
+                } while(width > 1 || height > 1);
+            }
+            else{
+                JLOG_WARN("occlusion culling needs GPU culling, only the frustum is tested.");
+            }
+        }
+        if(mConfig.enableFrustumCulling && !mGPUCulling){
+            if(mConfig.enableInstancing){
+                ComputeObjectBounds(mObjects, mMeshPool, mBounds);
+                mCuller = std::make_unique<FrustumCuller>();
+            }
+            else{
+                JLOG_WARN("frustum culling needs instancing, every object is drawn.");
+            }
+        }
+        PCreateBuffers();
+        PCreateTextures(scene);
+        if(mConfig.enableDepth || mConfig.enableDepthPrepass || mConfig.enableOcclusionCulling){
+            // the render target pool's depth image, shared by every framebuffer.
+            mStats.textureCreations++;
+        }
+        PCreateDescriptorSets();
+        if(mConfig.enableReadback){
+            mReadbackPixels.resize(static_cast<size_t>(mConfig.width) * mConfig.height * 4);
+            mStats.bufferCreations += IMAGE_COUNT;
+            mStats.hostBytes += mReadbackPixels.size() * IMAGE_COUNT;
+        }
+        mStartTime = std::chrono::high_resolution_clock::now();
+        mInitialized = true;
+    }
+    void NullRHI::Cleanup(){
+        J_PROFILE_FUNCTION();
+        mInitialized = false;
+        mDrawBatches.clear();
+        mCuller.reset();
+        mLod.reset();
+        mLodBatches = LodDrawBatches();
+        mGPUCulling = false;
+        mCullUniforms.clear();
+        mCullObjects.clear();
+        mCullMovedObjects.Init(0, 0);
+        mDepthPyramidLevels = 0;
+        mLastViewProj = glm::mat4(1.0f);
+        mBounds = BoundingSpheres();
+        mVisible.clear();
+        mDescriptorSets.clear();
+        mObjectBuffers.clear();
+        mReadbackPixels.clear();
+    }
+
+    void NullRHI::Draw(){
+        mFramePacket.frameIndex = mFrameCount;
+        mFramePacket.time = mConfig.fixedTimeStep > 0.0f ? mFrameCount * mConfig.fixedTimeStep
+            : std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - mStartTime).count();
+        Draw(mFramePacket);
+    }
+    void NullRHI::Draw(const FramePacket& packet){
+        J_PROFILE_FUNCTION();
+        mFrameArena.Reset();
+        uint32_t image = static_cast<uint32_t>(mFrameCount % IMAGE_COUNT);
+        {
+            J_PROFILE_SCOPE("UpdateUniformBuffer");
+            auto now = std::chrono::high_resolution_clock::now();
+            if(mLod && mFrameCount > 0){
+                mLod->UpdateBudget(std::chrono::duration<double, std::milli>(now - mLastDrawTime).count(), mConfig.lodFrameBudgetMs);
+            }
+            mLastDrawTime = now;
+            SceneView sceneView = ComputeSceneView(packet.time, mConfig.width / (float) mConfig.height, mConfig.reverseZ);
+            PUpdateTransforms(packet);
+            if(mGPUCulling){
+                // camera and spin for the culling passes, per object only what moved.
+                mStats.uniformBytes = 2 * sizeof(glm::mat4) + sizeof(CullUniforms);
+                auto& objects = mCullObjects[image];
+                const std::vector<uint32_t>& moved = mCullMovedObjects.Get(image);
+                for(uint32_t i : moved){
+                    objects[i].model = mObjects[i].model;
+                    objects[i].bounds = glm::vec4(mBounds.centerX[i], mBounds.centerY[i], mBounds.centerZ[i], mBounds.radius[i]);
+                }
+                mStats.uniformBytes += moved.size() * sizeof(CullObject);
+                mCullMovedObjects.Clear(image);
+                mCullUniforms[image].frustum = ExtractFrustum(sceneView.proj * sceneView.view);
+                mCullUniforms[image].spin = sceneView.spin;
+                mCullUniforms[image].pyramidViewProj = mLastViewProj;
+                mLastViewProj = sceneView.proj * sceneView.view;
+                mStats.visibleObjects = 0;
+            }
+            else{
+                PUpdateObjects(image, sceneView);
+            }
+        }
+        mFrameCount++;
+        PBuildCommands(image);
+        if(mConfig.enableDepthPrepass){
+            // the pre-pass replays the stream with its own pipeline, binding only the position stream per block.
+            mStats.pipelineBinds++;
+            mStats.vertexBufferBinds += mStats.indexBufferBinds;
+            mStats.indexBufferBinds *= 2;
+            mStats.descriptorSetBinds *= 2;
+            mStats.drawCalls *= 2;
+            mStats.indices *= 2;
+        }
+
+        mStats.readbackBytes = 0;
+        if(mReadbackCallback){
+            J_PROFILE_SCOPE("Readback");
+            ReadbackFrame frame{};
+            frame.data = mReadbackPixels.data();
+            frame.width = mConfig.width;
+            frame.height = mConfig.height;
+            frame.rowPitch = mConfig.width * 4;
+            frame.format = VK_FORMAT_R8G8B8A8_SRGB;
+            frame.frameSerial = mFrameCount;
+            mReadbackCallback(frame);
+            mStats.readbackBytes = mReadbackPixels.size();
+        }
+        mStats.frameArenaBytes = mFrameArena.GetUsedBytes();
+        mStats.frames++;
+        if(mConfig.statsLogInterval > 0 && mFrameCount % mConfig.statsLogInterval == 0){
+            PLogStats();
+        }
+    }
+
+    void NullRHI::PUpdateTransforms(const FramePacket& packet){
+        for(const auto& transform : packet.transforms){
+            mSceneGraph.SetLocal(transform.handle, transform.local);
+        }
+        mStats.transformUpdates = mSceneGraph.Update();
+        if(mStats.transformUpdates == 0 || !(mCuller || mLod || mGPUCulling)){
+            return;
+        }
+        // moved objects take their bounds along, GPU culling copies both into each image's objects.
+        const std::vector<uint32_t>& moved = mSceneGraph.GetMovedObjects();
+        for(uint32_t i : moved){
+            mObjects[i].model = mSceneGraph.GetObjectWorld(i);
+        }
+        if(mCuller || mGPUCulling){
+            UpdateObjectBounds(mObjects, moved, mMeshPool, mBounds);
+        }
+        if(mGPUCulling){
+            mCullMovedObjects.Add(moved);
+        }
+        if(mLod){
+            mLod->UpdateBounds(mObjects, mMeshPool, moved);
+        }
+    }
+
+    void NullRHI::PUpdateObjects(uint32_t image, const SceneView& sceneView){
+        uint8_t* objectBuffer = mObjectBuffers[image].data();
+        bool quantizedPositions = mMeshPool.GetVertexEncoding() != VertexEncoding::Float;
+        auto objectModel = [&](size_t i, uint32_t meshIndex){
+            // straight from the graph, mObjects only follows it where bounds need it.
+            glm::mat4 model = mSceneGraph.GetObjectWorld(static_cast<uint32_t>(i)) * sceneView.spin;
+            return quantizedPositions ? ApplyPositionDequantize(model, mMeshPool.GetRange(meshIndex)) : model;
+        };
+        if(mCuller){
+            // mBounds follows moved objects (see PUpdateTransforms) and the spin is about their axis.
+            mCuller->Cull(mBounds, ExtractFrustum(sceneView.proj * sceneView.view), mVisible);
+        }
+        if(mLod){
+            // instances go out bucketed by batch and level, each with its level's dequantization.
+            const std::vector<uint32_t>* visible = mCuller ? &mVisible : nullptr;
+            mLod->Select(sceneView, mConfig.height, visible);
+            mLodBatches.Fill(*mLod, mFrameArena, visible);
+            const std::vector<uint32_t>& instances = mLodBatches.GetInstances();
+            for(size_t b = 0; b < mDrawBatches.size(); b++){
+                for(uint32_t v = mLodBatches.GetFirstInstance(b); v < mLodBatches.GetFirstInstance(b + 1); v++){
+                    *reinterpret_cast<glm::mat4*>(objectBuffer + v * mUniformStride) = objectModel(instances[v], mDrawBatches[b].meshIndex);
+                }
+            }
+        }
+        else if(mCuller){
+            for(size_t v = 0; v < mVisible.size(); v++){
+                *reinterpret_cast<glm::mat4*>(objectBuffer + v * mUniformStride) = objectModel(mVisible[v], mObjects[mVisible[v]].meshIndex);
+            }
+        }
+        else{
+            for(size_t i = 0; i < mObjects.size(); i++){
+                if(mConfig.enableInstancing){
+                    *reinterpret_cast<glm::mat4*>(objectBuffer + i * mUniformStride) = objectModel(i, mObjects[i].meshIndex);
+                    continue;
+                }
+                ObjectUniforms& ubo = *reinterpret_cast<ObjectUniforms*>(objectBuffer + i * mUniformStride);
+                ubo.model = objectModel(i, mObjects[i].meshIndex);
+                ubo.view = sceneView.view;
+                ubo.proj = sceneView.proj;
+            }
+        }
+        mStats.visibleObjects = mCuller ? mVisible.size() : mObjects.size();
+        mStats.coarseLodObjects = mLod ? mLod->GetCoarseObjectCount() : 0;
+        // with instancing view and projection go once per frame.
+        mStats.uniformBytes = mConfig.enableInstancing ? mStats.visibleObjects * sizeof(glm::mat4) + 2 * sizeof(glm::mat4)
+            : mObjects.size() * sizeof(ObjectUniforms);
+    }
+
+    void NullRHI::SetReadbackCallback(ReadbackCallback callback){
+        if(!mConfig.enableReadback){
+            throw std::runtime_error("readback is not enabled.");
+        }
+        mReadbackCallback = std::move(callback);
+    }
+
+    void NullRHI::PCreateBuffers(){
+        for(const auto& block : mMeshPool.GetBlocks()){
+            mStats.bufferCreations += 1 + block.GetVertexStreamCount();
+            mStats.uploadBytes += sizeof(Vertex) * block.vertices.size() + block.indices.size();
+            for(uint32_t stream = 0; stream < block.GetVertexStreamCount(); stream++){
+                mStats.uploadBytes += block.vertexStreams[stream].size();
+            }
+        }
+
+        uint32_t alignment = std::max<uint32_t>(mConfig.uniformAlignment, 1);
+        mUniformStride = (sizeof(ObjectUniforms) + alignment - 1) / alignment * alignment;
+        if(mGPUCulling){
+            // GPUCullBatch uploaded once; per image host visible objects, view and cull uniforms, then device
+            // local instances, batch counters, compacted commands and run counters the CPU never touches.
+            mStats.bufferCreations += 1 + IMAGE_COUNT * 7;
+            mStats.uploadBytes += mDrawBatches.size() * 8 * sizeof(uint32_t);
+            mStats.hostBytes += IMAGE_COUNT * (2 * alignment + std::max<size_t>(mObjects.size(), 1) * sizeof(CullObject));
+            ComputeObjectBounds(mObjects, mMeshPool, mBounds);
+            mCullObjects.assign(IMAGE_COUNT, std::vector<CullObject>(mObjects.size()));
+            for(auto& objects : mCullObjects){
+                for(size_t b = 0; b < mDrawBatches.size(); b++){
+                    const DrawBatch& batch = mDrawBatches[b];
+                    const MeshRange& range = mMeshPool.GetRange(batch.meshIndex);
+                    for(uint32_t i = batch.firstObject; i < batch.firstObject + batch.objectCount; i++){
+                        objects[i].model = mObjects[i].model;
+                        objects[i].bounds = glm::vec4(mBounds.centerX[i], mBounds.centerY[i], mBounds.centerZ[i], mBounds.radius[i]);
+                        objects[i].positionOffsetBatch = glm::vec4(range.positionOffset, static_cast<float>(b));
+                        objects[i].positionScale = glm::vec4(range.positionScale, 0.0f);
+                    }
+                }
+            }
+            mCullMovedObjects.Init(IMAGE_COUNT, static_cast<uint32_t>(mObjects.size()));
+            if(mDepthPyramidLevels > 0){
+                // the depth pyramid, shared by every image.
+                mStats.bufferCreations++;
+            }
+            mCullUniforms.resize(IMAGE_COUNT);
+            return;
+        }
+        if(mConfig.enableInstancing){
+            // storage buffer elements are tightly packed; a view uniform and an indirect buffer per image on top.
+            mUniformStride = sizeof(glm::mat4);
+            mStats.bufferCreations += IMAGE_COUNT * 2;
+            mStats.hostBytes += IMAGE_COUNT * (alignment + mDrawBatches.size() * sizeof(DrawCommand));
+        }
+        mObjectBuffers.resize(IMAGE_COUNT);
+        for(auto& buffer : mObjectBuffers){
+            buffer.resize(std::max<size_t>(mObjects.size(), 1) * mUniformStride);
+            mStats.bufferCreations++;
+            mStats.hostBytes += buffer.size();
+        }
+    }
+    void NullRHI::PCreateTextures(const Scene& scene){
+        J_PROFILE_FUNCTION();
+        // decoding is engine work, the upload is not; files decode in parallel.
+        std::vector<uint64_t> textureBytes(scene.textures.size());
+        JobSystem::Get().ParallelFor(static_cast<uint32_t>(scene.textures.size()), [&](uint32_t i){
+            const SceneTexture& texture = scene.textures[i];
+            if(!texture.path.empty()){
+                DecodedImage image = DecodeImage(texture.path);
+                textureBytes[i] = static_cast<uint64_t>(image.width) * image.height * 4;
+            }
+            else{
+                textureBytes[i] = static_cast<uint64_t>(texture.width) * texture.height * 4;
+            }
+        });
+        for(uint64_t bytes : textureBytes){
+            mStats.uploadBytes += bytes;
+            mStats.textureCreations++;
+        }
+    }
+    void NullRHI::PCreateDescriptorSets(){
+        size_t materialCount = mMaterials.size();
+        if(materialCount == 0 && !mObjects.empty()){
+            throw std::runtime_error("scene objects need at least one material.");
+        }
+        mDescriptorSets.resize(IMAGE_COUNT * materialCount);
+        for(size_t i = 0; i < mDescriptorSets.size(); i++){
+            mDescriptorSets[i] = mMaterials[i % materialCount].textureIndex;
+        }
+        mStats.descriptorSetAllocations += mDescriptorSets.size();
+        mStats.descriptorUpdates += mDescriptorSets.size();
+        // a dynamic uniform buffer and a combined image sampler per set, and the instance buffer with instancing.
+        mStats.descriptorWrites += mDescriptorSets.size() * (mConfig.enableInstancing ? 3 : 2);
+        if(mGPUCulling){
+            // one set per image over the cull uniform and the seven storage buffers.
+            mStats.descriptorSetAllocations += IMAGE_COUNT;
+            mStats.descriptorUpdates += IMAGE_COUNT;
+            mStats.descriptorWrites += IMAGE_COUNT * 8;
+        }
+        if(mDepthPyramidLevels > 0){
+            // the pyramid pass' depth sampler and pyramid buffer.
+            mStats.descriptorSetAllocations++;
+            mStats.descriptorUpdates++;
+            mStats.descriptorWrites += 2;
+        }
+    }
+    void NullRHI::PBuildCommands(uint32_t image){
+        J_PROFILE_FUNCTION();
+        // the stream VulkanRHI records into each image's command buffer.
+        DrawCommand* commands = mFrameArena.Allocate<DrawCommand>(mConfig.enableInstancing ? mDrawBatches.size() : mObjects.size());
+        uint32_t commandCount = 0;
+        mStats.pipelineBinds = 1;
+        mStats.vertexBufferBinds = 0;
+        mStats.indexBufferBinds = 0;
+        mStats.descriptorSetBinds = 0;
+        mStats.drawCalls = 0;
+        mStats.computeDispatches = mGPUCulling ? 2 + mDepthPyramidLevels : 0;
+        mStats.indices = 0;
+        uint32_t boundBlock = UINT32_MAX;
+        uint32_t boundMaterial = UINT32_MAX;
+        auto bindBlock = [&](uint32_t block){
+            if(block != boundBlock){
+                boundBlock = block;
+                boundMaterial = UINT32_MAX;
+                mStats.vertexBufferBinds += mMeshPool.GetBlocks()[boundBlock].GetVertexStreamCount();
+                mStats.indexBufferBinds++;
+            }
+        };
+        if(mConfig.enableInstancing){
+            // the indirect buffer, one command per batch; runs sharing block and material are one multi-draw.
+            // culled batches keep their command with fewer, possibly zero, instances.
+            size_t nextVisible = 0;
+            for(size_t b = 0; b < mDrawBatches.size(); b++){
+                const DrawBatch& batch = mDrawBatches[b];
+                const MeshRange& range = mMeshPool.GetRange(batch.meshIndex);
+                bindBlock(range.block);
+                if(batch.materialIndex != boundMaterial){
+                    boundMaterial = batch.materialIndex;
+                    mStats.descriptorSetBinds++;
+                    mStats.drawCalls++;
+                }
+                if(mGPUCulling){
+                    // the commands are written by the compaction pass.
+                    continue;
+                }
+                DrawCommand command{};
+                command.descriptorSet = static_cast<uint32_t>(image * mMaterials.size() + batch.materialIndex);
+                command.indexCount = range.indexCount;
+                command.instanceCount = batch.objectCount;
+                command.firstIndex = range.firstIndex;
+                command.vertexOffset = range.vertexOffset;
+                command.firstInstance = batch.firstObject;
+                if(mLod){
+                    command.firstInstance = mLodBatches.GetFirstInstance(b);
+                    command.instanceCount = mLodBatches.GetInstanceCount(b);
+                }
+                else if(mCuller){
+                    // visible indices ascend, a batch's survivors are one run of them.
+                    command.firstInstance = static_cast<uint32_t>(nextVisible);
+                    uint32_t batchEnd = batch.firstObject + batch.objectCount;
+                    while(nextVisible < mVisible.size() && mVisible[nextVisible] < batchEnd){
+                        nextVisible++;
+                    }
+                    command.instanceCount = static_cast<uint32_t>(nextVisible) - command.firstInstance;
+                }
+                commands[commandCount++] = command;
+                mStats.indices += static_cast<uint64_t>(range.indexCount) * command.instanceCount;
+            }
+            return;
+        }
+        for(size_t i = 0; i < mObjects.size(); i++){
+            const MeshRange& range = mMeshPool.GetRange(mObjects[i].meshIndex);
+            bindBlock(range.block);
+            DrawCommand command{};
+            command.descriptorSet = static_cast<uint32_t>(image * mMaterials.size() + mObjects[i].materialIndex);
+            command.dynamicOffset = static_cast<uint32_t>(i * mUniformStride);
+            command.indexCount = range.indexCount;
+            command.instanceCount = 1;
+            command.firstIndex = range.firstIndex;
+            command.vertexOffset = range.vertexOffset;
+            commands[commandCount++] = command;
+            mStats.indices += range.indexCount;
+        }
+        mStats.descriptorSetBinds = commandCount;
+        mStats.drawCalls = commandCount;
+    }
+    void NullRHI::PLogStats() const{
+        JLOG_REPORT("null: {} transform updates, {} visible objects, {} on coarser LODs (bias {:.2f}), {} dispatches, {} draws, {} set binds, {} vertex buffer binds, {} indices, {} uniform bytes, {} readback bytes, {} frame arena bytes per frame",
+            mStats.transformUpdates, mStats.visibleObjects, mStats.coarseLodObjects, GetLodBias(), mStats.computeDispatches, mStats.drawCalls, mStats.descriptorSetBinds, mStats.vertexBufferBinds, mStats.indices, mStats.uniformBytes, mStats.readbackBytes, mStats.frameArenaBytes);
+        JLOG_REPORT("null: {} buffers, {} textures, {} descriptor sets ({} descriptors in {} templated updates), {} upload bytes, {} host bytes created",
+            mStats.bufferCreations, mStats.textureCreations, mStats.descriptorSetAllocations, mStats.descriptorWrites, mStats.descriptorUpdates, mStats.uploadBytes, mStats.hostBytes);
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "core/FrameArena.h"
+#include "core/FramePacket.h"
+#include "core/Mesh.h"
+#include "core/PlatformInclude.h"
+#include "core/Readback.h"
+#include "core/RenderConfig.h"
+#include "core/Scene.h"
+#include "core/Lod.h"
+#include "core/SceneGraph.h"
+#include "core/Visibility.h"
+#include <chrono>
+
+namespace ProjectJ{
+    // Takes every shared option like VulkanRHI, nothing is presented and readback hands over zeroed
+    // pixels. GPU culling is modelled as no per-object CPU work and one count-driven draw per run, the
+    // depth pre-pass as the draw stream recorded a second time with position only binds.
+    struct NullConfig : RenderConfig{
+        NullConfig(){
+            headless = true;
+        }
+        // what minUniformBufferOffsetAlignment would report, pads the per-object uniform stride.
+        uint32_t uniformAlignment = 256;
+    };
+
+    // Calls the null backend accepted. Creation counters accumulate from Init, the per-frame ones
+    // hold the last Draw only.
+    struct NullRHIStats{
+        uint64_t bufferCreations = 0;
+        uint64_t textureCreations = 0;
+        uint64_t descriptorSetAllocations = 0;
+        // descriptors written, and the vkUpdateDescriptorSetWithTemplate calls writing them, one per set.
+        uint64_t descriptorWrites = 0;
+        uint64_t descriptorUpdates = 0;
+        // vertex, index and texel bytes that would have gone through staging.
+        uint64_t uploadBytes = 0;
+        // host visible memory that would be allocated, uniform and readback buffers.
+        uint64_t hostBytes = 0;
+
+        uint64_t frames = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t vertexBufferBinds = 0;
+        uint32_t indexBufferBinds = 0;
+        uint32_t descriptorSetBinds = 0;
+        // with a depth pre-pass these count both passes.
+        uint32_t drawCalls = 0;
+        uint32_t computeDispatches = 0;
+        // 0 with GPU culling, the counts are only known on the GPU.
+        uint64_t indices = 0;
+        // objects that passed frustum culling, all of them without it, 0 with GPU culling.
+        uint64_t visibleObjects = 0;
+        // visible objects drawn with a coarser level than their full mesh.
+        uint64_t coarseLodObjects = 0;
+        // scene graph nodes whose world matrix was recomputed, 0 while nothing moves.
+        uint64_t transformUpdates = 0;
+        uint64_t uniformBytes = 0;
+        uint64_t readbackBytes = 0;
+        // scratch the frame took from its frame arena.
+        uint64_t frameArenaBytes = 0;
+    };
+
+    // Backend that does everything VulkanRHI does on the CPU — scene update, per-object uniform
+    // writes into aligned dynamic buffers, descriptor set bookkeeping, command stream building — and
+    // nothing on a GPU. Engine-side cost can then be measured on any machine without driver noise.
+    class NullRHI{
+    public:
+        NullRHI(const NullConfig& config);
+        // cleans up if still initialized.
+        ~NullRHI();
+        NullRHI(const NullRHI&) = delete;
+        NullRHI& operator=(const NullRHI&) = delete;
+        // animates by the backend's own clock, or fixedTimeStep.
+        void Draw();
+        // renders what the simulation decided for the frame: its time and scene graph changes.
+        void Draw(const FramePacket& packet);
+        void SetReadbackCallback(ReadbackCallback callback);
+        uint32_t GetDrawCallCount() const {return static_cast<uint32_t>(mObjects.size());}
+        const std::string& GetDeviceName() const {return mDeviceName;}
+        // backend neutral frame timings, there is no GPU to time or wait on.
+        bool IsGPUTimingSupported() const {return false;}
+        double GetLastGPUFrameMs() const {return 0.0;}
+        uint64_t GetGPUFrameSampleCount() const {return 0;}
+        double GetLastFrameWaitMs() const {return 0.0;}
+        const NullRHIStats& GetStats() const {return mStats;}
+        // global LOD bias, see LodSelector::SetBias; no effect without enableLod.
+        void SetLodBias(float bias) {if(mLod) mLod->SetBias(bias);}
+        float GetLodBias() const {return mLod ? mLod->GetBias() : 0.0f;}
+        // the scene's transform hierarchy, nodes set here move their objects from the next Draw on.
+        SceneGraph& GetSceneGraph() {return mSceneGraph;}
+    public:
+        void Init();
+        void Cleanup();
+    private:
+        // layout of UniformBufferObject.
+        struct ObjectUniforms{
+            glm::mat4 model;
+            glm::mat4 view;
+            glm::mat4 proj;
+        };
+        // what vkCmdBindDescriptorSets + vkCmdDrawIndexed would receive, or with instancing one
+        // VkDrawIndexedIndirectCommand of the indirect buffer.
+        struct DrawCommand{
+            uint32_t descriptorSet;
+            uint32_t dynamicOffset;
+            uint32_t indexCount;
+            uint32_t instanceCount;
+            uint32_t firstIndex;
+            int32_t vertexOffset;
+            uint32_t firstInstance;
+        };
+        // CullUniformBufferObject without the counts.
+        struct CullUniforms{
+            Frustum frustum;
+            glm::mat4 spin;
+            glm::mat4 pyramidViewProj;
+        };
+        // layout of GPUCullObject, model and bounds rewritten when objects move.
+        struct CullObject{
+            glm::mat4 model;
+            glm::vec4 bounds;
+            glm::vec4 positionOffsetBatch;
+            glm::vec4 positionScale;
+        };
+
+        // applies the packet's transforms and propagates them, into the CPU side bounds of the objects that
+        // moved, and queues those for every image's culling objects.
+        void PUpdateTransforms(const FramePacket& packet);
+        // model matrices (and view, projection without instancing) of this frame's objects.
+        void PUpdateObjects(uint32_t image, const SceneView& sceneView);
+        void PCreateBuffers();
+        void PCreateTextures(const Scene& scene);
+        void PCreateDescriptorSets();
+        void PBuildCommands(uint32_t image);
+        void PLogStats() const;
+    private:
+        // as many as the offscreen swap chain has images.
+        static constexpr uint32_t IMAGE_COUNT = 3;
+
+        NullConfig mConfig;
+        std::string mDeviceName;
+        NullRHIStats mStats;
+        MeshPool mMeshPool;
+        std::vector<SceneMaterial> mMaterials;
+        // sorted for drawing, model in world space; the graph holds the local transforms.
+        std::vector<SceneObject> mObjects;
+        SceneGraph mSceneGraph;
+        uint32_t mUniformStride = 0;
+        // one per image, mUniformStride bytes per object; just the model matrix with instancing.
+        std::vector<std::vector<uint8_t> > mObjectBuffers;
+        // [image * material count + material], the texture each set points at.
+        std::vector<uint32_t> mDescriptorSets;
+        // reset at the start of every Draw, this frame's command stream and other scratch live here.
+        FrameArena mFrameArena;
+        // what Draw() hands to Draw(const FramePacket&), reused.
+        FramePacket mFramePacket;
+        std::vector<DrawBatch> mDrawBatches;
+        // with frustum culling, object bounds and this frame's visible objects in instance order.
+        BoundingSpheres mBounds;
+        std::unique_ptr<FrustumCuller> mCuller;
+        std::vector<uint32_t> mVisible;
+        // with LODs mDrawBatches are mLodBatches' per level batches.
+        std::unique_ptr<LodSelector> mLod;
+        LodDrawBatches mLodBatches;
+        std::chrono::high_resolution_clock::time_point mLastDrawTime;
+        bool mGPUCulling = false;
+        std::vector<CullUniforms> mCullUniforms;
+        // one per image, and by image the objects moved since it was last written.
+        std::vector<std::vector<CullObject> > mCullObjects;
+        MovedObjectQueues mCullMovedObjects;
+        // with occlusion culling, one pyramid dispatch per level; 0 without.
+        uint32_t mDepthPyramidLevels = 0;
+        glm::mat4 mLastViewProj{1.0f};
+        std::vector<uint8_t> mReadbackPixels;
+        ReadbackCallback mReadbackCallback;
+        bool mInitialized = false;
+        std::chrono::high_resolution_clock::time_point mStartTime;
+        uint64_t mFrameCount = 0;
+    };
+}
@@ -0,0 +1,165 @@
+#include <Jpch.h>
+#include "SoftwareRHI.h"
+#include "core/Image.h"
+
+namespace ProjectJ{
+    SoftwareRHI::SoftwareRHI(const SoftwareConfig& config)
+        :mConfig(config){
+    }
+    SoftwareRHI::~SoftwareRHI(){
+        if(mInitialized){
+            Cleanup();
+        }
+    }
+    void SoftwareRHI::Init(){
+        J_PROFILE_FUNCTION();
+        if(!mConfig.headless){
+            JLOG_WARN("the software backend does not present, frames are only rendered offscreen.");
+        }
+        SoftwareDepthTest depthTest = SoftwareDepthTest::None;
+        if(mConfig.enableDepth || mConfig.enableDepthPrepass){
+            depthTest = mConfig.reverseZ ? SoftwareDepthTest::Greater : SoftwareDepthTest::Less;
+        }
+        mRasterizer = std::make_unique<SoftwareRasterizer>(mConfig.width, mConfig.height, mConfig.threadCount, mConfig.tileSize, depthTest);
+#ifdef J_SOFTWARE_SSE2
+        const char* simd = "SSE2";
+#else
+        const char* simd = "scalar";
+#endif
+        mDeviceName = "Software rasterizer (" + std::to_string(mRasterizer->GetThreadCount()) + " threads, " + simd + ")";
+        JLOG_INFO("rendering with {}", mDeviceName);
+
+        Scene defaultScene;
+        if(mConfig.scene == nullptr){
+            defaultScene = CreateDefaultScene();
+        }
+        const Scene& scene = mConfig.scene ? *mConfig.scene : defaultScene;
+        std::vector<LodChain> lodChains;
+        AddSceneMeshes(scene, mMeshPool, mConfig.enableLod ? &lodChains : nullptr);
+        PCreateTextures(scene);
+        mObjects = scene.objects;
+        // same order the Vulkan backend records its draws in, which decides overlaps without a depth test.
+        std::vector<uint32_t> sceneOrder = SortObjectsForDrawing(mObjects, mMeshPool);
+        mSceneGraph.Build(scene.nodes, mObjects, sceneOrder);
+        mSceneGraph.Update();
+        for(uint32_t i = 0; i < static_cast<uint32_t>(mObjects.size()); i++){
+            mObjects[i].model = mSceneGraph.GetObjectWorld(i);
+        }
+        if(mConfig.enableLod){
+            mLod = std::make_unique<LodSelector>(mConfig.lodPixelError);
+            mLod->Init(mObjects, mMeshPool, std::move(lodChains));
+        }
+        mDrawCalls.resize(mObjects.size());
+        for(size_t i = 0; i < mObjects.size(); i++){
+            SoftwareDrawCall& drawCall = mDrawCalls[i];
+            const MeshRange& range = mMeshPool.GetRange(mObjects[i].meshIndex);
+            drawCall.mesh = &mMeshPool.GetBlocks()[range.block];
+            drawCall.texture = mTextures[scene.materials[mObjects[i].materialIndex].textureIndex].get();
+            drawCall.indexCount = range.indexCount;
+            drawCall.firstIndex = range.firstIndex;
+            drawCall.vertexOffset = range.vertexOffset;
+        }
+        mStartTime = std::chrono::high_resolution_clock::now();
+        mInitialized = true;
+    }
+    void SoftwareRHI::Cleanup(){
+        J_PROFILE_FUNCTION();
+        mInitialized = false;
+        mDrawCalls.clear();
+        mLod.reset();
+        mTextures.clear();
+        mRasterizer.reset();
+    }
+
+    void SoftwareRHI::Draw(){
+        mFramePacket.frameIndex = mFrameCount;
+        mFramePacket.time = mConfig.fixedTimeStep > 0.0f ? mFrameCount * mConfig.fixedTimeStep
+            : std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - mStartTime).count();
+        Draw(mFramePacket);
+    }
+    void SoftwareRHI::Draw(const FramePacket& packet){
+        J_PROFILE_FUNCTION();
+        {
+            J_PROFILE_SCOPE("UpdateUniformBuffer");
+            auto now = std::chrono::high_resolution_clock::now();
+            if(mLod && mFrameCount > 0){
+                mLod->UpdateBudget(std::chrono::duration<double, std::milli>(now - mLastDrawTime).count(), mConfig.lodFrameBudgetMs);
+            }
+            mLastDrawTime = now;
+            SceneView sceneView = ComputeSceneView(packet.time, mConfig.width / (float) mConfig.height, mConfig.reverseZ);
+            glm::mat4 viewProj = sceneView.proj * sceneView.view;
+            for(const auto& transform : packet.transforms){
+                mSceneGraph.SetLocal(transform.handle, transform.local);
+            }
+            if(mSceneGraph.Update() > 0 && mLod){
+                // moved objects take their LOD bounds along.
+                const std::vector<uint32_t>& moved = mSceneGraph.GetMovedObjects();
+                for(uint32_t i : moved){
+                    mObjects[i].model = mSceneGraph.GetObjectWorld(i);
+                }
+                mLod->UpdateBounds(mObjects, mMeshPool, moved);
+            }
+            if(mLod){
+                mLod->Select(sceneView, mConfig.height);
+            }
+            for(size_t i = 0; i < mObjects.size(); i++){
+                mDrawCalls[i].mvp = viewProj * mSceneGraph.GetObjectWorld(static_cast<uint32_t>(i)) * sceneView.spin;
+                if(mLod){
+                    const MeshRange& range = mMeshPool.GetRange(mLod->GetMesh(static_cast<uint32_t>(i)));
+                    mDrawCalls[i].mesh = &mMeshPool.GetBlocks()[range.block];
+                    mDrawCalls[i].indexCount = range.indexCount;
+                    mDrawCalls[i].firstIndex = range.firstIndex;
+                    mDrawCalls[i].vertexOffset = range.vertexOffset;
+                }
+            }
+        }
+        mFrameCount++;
+        // opaque black, the Vulkan render pass clear color.
+        mRasterizer->Render(mDrawCalls, 0xff000000u);
+
+        if(mReadbackCallback){
+            J_PROFILE_SCOPE("Readback");
+            ReadbackFrame frame{};
+            frame.data = mRasterizer->GetColor();
+            frame.width = mRasterizer->GetWidth();
+            frame.height = mRasterizer->GetHeight();
+            frame.rowPitch = mRasterizer->GetRowPitch();
+            frame.format = VK_FORMAT_R8G8B8A8_SRGB;
+            frame.frameSerial = mFrameCount;
+            mReadbackCallback(frame);
+        }
+        if(mConfig.statsLogInterval > 0 && mFrameCount % mConfig.statsLogInterval == 0){
+            const auto& stats = mRasterizer->GetStats();
+            JLOG_REPORT("software: geometry {:.3f} ms, raster {:.3f} ms, {} of {} triangles set up, {} tile bin entries",
+                stats.geometryMs, stats.rasterMs, stats.trianglesSetUp, stats.trianglesSubmitted, stats.binnedReferences);
+        }
+    }
+
+    double SoftwareRHI::GetLastGPUFrameMs() const{
+        const auto& stats = mRasterizer->GetStats();
+        return stats.geometryMs + stats.rasterMs;
+    }
+
+    void SoftwareRHI::SetReadbackCallback(ReadbackCallback callback){
+        if(!mConfig.enableReadback){
+            throw std::runtime_error("readback is not enabled.");
+        }
+        mReadbackCallback = std::move(callback);
+    }
+
+    void SoftwareRHI::PCreateTextures(const Scene& scene){
+        J_PROFILE_FUNCTION();
+        // files decode in parallel, every texture converts on the thread that decoded it.
+        mTextures.resize(scene.textures.size());
+        JobSystem::Get().ParallelFor(static_cast<uint32_t>(scene.textures.size()), [&](uint32_t i){
+            const SceneTexture& texture = scene.textures[i];
+            if(!texture.path.empty()){
+                DecodedImage image = DecodeImage(texture.path);
+                mTextures[i] = std::make_unique<SoftwareTexture>(image.pixels.get(), image.width, image.height);
+            }
+            else{
+                mTextures[i] = std::make_unique<SoftwareTexture>(texture.pixels.data(), texture.width, texture.height);
+            }
+        });
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "SoftwareRasterizer.h"
+#include "core/FramePacket.h"
+#include "core/PlatformInclude.h"
+#include "core/Readback.h"
+#include "core/RenderConfig.h"
+#include "core/Lod.h"
+#include "core/Scene.h"
+#include "core/SceneGraph.h"
+#include <chrono>
+
+namespace ProjectJ{
+    // Of the shared options vertexEncoding is ignored, the rasterizer always reads float vertices;
+    // instancing and frustum culling too, every object is rasterized and clipped on its own anyway; GPU
+    // and occlusion culling as there are no compute passes. enableDepthPrepass only turns on enableDepth,
+    // failing pixels are never shaded. LODs need no instancing, draws are rebuilt every frame.
+    // Frames are always rendered offscreen, there is nothing to present to a window.
+    struct SoftwareConfig : RenderConfig{
+        SoftwareConfig(){
+            headless = true;
+        }
+        // JobSystem threads the rasterizer uses, 0 for all of them.
+        uint32_t threadCount = 0;
+        uint32_t tileSize = 64;
+    };
+
+    // CPU backend drawing the same scene as VulkanRHI: the scene's meshes, per object model * spin, the
+    // shared camera, a bilinear textured fragment. Needs no Vulkan driver and its output is the
+    // same on every machine, which makes it a reference for both correctness and performance.
+    class SoftwareRHI{
+    public:
+        SoftwareRHI(const SoftwareConfig& config);
+        // cleans up if still initialized.
+        ~SoftwareRHI();
+        SoftwareRHI(const SoftwareRHI&) = delete;
+        SoftwareRHI& operator=(const SoftwareRHI&) = delete;
+        // animates by the backend's own clock, or fixedTimeStep.
+        void Draw();
+        // renders what the simulation decided for the frame: its time and scene graph changes.
+        void Draw(const FramePacket& packet);
+        void SetReadbackCallback(ReadbackCallback callback);
+        uint32_t GetDrawCallCount() const {return static_cast<uint32_t>(mDrawCalls.size());}
+        const std::string& GetDeviceName() const {return mDeviceName;}
+        // backend neutral frame timings, the "GPU" is the rasterizer and it is never waited on.
+        bool IsGPUTimingSupported() const {return true;}
+        double GetLastGPUFrameMs() const;
+        // every Draw rasterizes before it returns, so each frame is a new sample.
+        uint64_t GetGPUFrameSampleCount() const {return mFrameCount;}
+        double GetLastFrameWaitMs() const {return 0.0;}
+        SoftwareRasterizer& GetRasterizer() {return *mRasterizer;}
+        // global LOD bias, see LodSelector::SetBias; no effect without enableLod.
+        void SetLodBias(float bias) {if(mLod) mLod->SetBias(bias);}
+        float GetLodBias() const {return mLod ? mLod->GetBias() : 0.0f;}
+        // the scene's transform hierarchy, nodes set here move their objects from the next Draw on.
+        SceneGraph& GetSceneGraph() {return mSceneGraph;}
+    public:
+        void Init();
+        void Cleanup();
+    private:
+        void PCreateTextures(const Scene& scene);
+    private:
+        SoftwareConfig mConfig;
+        std::string mDeviceName;
+        std::unique_ptr<SoftwareRasterizer> mRasterizer;
+        MeshPool mMeshPool;
+        std::vector<std::unique_ptr<SoftwareTexture> > mTextures;
+        // sorted for drawing, model in world space; the graph holds the local transforms.
+        std::vector<SceneObject> mObjects;
+        SceneGraph mSceneGraph;
+        // parallel to mObjects.
+        std::vector<SoftwareDrawCall> mDrawCalls;
+        std::unique_ptr<LodSelector> mLod;
+        std::chrono::high_resolution_clock::time_point mLastDrawTime;
+        ReadbackCallback mReadbackCallback;
+        // what Draw() hands to Draw(const FramePacket&), reused.
+        FramePacket mFramePacket;
+        bool mInitialized = false;
+        std::chrono::high_resolution_clock::time_point mStartTime;
+        uint64_t mFrameCount = 0;
+    };
+}
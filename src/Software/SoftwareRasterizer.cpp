@@ -0,0 +1,367 @@
+#include <Jpch.h>
+#include "SoftwareRasterizer.h"
+#include <cmath>
+#include <cstring>
+
+namespace ProjectJ{
+    namespace{
+        struct SrgbTables{
+            float toLinear[256];
+            // indexed by linear * 4095.
+            uint8_t fromLinear[4096];
+            SrgbTables(){
+                for(int i = 0; i < 256; i++){
+                    float c = i / 255.0f;
+                    toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                for(int i = 0; i < 4096; i++){
+                    float l = i / 4095.0f;
+                    float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                    fromLinear[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+                }
+            }
+        };
+        const SrgbTables& GetSrgbTables(){
+            static const SrgbTables tables;
+            return tables;
+        }
+
+        Float4 HDecodeTexel(const SrgbTables& srgb, uint32_t texel){
+            return Float4(srgb.toLinear[texel & 0xff], srgb.toLinear[(texel >> 8) & 0xff],
+                srgb.toLinear[(texel >> 16) & 0xff], (texel >> 24) / 255.0f);
+        }
+        uint32_t HEncodePixel(const SrgbTables& srgb, Float4 color){
+            float c[4];
+            color.Store(c);
+            auto encode = [&srgb](float l){
+                return static_cast<uint32_t>(srgb.fromLinear[static_cast<int>(std::clamp(l, 0.0f, 1.0f) * 4095.0f + 0.5f)]);
+            };
+            uint32_t alpha = static_cast<uint32_t>(std::clamp(c[3], 0.0f, 1.0f) * 255.0f + 0.5f);
+            return encode(c[0]) | (encode(c[1]) << 8) | (encode(c[2]) << 16) | (alpha << 24);
+        }
+        // reduced in float first, casting a huge or NaN coordinate to int is undefined.
+        uint32_t HWrap(float coordinate, uint32_t size){
+            float extent = static_cast<float>(size);
+            float wrapped = coordinate - extent * std::floor(coordinate / extent);
+            if(!(wrapped >= 0.0f)){
+                return 0;
+            }
+            return static_cast<uint32_t>(std::min(wrapped, extent - 1.0f));
+        }
+    }
+
+    //------------------------------------ SoftwareTexture -----------------------------------------//
+    SoftwareTexture::SoftwareTexture(const uint8_t* pixels, uint32_t width, uint32_t height)
+        :mTexels(static_cast<size_t>(width) * height), mWidth(width), mHeight(height){
+        std::memcpy(mTexels.data(), pixels, mTexels.size() * 4);
+    }
+    Float4 SoftwareTexture::SampleBilinear(float u, float v) const{
+        const auto& srgb = GetSrgbTables();
+        float x = u * mWidth - 0.5f;
+        float y = v * mHeight - 0.5f;
+        float fx = std::floor(x);
+        float fy = std::floor(y);
+        uint32_t x0 = HWrap(fx, mWidth);
+        uint32_t y0 = HWrap(fy, mHeight);
+        uint32_t x1 = x0 + 1 == mWidth ? 0 : x0 + 1;
+        uint32_t y1 = y0 + 1 == mHeight ? 0 : y0 + 1;
+        const uint32_t* row0 = &mTexels[static_cast<size_t>(y0) * mWidth];
+        const uint32_t* row1 = &mTexels[static_cast<size_t>(y1) * mWidth];
+        Float4 ax(x - fx);
+        Float4 top = Lerp(HDecodeTexel(srgb, row0[x0]), HDecodeTexel(srgb, row0[x1]), ax);
+        Float4 bottom = Lerp(HDecodeTexel(srgb, row1[x0]), HDecodeTexel(srgb, row1[x1]), ax);
+        return Lerp(top, bottom, Float4(y - fy));
+    }
+
+    //------------------------------------ SoftwareRasterizer -----------------------------------------//
+    SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height, uint32_t threadCount, uint32_t tileSize, SoftwareDepthTest depthTest)
+        :mThreadCount(std::min(threadCount == 0 ? UINT32_MAX : threadCount, JobSystem::Get().GetThreadCount())),
+        mWidth(width), mHeight(height), mDepthTest(depthTest){
+        mTileSize = std::max(4u, (tileSize + 3) & ~3u);
+        mTilesX = (mWidth + mTileSize - 1) / mTileSize;
+        mTilesY = (mHeight + mTileSize - 1) / mTileSize;
+        mColor.resize(static_cast<size_t>(mWidth) * mHeight);
+        if(mDepthTest != SoftwareDepthTest::None){
+            mDepth.resize(static_cast<size_t>(mWidth) * mHeight + 4);
+        }
+        GetSrgbTables();
+    }
+
+    void SoftwareRasterizer::Render(const std::vector<SoftwareDrawCall>& draws, uint32_t clearColor){
+        J_PROFILE_FUNCTION();
+        uint64_t start = Profiler::Now();
+        // a few ranges per thread, so an expensive range does not hold up the whole pass.
+        uint32_t binCount = static_cast<uint32_t>(std::clamp<size_t>(draws.size(), 1, GetThreadCount() * 4));
+        if(mBins.size() < binCount){
+            mBins.resize(binCount);
+        }
+        for(auto& bin : mBins){
+            bin.triangles.clear();
+            bin.tiles.resize(static_cast<size_t>(mTilesX) * mTilesY);
+            for(auto& tile : bin.tiles){
+                tile.clear();
+            }
+            bin.trianglesSubmitted = 0;
+        }
+        size_t drawsPerBin = (draws.size() + binCount - 1) / binCount;
+        {
+            J_PROFILE_SCOPE("Geometry");
+            JobSystem::Get().ParallelFor(binCount, [&](uint32_t index){
+                size_t begin = std::min(index * drawsPerBin, draws.size());
+                size_t end = std::min(begin + drawsPerBin, draws.size());
+                PProcessDraws(draws, begin, end, mBins[index]);
+            }, mThreadCount);
+        }
+        uint64_t geometryEnd = Profiler::Now();
+        {
+            J_PROFILE_SCOPE("Raster");
+            JobSystem::Get().ParallelFor(mTilesX * mTilesY, [&](uint32_t tile){
+                PRasterizeTile(tile, clearColor);
+            }, mThreadCount);
+        }
+        uint64_t rasterEnd = Profiler::Now();
+
+        mStats = {};
+        for(const auto& bin : mBins){
+            mStats.trianglesSubmitted += bin.trianglesSubmitted;
+            mStats.trianglesSetUp += bin.triangles.size();
+            for(const auto& tile : bin.tiles){
+                mStats.binnedReferences += tile.size();
+            }
+        }
+        mStats.geometryMs = (geometryEnd - start) / 1e6;
+        mStats.rasterMs = (rasterEnd - geometryEnd) / 1e6;
+    }
+
+    void SoftwareRasterizer::PProcessDraws(const std::vector<SoftwareDrawCall>& draws, size_t begin, size_t end, Bin& bin){
+        for(size_t d = begin; d < end; d++){
+            const SoftwareDrawCall& draw = draws[d];
+            for(uint32_t i = 0; i + 2 < draw.indexCount; i += 3){
+                ClipVertex vertices[3];
+                for(uint32_t k = 0; k < 3; k++){
+                    const Vertex& vertex = draw.mesh->vertices[draw.mesh->GetIndex(draw.firstIndex + i + k) + draw.vertexOffset];
+                    vertices[k].position = draw.mvp * glm::vec4(vertex.pos, 1.0f);
+                    vertices[k].texCoord = vertex.texCoord;
+                }
+                bin.trianglesSubmitted++;
+                PClipAndSetup(vertices, draw.texture, bin);
+            }
+        }
+    }
+
+    void SoftwareRasterizer::PClipAndSetup(const ClipVertex* vertices, const SoftwareTexture* texture, Bin& bin){
+        auto inside = [](const glm::vec4& p){return p.z >= 0.0f && p.z <= p.w;};
+        if(inside(vertices[0].position) && inside(vertices[1].position) && inside(vertices[2].position)){
+            PSetupTriangle(vertices[0], vertices[1], vertices[2], texture, bin);
+            return;
+        }
+        // Vulkan clips depth to 0 <= z <= w, x and y are left to the guard band (the bounding box clamp).
+        // Two planes turn a triangle into at most five vertices.
+        ClipVertex polygon[8];
+        ClipVertex clipped[8];
+        uint32_t count = 3;
+        std::copy(vertices, vertices + 3, polygon);
+        auto clipAgainst = [&](auto distance){
+            uint32_t clippedCount = 0;
+            for(uint32_t i = 0; i < count; i++){
+                const ClipVertex& current = polygon[i];
+                const ClipVertex& next = polygon[(i + 1) % count];
+                float dc = distance(current.position);
+                float dn = distance(next.position);
+                if(dc >= 0.0f){
+                    clipped[clippedCount++] = current;
+                }
+                if((dc >= 0.0f) != (dn >= 0.0f)){
+                    float t = dc / (dc - dn);
+                    clipped[clippedCount].position = current.position + (next.position - current.position) * t;
+                    clipped[clippedCount].texCoord = current.texCoord + (next.texCoord - current.texCoord) * t;
+                    clippedCount++;
+                }
+            }
+            count = clippedCount;
+            std::copy(clipped, clipped + count, polygon);
+        };
+        clipAgainst([](const glm::vec4& p){return p.z;});
+        clipAgainst([](const glm::vec4& p){return p.w - p.z;});
+        for(uint32_t i = 1; i + 1 < count; i++){
+            PSetupTriangle(polygon[0], polygon[i], polygon[i + 1], texture, bin);
+        }
+    }
+
+    void SoftwareRasterizer::PSetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const SoftwareTexture* texture, Bin& bin){
+        struct ScreenVertex{
+            float x, y;
+            float attribute[4];
+        };
+        auto toScreen = [this](const ClipVertex& clip){
+            float invW = 1.0f / clip.position.w;
+            ScreenVertex s;
+            // full target viewport, snapped to 1/256 pixel like a fixed point rasterizer.
+            s.x = std::round((clip.position.x * invW * 0.5f + 0.5f) * mWidth * 256.0f) / 256.0f;
+            s.y = std::round((clip.position.y * invW * 0.5f + 0.5f) * mHeight * 256.0f) / 256.0f;
+            s.attribute[0] = invW;
+            s.attribute[1] = clip.texCoord.x * invW;
+            s.attribute[2] = clip.texCoord.y * invW;
+            // depth is linear in screen space, no perspective correction.
+            s.attribute[3] = clip.position.z * invW;
+            return s;
+        };
+        ScreenVertex s[3] = {toScreen(v0), toScreen(v1), toScreen(v2)};
+        // in y-down framebuffer coordinates, Vulkan's counter-clockwise (front facing) triangles have a
+        // negative cross product. Back facing and degenerate ones are culled.
+        float cross = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[1].y - s[0].y) * (s[2].x - s[0].x);
+        if(!(cross < 0.0f)){
+            return;
+        }
+        std::swap(s[1], s[2]);
+        float area = -cross;
+
+        Triangle triangle;
+        for(int i = 0; i < 3; i++){
+            const ScreenVertex& a = s[(i + 1) % 3];
+            const ScreenVertex& b = s[(i + 2) % 3];
+            float dx = b.x - a.x;
+            float dy = b.y - a.y;
+            triangle.edgeTopLeft[i] = (dy == 0.0f && dx > 0.0f) || dy < 0.0f;
+            // both triangles sharing an edge evaluate it from the same end point with the same
+            // operations, only the sign differs, so shared edges have no cracks or double hits.
+            bool flip = a.x > b.x || (a.x == b.x && a.y > b.y);
+            const ScreenVertex& ref = flip ? b : a;
+            triangle.edgeA[i] = -dy;
+            triangle.edgeB[i] = dx;
+            triangle.edgeX[i] = ref.x;
+            triangle.edgeY[i] = ref.y;
+        }
+        triangle.originX = s[0].x;
+        triangle.originY = s[0].y;
+        for(int k = 0; k < 4; k++){
+            triangle.attribute[k] = s[0].attribute[k];
+            triangle.attributeDx[k] = 0.0f;
+            triangle.attributeDy[k] = 0.0f;
+            for(int i = 0; i < 3; i++){
+                triangle.attributeDx[k] += triangle.edgeA[i] * s[i].attribute[k] / area;
+                triangle.attributeDy[k] += triangle.edgeB[i] * s[i].attribute[k] / area;
+            }
+        }
+        // clamped in float before the cast, vertices far outside the target don't fit in an int.
+        // The negated compares also reject NaN.
+        float lastX = static_cast<float>(mWidth - 1);
+        float lastY = static_cast<float>(mHeight - 1);
+        float minX = std::floor(std::min({s[0].x, s[1].x, s[2].x}));
+        float minY = std::floor(std::min({s[0].y, s[1].y, s[2].y}));
+        float maxX = std::ceil(std::max({s[0].x, s[1].x, s[2].x}));
+        float maxY = std::ceil(std::max({s[0].y, s[1].y, s[2].y}));
+        if(!(minX <= lastX && maxX >= 0.0f && minY <= lastY && maxY >= 0.0f)){
+            return;
+        }
+        triangle.minX = static_cast<int>(std::max(minX, 0.0f));
+        triangle.minY = static_cast<int>(std::max(minY, 0.0f));
+        triangle.maxX = static_cast<int>(std::min(maxX, lastX));
+        triangle.maxY = static_cast<int>(std::min(maxY, lastY));
+        triangle.texture = texture;
+
+        uint32_t index = static_cast<uint32_t>(bin.triangles.size());
+        bin.triangles.push_back(triangle);
+        for(uint32_t ty = triangle.minY / mTileSize; ty <= triangle.maxY / mTileSize; ty++){
+            for(uint32_t tx = triangle.minX / mTileSize; tx <= triangle.maxX / mTileSize; tx++){
+                bin.tiles[ty * mTilesX + tx].push_back(index);
+            }
+        }
+    }
+
+    void SoftwareRasterizer::PRasterizeTile(uint32_t tile, uint32_t clearColor){
+        int minX = static_cast<int>((tile % mTilesX) * mTileSize);
+        int minY = static_cast<int>((tile / mTilesX) * mTileSize);
+        int maxX = std::min(minX + static_cast<int>(mTileSize), static_cast<int>(mWidth)) - 1;
+        int maxY = std::min(minY + static_cast<int>(mTileSize), static_cast<int>(mHeight)) - 1;
+        // the far plane, like the Vulkan depth clear.
+        float clearDepth = mDepthTest == SoftwareDepthTest::Greater ? 0.0f : 1.0f;
+        for(int y = minY; y <= maxY; y++){
+            std::fill_n(&mColor[static_cast<size_t>(y) * mWidth + minX], maxX - minX + 1, clearColor);
+            if(mDepthTest != SoftwareDepthTest::None){
+                std::fill_n(&mDepth[static_cast<size_t>(y) * mWidth + minX], maxX - minX + 1, clearDepth);
+            }
+        }
+        for(const auto& bin : mBins){
+            for(uint32_t index : bin.tiles[tile]){
+                PRasterizeTriangle(bin.triangles[index], minX, minY, maxX, maxY);
+            }
+        }
+    }
+
+    void SoftwareRasterizer::PRasterizeTriangle(const Triangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY){
+        // tiles start at multiples of 4, so aligning down stays inside the tile.
+        int minX = std::max(triangle.minX, tileMinX) & ~3;
+        int maxX = std::min(triangle.maxX, tileMaxX);
+        int minY = std::max(triangle.minY, tileMinY);
+        int maxY = std::min(triangle.maxY, tileMaxY);
+        const SrgbTables& srgb = GetSrgbTables();
+        const Float4 laneOffset(0.5f, 1.5f, 2.5f, 3.5f);
+        const Float4 zero(0.0f);
+        const Float4 one(1.0f);
+        Float4 edgeA[3], edgeX[3];
+        for(int i = 0; i < 3; i++){
+            edgeA[i] = Float4(triangle.edgeA[i]);
+            edgeX[i] = Float4(triangle.edgeX[i]);
+        }
+        Float4 attributeDx[4];
+        for(int k = 0; k < 4; k++){
+            attributeDx[k] = Float4(triangle.attributeDx[k]);
+        }
+        const Float4 originX(triangle.originX);
+
+        for(int y = minY; y <= maxY; y++){
+            float py = y + 0.5f;
+            Float4 edgeRow[3];
+            for(int i = 0; i < 3; i++){
+                edgeRow[i] = Float4(triangle.edgeB[i] * (py - triangle.edgeY[i]));
+            }
+            float dy = py - triangle.originY;
+            Float4 attributeRow[4];
+            for(int k = 0; k < 4; k++){
+                attributeRow[k] = Float4(triangle.attribute[k] + triangle.attributeDy[k] * dy);
+            }
+            uint32_t* row = &mColor[static_cast<size_t>(y) * mWidth];
+            float* depthRow = mDepth.empty() ? nullptr : &mDepth[static_cast<size_t>(y) * mWidth];
+            for(int x = minX; x <= maxX; x += 4){
+                Float4 px = Float4(static_cast<float>(x)) + laneOffset;
+                int mask = x + 3 <= maxX ? 0xf : (1 << (maxX - x + 1)) - 1;
+                for(int i = 0; i < 3; i++){
+                    Float4 edge = edgeA[i] * (px - edgeX[i]) + edgeRow[i];
+                    mask &= triangle.edgeTopLeft[i] ? MaskGE(edge, zero) : MaskGT(edge, zero);
+                }
+                if(mask == 0){
+                    continue;
+                }
+                Float4 dx = px - originX;
+                if(depthRow){
+                    // tested before shading, failing lanes never sample.
+                    Float4 depth = attributeRow[3] + attributeDx[3] * dx;
+                    Float4 stored(depthRow[x], depthRow[x + 1], depthRow[x + 2], depthRow[x + 3]);
+                    mask &= mDepthTest == SoftwareDepthTest::Less ? MaskGT(stored, depth) : MaskGT(depth, stored);
+                    if(mask == 0){
+                        continue;
+                    }
+                    float d[4];
+                    depth.Store(d);
+                    for(int lane = 0; lane < 4; lane++){
+                        if(mask & (1 << lane)){
+                            depthRow[x + lane] = d[lane];
+                        }
+                    }
+                }
+                // perspective correct texture coordinates.
+                Float4 w = one / (attributeRow[0] + attributeDx[0] * dx);
+                float u[4], v[4];
+                // texels are fetched per lane, each filtered with its four channels in one Float4.
+                ((attributeRow[1] + attributeDx[1] * dx) * w).Store(u);
+                ((attributeRow[2] + attributeDx[2] * dx) * w).Store(v);
+                for(int lane = 0; lane < 4; lane++){
+                    if(mask & (1 << lane)){
+                        row[x + lane] = HEncodePixel(srgb, triangle.texture->SampleBilinear(u[lane], v[lane]));
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "SoftwareSimd.h"
+#include "core/Mesh.h"
+#include "core/JobSystem.h"
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace ProjectJ{
+    // RGBA8 holding sRGB encoded color, like a VK_FORMAT_R8G8B8A8_SRGB image. Sampled the way the
+    // Vulkan backend's sampler does: bilinear in linear space, repeat addressing, no mips.
+    class SoftwareTexture{
+    public:
+        SoftwareTexture(const uint8_t* pixels, uint32_t width, uint32_t height);
+        // linear RGBA.
+        Float4 SampleBilinear(float u, float v) const;
+        uint32_t GetWidth() const {return mWidth;}
+        uint32_t GetHeight() const {return mHeight;}
+    private:
+        std::vector<uint32_t> mTexels;
+        uint32_t mWidth;
+        uint32_t mHeight;
+    };
+
+    // One vkCmdDrawIndexed with a single instance from mesh's vertex and index arrays; mvp is what the
+    // vertex shader computes.
+    struct SoftwareDrawCall{
+        glm::mat4 mvp;
+        const MeshBlock* mesh;
+        const SoftwareTexture* texture;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+    };
+
+    // the depth compare of the Vulkan pipeline, Greater for reverse-Z.
+    enum class SoftwareDepthTest{
+        None,
+        Less,
+        Greater
+    };
+
+    struct SoftwareRasterizerStats{
+        uint64_t trianglesSubmitted = 0;
+        // survived clipping and back face culling.
+        uint64_t trianglesSetUp = 0;
+        // triangle references summed over all tile bins.
+        uint64_t binnedReferences = 0;
+        double geometryMs = 0.0;
+        double rasterMs = 0.0;
+    };
+
+    // Tile binned rasterizer for the engine's one pipeline: position transform, near/far clipping,
+    // counter-clockwise back face culling, top-left fill rule, an optional depth test before shading and
+    // a bilinear textured fragment. A geometry pass transforms, clips and bins triangles per tile in parallel over draw
+    // ranges, a raster pass then shades tiles in parallel, four pixels per step. Bins are walked in
+    // submission order, so the image does not depend on the thread count.
+    class SoftwareRasterizer{
+    public:
+        // threadCount is how many threads of the shared JobSystem to use, 0 for all of them; tileSize is
+        // rounded up to a multiple of 4.
+        SoftwareRasterizer(uint32_t width, uint32_t height, uint32_t threadCount = 0, uint32_t tileSize = 64,
+            SoftwareDepthTest depthTest = SoftwareDepthTest::None);
+        SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+        SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+        // clears to clearColor (packed RGBA8) and draws, blocks until the frame is complete.
+        void Render(const std::vector<SoftwareDrawCall>& draws, uint32_t clearColor);
+        // RGBA8, sRGB encoded, GetRowPitch() bytes per row.
+        const uint8_t* GetColor() const {return reinterpret_cast<const uint8_t*>(mColor.data());}
+        uint32_t GetWidth() const {return mWidth;}
+        uint32_t GetHeight() const {return mHeight;}
+        uint32_t GetRowPitch() const {return mWidth * 4;}
+        uint32_t GetThreadCount() const {return mThreadCount;}
+        const SoftwareRasterizerStats& GetStats() const {return mStats;}
+    private:
+        struct Triangle{
+            // edge i is A*x + B*y + C relative to vertex ref[i]; a pixel center is covered where every
+            // edge is > 0, or == 0 on top-left edges.
+            float edgeA[3];
+            float edgeB[3];
+            float edgeX[3];
+            float edgeY[3];
+            bool edgeTopLeft[3];
+            // 1/w, u/w, v/w and depth z/w as planes over the screen, anchored at (originX, originY).
+            float originX;
+            float originY;
+            float attribute[4];
+            float attributeDx[4];
+            float attributeDy[4];
+            int minX, minY, maxX, maxY;
+            const SoftwareTexture* texture;
+        };
+        // triangles of one contiguous range of draws, and per tile the ones touching it.
+        struct Bin{
+            std::vector<Triangle> triangles;
+            std::vector<std::vector<uint32_t> > tiles;
+            uint64_t trianglesSubmitted = 0;
+        };
+        struct ClipVertex{
+            glm::vec4 position;
+            glm::vec2 texCoord;
+        };
+
+        void PProcessDraws(const std::vector<SoftwareDrawCall>& draws, size_t begin, size_t end, Bin& bin);
+        void PClipAndSetup(const ClipVertex* vertices, const SoftwareTexture* texture, Bin& bin);
+        void PSetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const SoftwareTexture* texture, Bin& bin);
+        void PRasterizeTile(uint32_t tile, uint32_t clearColor);
+        void PRasterizeTriangle(const Triangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+    private:
+        uint32_t mThreadCount;
+        uint32_t mWidth;
+        uint32_t mHeight;
+        uint32_t mTileSize;
+        uint32_t mTilesX;
+        uint32_t mTilesY;
+        SoftwareDepthTest mDepthTest;
+        std::vector<uint32_t> mColor;
+        // with a depth test, row major plus 4 floats so a row's last quad can be loaded whole.
+        std::vector<float> mDepth;
+        std::vector<Bin> mBins;
+        SoftwareRasterizerStats mStats;
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define J_SOFTWARE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace ProjectJ{
+    // Four float lanes, SSE2 where the target has it and plain arrays otherwise. Only what the
+    // rasterizer needs: arithmetic, comparisons to a lane bit mask, loads and stores.
+    struct Float4{
+#ifdef J_SOFTWARE_SSE2
+        __m128 v;
+        Float4() = default;
+        Float4(__m128 value) : v(value){}
+        explicit Float4(float s) : v(_mm_set1_ps(s)){}
+        Float4(float a, float b, float c, float d) : v(_mm_setr_ps(a, b, c, d)){}
+        void Store(float* out) const {_mm_storeu_ps(out, v);}
+
+        friend Float4 operator+(Float4 a, Float4 b){return _mm_add_ps(a.v, b.v);}
+        friend Float4 operator-(Float4 a, Float4 b){return _mm_sub_ps(a.v, b.v);}
+        friend Float4 operator*(Float4 a, Float4 b){return _mm_mul_ps(a.v, b.v);}
+        friend Float4 operator/(Float4 a, Float4 b){return _mm_div_ps(a.v, b.v);}
+        // bit i is set where lane i compares true.
+        friend int MaskGE(Float4 a, Float4 b){return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v));}
+        friend int MaskGT(Float4 a, Float4 b){return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v));}
+#else
+        float v[4];
+        Float4() = default;
+        explicit Float4(float s) : v{s, s, s, s}{}
+        Float4(float a, float b, float c, float d) : v{a, b, c, d}{}
+        void Store(float* out) const {for(int i = 0; i < 4; i++) out[i] = v[i];}
+
+        friend Float4 operator+(Float4 a, Float4 b){return {a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]};}
+        friend Float4 operator-(Float4 a, Float4 b){return {a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]};}
+        friend Float4 operator*(Float4 a, Float4 b){return {a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]};}
+        friend Float4 operator/(Float4 a, Float4 b){return {a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]};}
+        friend int MaskGE(Float4 a, Float4 b){
+            int mask = 0;
+            for(int i = 0; i < 4; i++) mask |= (a.v[i] >= b.v[i]) << i;
+            return mask;
+        }
+        friend int MaskGT(Float4 a, Float4 b){
+            int mask = 0;
+            for(int i = 0; i < 4; i++) mask |= (a.v[i] > b.v[i]) << i;
+            return mask;
+        }
+#endif
+        friend Float4 Lerp(Float4 a, Float4 b, Float4 t){return a + (b - a) * t;}
+    };
+}
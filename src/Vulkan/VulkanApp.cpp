@@ -1,6 +1,6 @@
 #include "Jpch.h"
 #include "VulkanApp.h"
-#include "stb_image.h"
+#include "VulkanVertexLayout.h"
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -8,7 +8,7 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
     void* pUserData) {
     if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
-        std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
+        JLOG_WARN("validation layer: {}", pCallbackData->pMessage);
         // Message is important enough to show
     }
     return VK_FALSE;
@@ -32,72 +32,416 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 namespace ProjectJ{
     VulkanRHI::VulkanRHI(const VulkanConfig& config)
         :mConfig(config) {
+        if(!mConfig.headless){
+            mDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
     }
     VulkanRHI::~VulkanRHI(){
+        if(mInitialized){
+            Cleanup();
+        }
     }
     void VulkanRHI::Draw(){
-        ScopedFrame frame(mQueue);
-
-        auto updateUniformBuffer = [this](UniformBufferObject& ubo) {
-            static auto startTime = std::chrono::high_resolution_clock::now();
-            auto currentTime = std::chrono::high_resolution_clock::now();
-            float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-            ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-            ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-            ubo.proj = glm::perspective(glm::radians(45.0f), mSwapChain->GetExtent().width / (float) mSwapChain->GetExtent().height, 0.1f, 10.0f);
-            ubo.proj[1][1] *= -1;
+        mFramePacket.frameIndex = mFrameCount;
+        mFramePacket.time = mConfig.fixedTimeStep > 0.0f ? mFrameCount * mConfig.fixedTimeStep
+            : std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - mStartTime).count();
+        Draw(mFramePacket);
+    }
+    void VulkanRHI::Draw(const FramePacket& packet){
+        J_PROFILE_FUNCTION();
+        mFrameArena.Reset();
+        ScopedFrame frame(*mQueue);
+        // the image's buffers, queries, readback slot and command buffer are all still the last frame's
+        // that drew to it; the in-flight fence only covers it when images come back in order.
+        mQueue->WaitForFrame(frame.LastImageFrameSerial);
+        mGPUProfiler->Collect(static_cast<uint32_t>(frame.ImageIndex));
+        mMemoryTracker->OnFrame();
+        if(mReadback){
+            J_PROFILE_SCOPE("Readback");
+            // the wait above completed this slot's previous frame, so it is delivered before being overwritten.
+            mReadback->Poll(mQueue->GetCompletedFrameSerial());
+            mReadback->OnSubmit(static_cast<uint32_t>(frame.ImageIndex), frame.FrameSerial);
+        }
+
+        auto now = std::chrono::high_resolution_clock::now();
+        SceneView sceneView = ComputeSceneView(packet.time, mSwapChain->GetExtent().width / (float) mSwapChain->GetExtent().height, mConfig.reverseZ);
+        {
+            J_PROFILE_SCOPE("Transforms");
+            if(mLod && mFrameCount > 0){
+                // the budget is about wall time between frames, whatever the frame waited on.
+                mLod->UpdateBudget(std::chrono::duration<double, std::milli>(now - mLastDrawTime).count(), mConfig.lodFrameBudgetMs);
+            }
+            mLastDrawTime = now;
+            mFrameCount++;
+            PUpdateTransforms(packet);
+        }
+        bool quantizedPositions = mMeshPool.GetVertexEncoding() != VertexEncoding::Float;
+        // the mesh decides the dequantization, with LODs that is the level drawn and not the object's own.
+        auto objectModel = [&](size_t i, uint32_t meshIndex){
+            // straight from the graph, mObjects only follows it where bounds need it.
+            glm::mat4 model = mSceneGraph.GetObjectWorld(static_cast<uint32_t>(i)) * sceneView.spin;
+            return quantizedPositions ? ApplyPositionDequantize(model, mMeshPool.GetRange(meshIndex)) : model;
         };
-        mUniformBuffers[frame.ImageIndex]->ModifyAndSync(updateUniformBuffer);
+        if(!mConfig.enableInstancing){
+            J_PROFILE_SCOPE("UpdateUniformBuffer");
+            auto& objectBuffer = *mObjectBuffers[frame.ImageIndex];
+            for(size_t i = 0; i < mObjects.size(); i++){
+                UniformBufferObject& ubo = objectBuffer.At(i);
+                ubo.model = objectModel(i, mObjects[i].meshIndex);
+                ubo.view = sceneView.view;
+                ubo.proj = sceneView.proj;
+            }
+            return;
+        }
+        ViewUniformBufferObject& viewUbo = mViewBuffers[frame.ImageIndex]->At(0);
+        viewUbo.view = sceneView.view;
+        viewUbo.proj = sceneView.proj;
+        if(mGPUCullShader){
+            // the culling itself happens in PRecordGPUCulling, the CPU only copies objects that moved.
+            J_PROFILE_SCOPE("UpdateCullObjects");
+            CullUniformBufferObject& cull = mCullBuffers[frame.ImageIndex]->At(0);
+            glm::mat4 viewProj = sceneView.proj * sceneView.view;
+            Frustum frustum = ExtractFrustum(viewProj);
+            std::copy(std::begin(frustum.planes), std::end(frustum.planes), cull.frustumPlanes);
+            cull.spin = sceneView.spin;
+            // this image's objects still hold the transforms of the last frame it drew.
+            auto& objectBuffer = *mCullObjectBuffers[frame.ImageIndex];
+            for(uint32_t i : mCullMovedObjects.Get(frame.ImageIndex)){
+                GPUCullObject& object = objectBuffer.At(i);
+                object.model = mObjects[i].model;
+                object.bounds = glm::vec4(mBounds.centerX[i], mBounds.centerY[i], mBounds.centerZ[i], mBounds.radius[i]);
+            }
+            mCullMovedObjects.Clear(frame.ImageIndex);
+            if(mDepthPyramidShader){
+                // the pyramid is the previous frame's, the first frame has none yet.
+                cull.pyramidViewProj = mLastViewProj;
+                cull.pyramidLevelCount = mFrameCount > 1 ? static_cast<uint32_t>(mDepthPyramidLevels.size()) : 0;
+                mLastViewProj = viewProj;
+            }
+            return;
+        }
+        if(mCuller){
+            // mBounds follows moved objects (see PUpdateTransforms) and the spin is about their axis.
+            J_PROFILE_SCOPE("Cull");
+            mCuller->Cull(mBounds, ExtractFrustum(sceneView.proj * sceneView.view), mVisible);
+        }
+        if(mLod){
+            J_PROFILE_SCOPE("Lod");
+            const std::vector<uint32_t>* visible = mCuller ? &mVisible : nullptr;
+            mLod->Select(sceneView, mSwapChain->GetExtent().height, visible);
+            mLodBatches.Fill(*mLod, mFrameArena, visible);
+        }
+        J_PROFILE_SCOPE("BuildInstances");
+        auto& instanceBuffer = *mInstanceBuffers[frame.ImageIndex];
+        auto& indirectBuffer = *mIndirectBuffers[frame.ImageIndex];
+        // instances are written compactly; visible indices ascend, so a batch's survivors are one run.
+        uint32_t instance = 0;
+        size_t nextVisible = 0;
+        for(size_t b = 0; b < mDrawBatches.size(); b++){
+            const DrawBatch& batch = mDrawBatches[b];
+            const MeshRange& range = mMeshPool.GetRange(batch.meshIndex);
+            uint32_t firstInstance = instance;
+            uint32_t batchEnd = batch.firstObject + batch.objectCount;
+            if(mLod){
+                // already bucketed by level, in the split batches' order.
+                const uint32_t* objects = mLodBatches.GetInstances().data() + mLodBatches.GetFirstInstance(b);
+                for(uint32_t i = 0; i < mLodBatches.GetInstanceCount(b); i++){
+                    instanceBuffer.At(instance++).model = objectModel(objects[i], batch.meshIndex);
+                }
+            }
+            else if(mCuller){
+                for(; nextVisible < mVisible.size() && mVisible[nextVisible] < batchEnd; nextVisible++){
+                    instanceBuffer.At(instance++).model = objectModel(mVisible[nextVisible], batch.meshIndex);
+                }
+            }
+            else{
+                for(uint32_t i = batch.firstObject; i < batchEnd; i++){
+                    instanceBuffer.At(instance++).model = objectModel(i, batch.meshIndex);
+                }
+            }
+            // an empty batch stays in the buffer with zero instances, the recorded multi-draws never change.
+            VkDrawIndexedIndirectCommand& command = indirectBuffer.At(b);
+            command.indexCount = range.indexCount;
+            command.instanceCount = instance - firstInstance;
+            command.firstIndex = range.firstIndex;
+            command.vertexOffset = range.vertexOffset;
+            command.firstInstance = firstInstance;
+        }
+    }
+    void VulkanRHI::PUpdateTransforms(const FramePacket& packet){
+        for(const auto& transform : packet.transforms){
+            mSceneGraph.SetLocal(transform.handle, transform.local);
+        }
+        if(mSceneGraph.Update() == 0 || !(mCuller || mLod || mGPUCullShader)){
+            return;
+        }
+        // moved objects take their bounds along, GPU culling copies both into each image's objects.
+        const std::vector<uint32_t>& moved = mSceneGraph.GetMovedObjects();
+        for(uint32_t i : moved){
+            mObjects[i].model = mSceneGraph.GetObjectWorld(i);
+        }
+        if(mCuller || mGPUCullShader){
+            UpdateObjectBounds(mObjects, moved, mMeshPool, mBounds);
+        }
+        if(mGPUCullShader){
+            mCullMovedObjects.Add(moved);
+        }
+        if(mLod){
+            mLod->UpdateBounds(mObjects, mMeshPool, moved);
+        }
     }
     void VulkanRHI::Init(){
-        PCreateInstance();
-        PSetupDebugMessenger();
-        PCreateSurface();
-        PPickPhysicalDevice();
-        PCreateLogicalDevice();
-        VulkanSwapChainDesc desc{};
-        desc.window = mConfig.window;
-        mSwapChain = std::make_shared<VulkanSwapChain>(mDevice,mPhysicalDevice,mSurface,mQueueFamilyIndices,desc);
-        mTestShader = std::make_unique<TestShader>();
-        PCreateRenderPass();
-        PCreateGraphicsPipeline();
-        PCreateFramebuffers();
-        mQueue = std::make_shared<VulkanQueue>();
-        PCreateVertexBuffer();
-        PCreateIndexBuffer();
-        PCreateUniformBuffer();
-        PCreateTextureSampler();
-        PCreateDescriptorSet();
-        mTestCommandBuffer = std::make_shared<VulkanCommandBuffer>();
-        PPrepareCommandBuffers();
+        J_PROFILE_FUNCTION();
+        // the destructor only cleans up an initialized RHI, so release whatever got built before a throw here.
+        try{
+            PCreateInstance();
+            PSetupDebugMessenger();
+            PCreateSurface();
+            PPickPhysicalDevice();
+            PCreateLogicalDevice();
+            mMemoryTracker = std::make_unique<VulkanMemoryTracker>(mPhysicalDevice, mMemoryBudgetSupported, mConfig.statsLogInterval);
+            VulkanSwapChainDesc desc{};
+            desc.window = mConfig.window;
+            desc.width = mConfig.width;
+            desc.height = mConfig.height;
+            if(mConfig.headless){
+                mSwapChain = std::make_shared<VulkanOffscreenSwapChain>(*this, desc);
+            }
+            else{
+                mSwapChain = std::make_shared<VulkanSwapChain>(mDevice,mPhysicalDevice,mSurface,mQueueFamilyIndices,desc);
+            }
+            Scene defaultScene;
+            if(mConfig.scene == nullptr){
+                defaultScene = CreateDefaultScene();
+            }
+            const Scene& scene = mConfig.scene ? *mConfig.scene : defaultScene;
+            mMaterials = scene.materials;
+            mObjects = scene.objects;
+            mMeshPool = MeshPool(mConfig.vertexEncoding);
+            bool gpuCulling = mConfig.enableGPUCulling && mConfig.enableInstancing && mDrawIndirectCountSupported
+                && mMultiDrawIndirectSupported && mIndirectFirstInstanceSupported;
+            // like frustum culling LODs need draws rebuilt every frame, the culling passes keep every object's mesh.
+            bool lod = mConfig.enableLod && mConfig.enableInstancing && mIndirectFirstInstanceSupported && !gpuCulling;
+            if(mConfig.enableLod && !lod){
+                JLOG_WARN("LOD selection needs instancing and drawIndirectFirstInstance and no GPU culling, every object draws its full mesh.");
+            }
+            std::vector<LodChain> lodChains;
+            AddSceneMeshes(scene, mMeshPool, lod ? &lodChains : nullptr);
+            std::vector<uint32_t> sceneOrder = SortObjectsForDrawing(mObjects, mMeshPool);
+            mSceneGraph.Build(scene.nodes, mObjects, sceneOrder);
+            mSceneGraph.Update();
+            for(uint32_t i = 0; i < static_cast<uint32_t>(mObjects.size()); i++){
+                mObjects[i].model = mSceneGraph.GetObjectWorld(i);
+            }
+            uint32_t descriptorSetCount = static_cast<uint32_t>(mSwapChain->GetImageCount() * std::max<size_t>(mMaterials.size(), 1));
+            mTestShader = std::make_unique<TestShader>(*this, descriptorSetCount);
+            if(lod){
+                mLod = std::make_unique<LodSelector>(mConfig.lodPixelError);
+                mLod->Init(mObjects, mMeshPool, std::move(lodChains));
+            }
+            if(mConfig.enableInstancing){
+                mDrawBatches = BuildDrawBatches(mObjects);
+                if(mLod){
+                    // every batch once per level, the indirect buffer gets a command for each.
+                    mLodBatches.Init(mDrawBatches, *mLod, mMeshPool);
+                    mDrawBatches = mLodBatches.GetBatches();
+                }
+                mDrawRuns.clear();
+                for(size_t b = 0; b < mDrawBatches.size(); b++){
+                    if(b == 0 || mDrawBatches[b].materialIndex != mDrawBatches[b - 1].materialIndex
+                        || mMeshPool.GetRange(mDrawBatches[b].meshIndex).block != mMeshPool.GetRange(mDrawBatches[b - 1].meshIndex).block){
+                        mDrawRuns.push_back(static_cast<uint32_t>(b));
+                    }
+                }
+                mDrawRuns.push_back(static_cast<uint32_t>(mDrawBatches.size()));
+                mInstancedShader = std::make_unique<InstancedShader>(*this, descriptorSetCount);
+                JLOG_INFO("{} objects in {} instanced draw batches", mObjects.size(), mDrawBatches.size());
+            }
+            if(mConfig.enableGPUCulling){
+                if(gpuCulling){
+                    mGPUCullShader = std::make_unique<GPUCullShader>(*this);
+                }
+                else{
+                    JLOG_WARN("GPU culling needs instancing, drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance.");
+                }
+            }
+            if(mConfig.enableFrustumCulling && !mGPUCullShader){
+                if(mConfig.enableInstancing && mIndirectFirstInstanceSupported){
+                    ComputeObjectBounds(mObjects, mMeshPool, mBounds);
+                    mCuller = std::make_unique<FrustumCuller>();
+                }
+                else{
+                    JLOG_WARN("frustum culling needs instancing and drawIndirectFirstInstance, every object is drawn.");
+                }
+            }
+            mRenderTargets = std::make_unique<VulkanRenderTargetPool>(*this);
+            if(mConfig.enableDepth || mConfig.enableDepthPrepass || mConfig.enableOcclusionCulling){
+                mDepthFormat = PFindDepthFormat();
+            }
+            if(mConfig.enableOcclusionCulling){
+                VkFormatProperties properties{};
+                vkGetPhysicalDeviceFormatProperties(mPhysicalDevice,mDepthFormat,&properties);
+                // the pyramid pass samples the depth aspect alone, a packed stencil would need a separate view.
+                if(mGPUCullShader && mDepthFormat == VK_FORMAT_D32_SFLOAT
+                    && (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)){
+                    mDepthPyramidShader = std::make_unique<DepthPyramidShader>(*this, 1);
+                }
+                else{
+                    JLOG_WARN("occlusion culling needs GPU culling and a sampleable D32 depth format, only the frustum is tested.");
+                }
+            }
+            PCreateRenderPass();
+            PCreateGraphicsPipeline();
+            PCreateFramebuffers();
+            mQueue = std::make_shared<VulkanQueue>(*this);
+            PCreateMeshBuffers();
+            PCreateUniformBuffer();
+            if(mDepthPyramidShader){
+                PCreateDepthPyramid();
+            }
+            if(mGPUCullShader){
+                PCreateGPUCulling();
+            }
+            PCreateTextures(scene);
+            PCreateDescriptorSet();
+            mTestCommandBuffer = std::make_shared<VulkanCommandBuffer>();
+            mGPUProfiler = std::make_unique<VulkanGPUProfiler>(*this, mSwapChain->GetImageCount(), 64, mConfig.statsLogInterval);
+            mMainPassScope = mGPUProfiler->GetScopeId("MainPass");
+            if(mConfig.enableReadback){
+                if(!(mSwapChain->GetImageUsage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)){
+                    throw std::runtime_error("swap chain images can not be read back.");
+                }
+                mReadback = std::make_unique<VulkanFrameReadback>(*this, mSwapChain->GetImageCount(), mSwapChain->GetExtent(), mSwapChain->GetFormat());
+            }
+            PPrepareCommandBuffers();
+            mStartTime = std::chrono::high_resolution_clock::now();
+        }
+        catch(...){
+            Cleanup();
+            throw;
+        }
+        mInitialized = true;
     }
     void VulkanRHI::Cleanup(){
-        vkDeviceWaitIdle(mDevice);
+        J_PROFILE_FUNCTION();
+        mInitialized = false;
+        // also called on a partially built RHI from Init, every handle may still be null.
+        if(mDevice != VK_NULL_HANDLE){
+            vkDeviceWaitIdle(mDevice);
+        }
+        if(mReadback){
+            mReadback->Poll(UINT64_MAX);
+            mReadback.reset();
+        }
 
-        mIndexBuffer.reset();
-        mVertexBuffer.reset();
-        mTextureSampler.reset();
-        for(size_t i = 0; i < mSwapChain->GetImageCount(); i++){
-            mUniformBuffers[i].reset();
+        mGPUProfiler.reset();
+        mIndexBuffers.clear();
+        mVertexBuffers.clear();
+        mTextures.clear();
+        mObjectBuffers.clear();
+        mViewBuffers.clear();
+        mInstanceBuffers.clear();
+        mIndirectBuffers.clear();
+        mDrawBatches.clear();
+        mDrawRuns.clear();
+        mCullPipeline.reset();
+        mCompactPipeline.reset();
+        if(mCullPipelineLayout != VK_NULL_HANDLE){
+            vkDestroyPipelineLayout(mDevice,mCullPipelineLayout,nullptr);
+            mCullPipelineLayout = VK_NULL_HANDLE;
+        }
+        mCullObjectBuffers.clear();
+        mCullMovedObjects.Init(0, 0);
+        mCullBatchBuffer.reset();
+        mCullBuffers.clear();
+        mCulledInstanceBuffers.clear();
+        mBatchCountBuffers.clear();
+        mCulledDrawBuffers.clear();
+        mDrawCountBuffers.clear();
+        mCullDescriptorSets.clear();
+        mGPUCullShader.reset();
+        mDepthPyramidPipeline.reset();
+        if(mDepthPyramidPipelineLayout != VK_NULL_HANDLE){
+            vkDestroyPipelineLayout(mDevice,mDepthPyramidPipelineLayout,nullptr);
+            mDepthPyramidPipelineLayout = VK_NULL_HANDLE;
         }
+        mDepthSampler.reset();
+        mDepthPyramidBuffer.reset();
+        mDepthPyramidLevels.clear();
+        mDepthPyramidDescriptorSet = VK_NULL_HANDLE;
+        mDepthPyramidShader.reset();
+        mLastViewProj = glm::mat4(1.0f);
+        mCuller.reset();
+        mBounds = BoundingSpheres();
+        mVisible.clear();
+        mLod.reset();
+        mLodBatches = LodDrawBatches();
         mTestShader.reset();
+        mInstancedShader.reset();
         // vkDestroyDescriptorPool(mDevice,mDescriptorPool,nullptr);
         // vkDestroyDescriptorSetLayout(mDevice,mDescriptorSetLayout,nullptr);
         
         mQueue.reset();
         for(auto framebuffer : mSwapChainFramebuffers){
-            vkDestroyFramebuffer(mDevice,framebuffer,nullptr);
+            if(framebuffer != VK_NULL_HANDLE){
+                vkDestroyFramebuffer(mDevice,framebuffer,nullptr);
+            }
         }
+        mSwapChainFramebuffers.clear();
+        mDepthTarget.reset();
+        mRenderTargets.reset();
+        mDepthFormat = VK_FORMAT_UNDEFINED;
         mGraphicPipeline.reset();
-        vkDestroyPipelineLayout(mDevice,mPipelineLayout,nullptr);
-        vkDestroyRenderPass(mDevice,mRenderPass,nullptr);
+        mDepthPrepassPipeline.reset();
+        if(mPipelineLayout != VK_NULL_HANDLE){
+            vkDestroyPipelineLayout(mDevice,mPipelineLayout,nullptr);
+            mPipelineLayout = VK_NULL_HANDLE;
+        }
+        if(mRenderPass != VK_NULL_HANDLE){
+            vkDestroyRenderPass(mDevice,mRenderPass,nullptr);
+            mRenderPass = VK_NULL_HANDLE;
+        }
         mSwapChain.reset();
-        vkDestroyDevice(mDevice,nullptr);
-        if (mConfig.enableValidationLayer) {
+        if(mMemoryTracker){
+            for(uint32_t i = 0; i < static_cast<uint32_t>(VulkanMemoryTag::Count); i++){
+                auto tag = static_cast<VulkanMemoryTag>(i);
+                auto stats = mMemoryTracker->GetTagStats(tag);
+                if(stats.liveAllocations > 0){
+                    JLOG_WARN("{} {} allocations ({} bytes) still alive at cleanup.", stats.liveAllocations, ToString(tag), stats.liveBytes);
+                }
+            }
+            mMemoryTracker.reset();
+        }
+        if(mDevice != VK_NULL_HANDLE){
+            vkDestroyDevice(mDevice,nullptr);
+            mDevice = VK_NULL_HANDLE;
+        }
+        if(mDebugMessenger != VK_NULL_HANDLE){
             DestroyDebugUtilsMessengerEXT(mInstance, mDebugMessenger, nullptr);
+            mDebugMessenger = VK_NULL_HANDLE;
+        }
+        if(mSurface != VK_NULL_HANDLE){
+            vkDestroySurfaceKHR(mInstance,mSurface,nullptr);
+            mSurface = VK_NULL_HANDLE;
+        }
+        if(mInstance != VK_NULL_HANDLE){
+            vkDestroyInstance(mInstance, nullptr);
+            mInstance = VK_NULL_HANDLE;
         }
-        vkDestroySurfaceKHR(mInstance,mSurface,nullptr);
-        vkDestroyInstance(mInstance, nullptr);
+    }
+    
+    double VulkanRHI::GetLastGPUFrameMs() const{
+        return mGPUProfiler->GetLastMs(mMainPassScope);
+    }
+    uint64_t VulkanRHI::GetGPUFrameSampleCount() const{
+        return mGPUProfiler->GetSampleCount(mMainPassScope);
+    }
+
+    void VulkanRHI::SetReadbackCallback(ReadbackCallback callback){
+        if(!mReadback){
+            throw std::runtime_error("readback is not enabled.");
+        }
+        mReadback->SetCallback(std::move(callback));
     }
     
     void VulkanRHI::PCreateInstance(){
@@ -133,15 +477,18 @@ namespace ProjectJ{
 
         VK_CHECK(vkCreateInstance(&createInfo,nullptr,&mInstance),"failed to create instance.");
 
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
         uint32_t extensionCount = 0;
         vkEnumerateInstanceExtensionProperties(nullptr,&extensionCount,nullptr);
         std::vector<VkExtensionProperties> extensions(extensionCount);
         vkEnumerateInstanceExtensionProperties(nullptr,&extensionCount,extensions.data());
-        std::cout << "available extensions:\n";
-
+        std::string extensionNames;
         for (const auto& extension : extensions) {
-            std::cout << '\t' << extension.extensionName << '\n';
+            extensionNames += "\n\t";
+            extensionNames += extension.extensionName;
         }
+        JLOG_TRACE("available extensions:{}", extensionNames);
+#endif
     }
     bool VulkanRHI::PCheckValidationLayer(){
         uint32_t layerCount;
@@ -163,11 +510,14 @@ namespace ProjectJ{
         return true;
     }
     std::vector<const char*> VulkanRHI::HGetRequiredExtensions(){
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
+        std::vector<const char*> extensions;
+        if(!mConfig.headless){
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
 
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        std::vector<const char*> extensions(glfwExtensions,glfwExtensions + glfwExtensionCount);
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions,glfwExtensions + glfwExtensionCount);
+        }
         if(mConfig.enableValidationLayer){
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
@@ -188,6 +538,8 @@ namespace ProjectJ{
         VK_CHECK(CreateDebugUtilsMessengerEXT(mInstance,&createInfo,nullptr,&mDebugMessenger),"failed to setup debug messenger.");
     }
     void VulkanRHI::PCreateSurface(){
+        mSurface = VK_NULL_HANDLE;
+        if(mConfig.headless) return;
         // VkWin32SurfaceCreateInfoKHR createInfo{};
         // createInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
         // createInfo.hwnd = glfwGetWin32Window(mConfig.window);
@@ -214,9 +566,14 @@ namespace ProjectJ{
                 const auto& queueFamily = queueFamilies[i];
                 if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT){
                     indices.graphicsFamily = i;
+                    if(mConfig.headless){
+                        indices.presentFamily = i;
+                    }
                 }
                 VkBool32 presentSupport = false;
-                vkGetPhysicalDeviceSurfaceSupportKHR(device,i,mSurface,&presentSupport);
+                if(!mConfig.headless){
+                    vkGetPhysicalDeviceSurfaceSupportKHR(device,i,mSurface,&presentSupport);
+                }
                 if(presentSupport){ 
                     indices.presentFamily = i;
                 }
@@ -238,7 +595,10 @@ namespace ProjectJ{
             return requiredExtensions.empty();
         };
         auto querySwapChainSupport = [this](VkPhysicalDevice device){
-            SwapChainSupportDetails details;
+            SwapChainSupportDetails details{};
+            if(mConfig.headless){
+                return details;
+            }
             vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device,mSurface,&details.capabilities);
             uint32_t formatCount;
             vkGetPhysicalDeviceSurfaceFormatsKHR(device,mSurface,&formatCount,nullptr);
@@ -254,7 +614,7 @@ namespace ProjectJ{
             }
             return details;
         };
-        auto isDeviceSuitable = [querySwapChainSupport, checkDeviceExtensions, findQueueFamilies](VkPhysicalDevice device)->bool{
+        auto isDeviceSuitable = [this, querySwapChainSupport, checkDeviceExtensions, findQueueFamilies](VkPhysicalDevice device)->bool{
             auto indices = findQueueFamilies(device);
             if(!indices.IsComplete()) {
                 return false;
@@ -263,7 +623,7 @@ namespace ProjectJ{
                 return false;
             }
             auto details = querySwapChainSupport(device);
-            if(details.formats.empty() || details.presentModes.empty()) {
+            if(!mConfig.headless && (details.formats.empty() || details.presentModes.empty())) {
                 return false;
             }
             VkPhysicalDeviceFeatures supportedFeatures;
@@ -307,6 +667,11 @@ namespace ProjectJ{
         }
         mQueueFamilyIndices = findQueueFamilies(mPhysicalDevice);
         mSwapChainSupportDetails = querySwapChainSupport(mPhysicalDevice);
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(mPhysicalDevice,&properties);
+        mDescriptorUpdateTemplateSupported = properties.apiVersion >= VK_API_VERSION_1_1;
+        mDeviceName = properties.deviceName;
+        JLOG_INFO("using {}", mDeviceName);
     }
     void VulkanRHI::PCreateLogicalDevice(){
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
@@ -324,15 +689,52 @@ namespace ProjectJ{
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        std::vector<const char*> deviceExtensions(mDeviceExtensions);
+        {
+            uint32_t extensionCount;
+            vkEnumerateDeviceExtensionProperties(mPhysicalDevice,nullptr,&extensionCount,nullptr);
+            std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+            vkEnumerateDeviceExtensionProperties(mPhysicalDevice,nullptr,&extensionCount,availableExtensions.data());
+            for(const auto& extension : availableExtensions){
+                if(strcmp(extension.extensionName,VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0){
+                    mMemoryBudgetSupported = true;
+                    deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                }
+            }
+        }
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(mPhysicalDevice,&supportedFeatures);
+        mIndirectFirstInstanceSupported = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+        mMultiDrawIndirectSupported = supportedFeatures.multiDrawIndirect == VK_TRUE;
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        // the 1.2 feature struct may only be chained for 1.2 devices.
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(mPhysicalDevice,&properties);
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        if(properties.apiVersion >= VK_API_VERSION_1_2){
+            VkPhysicalDeviceFeatures2 supportedFeatures2{};
+            supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures2.pNext = &vulkan12Features;
+            vkGetPhysicalDeviceFeatures2(mPhysicalDevice,&supportedFeatures2);
+            mDrawIndirectCountSupported = vulkan12Features.drawIndirectCount == VK_TRUE;
+            VkBool32 drawIndirectCount = vulkan12Features.drawIndirectCount;
+            vulkan12Features = VkPhysicalDeviceVulkan12Features{};
+            vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+            vulkan12Features.drawIndirectCount = drawIndirectCount;
+        }
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = properties.apiVersion >= VK_API_VERSION_1_2 ? &vulkan12Features : nullptr;
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(mDeviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = mDeviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
         if(mConfig.enableValidationLayer){
             createInfo.enabledLayerCount = static_cast<uint32_t>(mValidationLayers.size());
@@ -343,8 +745,21 @@ namespace ProjectJ{
         }
         VK_CHECK(vkCreateDevice(mPhysicalDevice,&createInfo,nullptr,&mDevice),"failed to create logical device.");
     }
+    VkFormat VulkanRHI::PFindDepthFormat() const{
+        // D32 first, reverse-Z needs float depth to pay off.
+        for(VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT}){
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(mPhysicalDevice,format,&properties);
+            if(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT){
+                return format;
+            }
+        }
+        throw std::runtime_error("failed to find a depth format.");
+    }
     void VulkanRHI::PCreateRenderPass(){
-        VkAttachmentDescription colorAttachment{};
+        bool hasDepth = mDepthFormat != VK_FORMAT_UNDEFINED;
+        std::array<VkAttachmentDescription, 2> attachments{};
+        VkAttachmentDescription& colorAttachment = attachments[0];
         colorAttachment.format = mSwapChain->GetFormat();
         colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
@@ -352,80 +767,163 @@ namespace ProjectJ{
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        colorAttachment.finalLayout = mSwapChain->GetFinalLayout();
 
         VkAttachmentReference colorAttachmentRef{};
         colorAttachmentRef.attachment = 0;
         colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+        // depth only lives within the pass unless the depth pyramid is reduced from it afterwards.
+        bool depthPyramid = mDepthPyramidShader != nullptr;
+        VkAttachmentDescription& depthAttachment = attachments[1];
+        depthAttachment.format = mDepthFormat;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = depthPyramid ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = depthPyramid ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depthAttachmentRef{};
+        depthAttachmentRef.attachment = 1;
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
         VkSubpassDescription subpass{};
         subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &colorAttachmentRef;
+        subpass.pDepthStencilAttachment = hasDepth ? &depthAttachmentRef : nullptr;
 
-        VkSubpassDependency dependency{};
+        std::array<VkSubpassDependency, 2> dependencies{};
+        VkSubpassDependency& dependency = dependencies[0];
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.dstSubpass = 0;
         dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
         dependency.srcAccessMask = 0;
         dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
         dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        if(hasDepth){
+            // every framebuffer shares the depth image, the previous frame's tests must finish before the clear.
+            dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        }
+        if(depthPyramid){
+            // and so must the previous frame's pyramid pass sampling it.
+            dependency.srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        }
+
+        // color writes (and the final layout transition) must be done before the frame is read back.
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        if(depthPyramid){
+            // depth writes (and the transition to read only) before the pyramid pass samples it.
+            dependencies[1].srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependencies[1].srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependencies[1].dstStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            dependencies[1].dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
+        }
         
         VkRenderPassCreateInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount = 1;
-        renderPassInfo.pAttachments = &colorAttachment;
+        renderPassInfo.attachmentCount = hasDepth ? 2 : 1;
+        renderPassInfo.pAttachments = attachments.data();
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
         VK_CHECK(vkCreateRenderPass(mDevice,&renderPassInfo,nullptr,&mRenderPass),"failed to create render pass.");
     }
     void VulkanRHI::PCreateGraphicsPipeline(){
+        J_PROFILE_FUNCTION();
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = 1;
-        pipelineLayoutInfo.pSetLayouts = &mTestShader->GetDescriptorSetLayout();
+        pipelineLayoutInfo.pSetLayouts = mConfig.enableInstancing ? &mInstancedShader->GetDescriptorSetLayout() : &mTestShader->GetDescriptorSetLayout();
         pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
         pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
 
         VK_CHECK(vkCreatePipelineLayout(mDevice,&pipelineLayoutInfo,nullptr,&mPipelineLayout),"failed to create pipeline layout");
-
+        mGraphicPipeline = std::make_shared<VulkanPSO>(mRenderPass,mDevice,GetDefaultPSODesc());
+        if(mConfig.enableDepthPrepass){
+            mDepthPrepassPipeline = std::make_shared<VulkanPSO>(mRenderPass,mDevice,GetDepthPrepassPSODesc());
+        }
+    }
+    VulkanPSODesc VulkanRHI::GetDefaultPSODesc() const{
         VulkanPSODesc desc{};
-        desc.vertexShaderPath = "shaders/vert.spv";
-        desc.fragmentShaderPath = "shaders/frag.spv";
-        desc.attributeStride = sizeof(Vertex);
-        desc.attributeDescriptions.resize(3);
-        desc.attributeDescriptions[0].binding = 0;
-        desc.attributeDescriptions[0].location = 0;
-        desc.attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        desc.attributeDescriptions[0].offset = offsetof(Vertex,pos);
-
-        desc.attributeDescriptions[1].binding = 0;
-        desc.attributeDescriptions[1].location = 1;
-        desc.attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        desc.attributeDescriptions[1].offset = offsetof(Vertex,color);
-        
-        desc.attributeDescriptions[2].binding = 0;
-        desc.attributeDescriptions[2].location = 2;
-        desc.attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        desc.attributeDescriptions[2].offset = offsetof(Vertex,texCoord);
-
+        desc.vertexShaderPath = mConfig.enableInstancing ? "shaders/vert_instanced.spv" : "shaders/vert.spv";
+        // the texture binding follows the shader's other bindings.
+        desc.fragmentShaderPath = mConfig.enableInstancing ? "shaders/frag_instanced.spv" : "shaders/frag.spv";
+        switch(mConfig.vertexEncoding){
+            case VertexEncoding::Float:
+                AddVertexStream<Vertex>(desc, 0);
+                break;
+            case VertexEncoding::Packed:
+                AddVertexStream<PackedVertex>(desc, 0);
+                break;
+            case VertexEncoding::PackedSplit:
+                AddVertexStream<PackedPosition>(desc, 0);
+                AddVertexStream<PackedAttributes>(desc, 1);
+                break;
+        }
         desc.extent = mSwapChain->GetExtent();
         desc.pipelineLayout = mPipelineLayout;
-        mGraphicPipeline = std::make_shared<VulkanPSO>(mRenderPass,mDevice,desc);
+        if(mDepthFormat != VK_FORMAT_UNDEFINED){
+            VkCompareOp compareOp = mConfig.reverseZ ? VK_COMPARE_OP_GREATER : VK_COMPARE_OP_LESS;
+            // after a pre-pass only the surviving fragment of each pixel matches the stored depth.
+            desc.depthStencil.depthTest = true;
+            desc.depthStencil.depthWrite = !mConfig.enableDepthPrepass;
+            desc.depthStencil.depthCompareOp = mConfig.enableDepthPrepass ? VK_COMPARE_OP_EQUAL : compareOp;
+        }
+        return desc;
+    }
+    VulkanPSODesc VulkanRHI::GetDepthPrepassPSODesc() const{
+        VulkanPSODesc desc{};
+        desc.vertexShaderPath = mConfig.enableInstancing ? "shaders/vert_instanced_depth.spv" : "shaders/vert_depth.spv";
+        switch(mConfig.vertexEncoding){
+            case VertexEncoding::Float:
+                AddVertexPositionStream<Vertex>(desc, 0);
+                break;
+            case VertexEncoding::Packed:
+                AddVertexPositionStream<PackedVertex>(desc, 0);
+                break;
+            case VertexEncoding::PackedSplit:
+                AddVertexStream<PackedPosition>(desc, 0);
+                break;
+        }
+        desc.extent = mSwapChain->GetExtent();
+        desc.pipelineLayout = mPipelineLayout;
+        desc.depthStencil.depthTest = true;
+        desc.depthStencil.depthWrite = true;
+        desc.depthStencil.depthCompareOp = mConfig.reverseZ ? VK_COMPARE_OP_GREATER : VK_COMPARE_OP_LESS;
+        desc.colorWrite = false;
+        return desc;
     }
     void VulkanRHI::PCreateFramebuffers(){
+        if(mDepthFormat != VK_FORMAT_UNDEFINED){
+            VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            if(mDepthPyramidShader){
+                usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            }
+            mDepthTarget = mRenderTargets->Acquire(mSwapChain->GetExtent().width, mSwapChain->GetExtent().height,
+                mDepthFormat, usage);
+        }
         mSwapChainFramebuffers.resize(mSwapChain->GetImageCount());
         for(size_t i = 0; i< mSwapChain->GetImageCount(); i++){
             VkImageView attachments[] = {
-                mSwapChain->GetImageViews()[i]
+                mSwapChain->GetImageViews()[i],
+                mDepthTarget ? mDepthTarget->GetView() : VK_NULL_HANDLE
             };
             VkFramebufferCreateInfo framebufferInfo{};
             framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
             framebufferInfo.renderPass = mRenderPass;
-            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.attachmentCount = mDepthTarget ? 2 : 1;
             framebufferInfo.pAttachments = attachments;
             framebufferInfo.width = mSwapChain->GetExtent().width;
             framebufferInfo.height = mSwapChain->GetExtent().height;
@@ -434,64 +932,104 @@ namespace ProjectJ{
             
         }
     }
-    void VulkanRHI::PCreateVertexBuffer(){
-        mVertexBuffer = std::make_unique<VulkanVertexBuffer>((void*)vertices.data(), sizeof(vertices[0]) * vertices.size());
-    }
-    void VulkanRHI::PCreateIndexBuffer(){
-        mIndexBuffer = std::make_unique<VulkanIndexBuffer>((void*)indices.data(), sizeof(indices[0]) * indices.size());
+    void VulkanRHI::PCreateMeshBuffers(){
+        J_PROFILE_FUNCTION();
+        size_t vertexBytes = 0;
+        for(const auto& block : mMeshPool.GetBlocks()){
+            if(block.vertexEncoding == VertexEncoding::Float){
+                mVertexBuffers.push_back(std::make_unique<VulkanVertexBuffer>(*this, (void*)block.vertices.data(), sizeof(Vertex) * block.vertices.size()));
+                vertexBytes += sizeof(Vertex) * block.vertices.size();
+            }
+            else{
+                for(uint32_t stream = 0; stream < block.GetVertexStreamCount(); stream++){
+                    mVertexBuffers.push_back(std::make_unique<VulkanVertexBuffer>(*this, (void*)block.vertexStreams[stream].data(), block.vertexStreams[stream].size()));
+                    vertexBytes += block.vertexStreams[stream].size();
+                }
+            }
+            mIndexBuffers.push_back(std::make_unique<VulkanIndexBuffer>(*this, (void*)block.indices.data(), block.indices.size()));
+        }
+        JLOG_INFO("{} vertex encoding, {} KB of vertices", ToString(mMeshPool.GetVertexEncoding()), vertexBytes / 1024);
     }
     void VulkanRHI::PCreateUniformBuffer(){
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-        mUniformBuffers.resize(mSwapChain->GetImageCount());
+        if(mConfig.enableInstancing){
+            for(size_t i = 0; i < mSwapChain->GetImageCount(); i++){
+                mViewBuffers.push_back(std::make_shared<VulkanDynamicUniformBuffer<ViewUniformBufferObject> >(*this, 1, VK_SHADER_STAGE_VERTEX_BIT));
+                if(mGPUCullShader){
+                    // instances and draws come from the culling passes instead.
+                    continue;
+                }
+                mInstanceBuffers.push_back(std::make_shared<VulkanStorageBuffer<InstanceData> >(*this, mObjects.size(), VK_SHADER_STAGE_VERTEX_BIT));
+                mIndirectBuffers.push_back(std::make_unique<VulkanIndirectBuffer>(*this, mDrawBatches.size()));
+            }
+            return;
+        }
+        mObjectBuffers.resize(mSwapChain->GetImageCount());
         
         for(size_t i = 0; i < mSwapChain->GetImageCount(); i++){
-            mUniformBuffers[i] = std::make_unique<VulkanUniformBuffer<UniformBufferObject> >(VK_SHADER_STAGE_VERTEX_BIT);
+            mObjectBuffers[i] = std::make_unique<VulkanDynamicUniformBuffer<UniformBufferObject> >(*this, mObjects.size(), VK_SHADER_STAGE_VERTEX_BIT);
         }
     }
-    void VulkanRHI::PCreateTextureSampler(){
+    void VulkanRHI::PCreateTextures(const Scene& scene){
+        J_PROFILE_FUNCTION();
         VulkanSamplerDesc desc{};
         desc.magFilter = VK_FILTER_LINEAR;
         desc.minFilter = VK_FILTER_LINEAR;
         desc.u = desc.v = desc.w = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        mTextureSampler = TextureLoader::CreateTexSamplerFromPath("textures/texture.jpg", desc, VK_SHADER_STAGE_FRAGMENT_BIT);
+        // files decode in parallel, the uploads go through the one queue and stay serial.
+        std::vector<DecodedImage> images(scene.textures.size());
+        JobSystem::Get().ParallelFor(static_cast<uint32_t>(scene.textures.size()), [&](uint32_t i){
+            if(!scene.textures[i].path.empty()){
+                images[i] = DecodeImage(scene.textures[i].path);
+            }
+        });
+        for(size_t i = 0; i < scene.textures.size(); i++){
+            const SceneTexture& texture = scene.textures[i];
+            if(!texture.path.empty()){
+                mTextures.push_back(TextureLoader::CreateTexSamplerFromPixels(*this, images[i].pixels.get(), images[i].width, images[i].height, desc, VK_SHADER_STAGE_FRAGMENT_BIT));
+                images[i] = DecodedImage();
+            }
+            else{
+                mTextures.push_back(TextureLoader::CreateTexSamplerFromPixels(*this, texture.pixels.data(), texture.width, texture.height, desc, VK_SHADER_STAGE_FRAGMENT_BIT));
+            }
+        }
     }
     void VulkanRHI::PCreateDescriptorSet(){
-        std::vector<VkDescriptorSetLayout> layouts(mSwapChain->GetImageCount(),mTestShader->GetDescriptorSetLayout());
+        size_t materialCount = mMaterials.size();
+        size_t setCount = mSwapChain->GetImageCount() * materialCount;
+        if(setCount == 0){
+            return;
+        }
+        const VulkanShaderBase& shader = mConfig.enableInstancing ? static_cast<const VulkanShaderBase&>(*mInstancedShader) : *mTestShader;
+        std::vector<VkDescriptorSetLayout> layouts(setCount,shader.GetDescriptorSetLayout());
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = mTestShader->GetDescriptorPool();
-        allocInfo.descriptorSetCount = static_cast<uint32_t>(mSwapChain->GetImageCount());
+        allocInfo.descriptorPool = shader.GetDescriptorPool();
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(setCount);
         allocInfo.pSetLayouts = layouts.data();
         
-        mDescriptorSets.resize(mSwapChain->GetImageCount());
+        mDescriptorSets.resize(setCount);
         VK_CHECK(vkAllocateDescriptorSets(mDevice,&allocInfo,mDescriptorSets.data()),"failed to allocate descriptor sets");
-        for(size_t i = 0; i < mSwapChain->GetImageCount(); i++){
-            VkDescriptorBufferInfo bufferInfo = mUniformBuffers[i]->GetBufferInfo();
-            VkDescriptorImageInfo imageInfo = mTextureSampler->GetImageInfo();
-
-            std::array<VkWriteDescriptorSet, 2> descriptorWrite{};
-            
-            descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrite[0].dstSet = mDescriptorSets[i];
-            descriptorWrite[0].dstBinding = 0;
-            descriptorWrite[0].dstArrayElement = 0;
-            descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrite[0].descriptorCount = 1;
-            descriptorWrite[0].pBufferInfo = &bufferInfo;
-            descriptorWrite[0].pImageInfo = nullptr; // Optional
-            descriptorWrite[0].pTexelBufferView = nullptr; // Optional
-            
-            descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrite[1].dstSet = mDescriptorSets[i];
-            descriptorWrite[1].dstBinding = 1;
-            descriptorWrite[1].dstArrayElement = 0;
-            descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptorWrite[1].descriptorCount = 1;
-            descriptorWrite[1].pImageInfo = &imageInfo; // Optional
-            vkUpdateDescriptorSets(mDevice, descriptorWrite.size(), descriptorWrite.data(), 0, nullptr);
+        // the infos in ShaderParam order, every set one templated update.
+        if(mConfig.enableInstancing){
+            InstancedShader::DescriptorData data;
+            for(size_t i = 0; i < setCount; i++){
+                data[0].buffer = mViewBuffers[i / materialCount]->GetBufferInfo();
+                data[1].buffer = mGPUCullShader ? mCulledInstanceBuffers[i / materialCount]->GetBufferInfo()
+                    : mInstanceBuffers[i / materialCount]->GetBufferInfo();
+                data[2].image = mTextures[mMaterials[i % materialCount].textureIndex]->GetImageInfo();
+                mInstancedShader->UpdateDescriptorSet(mDescriptorSets[i], data);
+            }
+            return;
+        }
+        TestShader::DescriptorData data;
+        for(size_t i = 0; i < setCount; i++){
+            data[0].buffer = mObjectBuffers[i / materialCount]->GetBufferInfo();
+            data[1].image = mTextures[mMaterials[i % materialCount].textureIndex]->GetImageInfo();
+            mTestShader->UpdateDescriptorSet(mDescriptorSets[i], data);
         }
     }
     void VulkanRHI::PPrepareCommandBuffers(){
+        J_PROFILE_FUNCTION();
         // mTestCommandBuffer->BeginRenderPass();
         mTestCommandBuffer->BindShader(mTestShader.get());
         auto p = ShaderParam<TestShader>{};
@@ -503,6 +1041,10 @@ namespace ProjectJ{
             beginInfo.flags = 0;
             beginInfo.pInheritanceInfo = nullptr;
             VK_CHECK(vkBeginCommandBuffer(commandBuffer,&beginInfo),"failed to begin recoreding command buffer.");
+            mGPUProfiler->ResetQueries(commandBuffer,index);
+            if(mGPUCullShader){
+                PRecordGPUCulling(commandBuffer,index);
+            }
 
             VkRenderPassBeginInfo renderPassInfo{};
             renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -510,25 +1052,315 @@ namespace ProjectJ{
             renderPassInfo.framebuffer = mSwapChainFramebuffers[index];
             renderPassInfo.renderArea.offset = {0,0};
             renderPassInfo.renderArea.extent = mSwapChain->GetExtent();
-            VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-            renderPassInfo.clearValueCount = 1;
-            renderPassInfo.pClearValues = &clearColor;
-            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-       
-            //vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
-            mGraphicPipeline->Bind(commandBuffer);
-
-            VkBuffer vertexBuffers[] = {mVertexBuffer->mBuffer};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffer,0,1,vertexBuffers,offsets);
-            vkCmdBindIndexBuffer(commandBuffer,mIndexBuffer->mBuffer,0,VK_INDEX_TYPE_UINT16);
-
-            vkCmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,mPipelineLayout,0,1,&mDescriptorSets[index],0,nullptr);
-            vkCmdDrawIndexed(commandBuffer,static_cast<uint32_t>(indices.size()),1,0,0,0);
-            vkCmdEndRenderPass(commandBuffer);
+            std::array<VkClearValue, 2> clearValues{};
+            clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+            // the far plane.
+            clearValues[1].depthStencil = {mConfig.reverseZ ? 0.0f : 1.0f, 0};
+            renderPassInfo.clearValueCount = mDepthTarget ? 2 : 1;
+            renderPassInfo.pClearValues = clearValues.data();
+            {
+                ScopedGPUTimer mainPassTimer(*mGPUProfiler,commandBuffer,index,"MainPass");
+                vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+                if(mDepthPrepassPipeline){
+                    ScopedGPUTimer prepassTimer(*mGPUProfiler,commandBuffer,index,"DepthPrepass");
+                    mDepthPrepassPipeline->Bind(commandBuffer);
+                    PRecordDraws(commandBuffer, index, true);
+                }
+           
+                //vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+                mGraphicPipeline->Bind(commandBuffer);
+                PRecordDraws(commandBuffer, index, false);
+                vkCmdEndRenderPass(commandBuffer);
+            }
+            if(mDepthPyramidShader){
+                PRecordDepthPyramid(commandBuffer,index);
+            }
+            if(mReadback){
+                mReadback->RecordCopy(commandBuffer,index,mSwapChain->GetImage(index),mSwapChain->GetFinalLayout());
+            }
 
             VK_CHECK(vkEndCommandBuffer(commandBuffer),"failed to record command buffer.");
         };
         mQueue->PrepareFrameCommands(prepareFunc);
     }
+    void VulkanRHI::PRecordDraws(VkCommandBuffer commandBuffer, uint32_t image, bool positionOnly){
+        if(mConfig.enableInstancing){
+            PRecordInstancedDraws(commandBuffer, image, positionOnly);
+            return;
+        }
+        const auto& objectBuffer = *mObjectBuffers[image];
+        uint32_t boundBlock = UINT32_MAX;
+        for(size_t i = 0; i < mObjects.size(); i++){
+            const MeshRange& range = mMeshPool.GetRange(mObjects[i].meshIndex);
+            // objects are sorted by block, this runs once per block.
+            if(range.block != boundBlock){
+                boundBlock = range.block;
+                PBindMeshBlock(commandBuffer, boundBlock, positionOnly);
+            }
+            VkDescriptorSet set = mDescriptorSets[image * mMaterials.size() + mObjects[i].materialIndex];
+            uint32_t dynamicOffset = objectBuffer.GetDynamicOffset(i);
+            vkCmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,mPipelineLayout,0,1,&set,1,&dynamicOffset);
+            vkCmdDrawIndexed(commandBuffer,range.indexCount,1,range.firstIndex,range.vertexOffset,0);
+        }
+    }
+    void VulkanRHI::PBindMeshBlock(VkCommandBuffer commandBuffer, uint32_t block, bool positionOnly){
+        uint32_t streamCount = mMeshPool.GetBlocks()[block].GetVertexStreamCount();
+        // the position is stream 0 of split encodings and part of the one stream otherwise.
+        uint32_t boundStreams = positionOnly ? 1 : streamCount;
+        VkBuffer vertexBuffers[2];
+        VkDeviceSize offsets[2] = {0, 0};
+        for(uint32_t stream = 0; stream < boundStreams; stream++){
+            vertexBuffers[stream] = mVertexBuffers[block * streamCount + stream]->mBuffer;
+        }
+        vkCmdBindVertexBuffers(commandBuffer,0,boundStreams,vertexBuffers,offsets);
+        VkIndexType indexType = mMeshPool.GetBlocks()[block].indexType == MeshIndexType::UInt32 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+        vkCmdBindIndexBuffer(commandBuffer,mIndexBuffers[block]->mBuffer,0,indexType);
+    }
+    void VulkanRHI::PRecordInstancedDraws(VkCommandBuffer commandBuffer, uint32_t image, bool positionOnly){
+        // the commands themselves are written every frame, see Draw and PRecordGPUCulling; only their buffer is recorded here.
+        VkBuffer indirectBuffer = mGPUCullShader ? mCulledDrawBuffers[image]->mBuffer : mIndirectBuffers[image]->mBuffer;
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        uint32_t boundBlock = UINT32_MAX;
+        // batches are sorted by block then material, each run sharing both goes out in one call.
+        for(size_t run = 0; run + 1 < mDrawRuns.size(); run++){
+            size_t first = mDrawRuns[run];
+            size_t end = mDrawRuns[run + 1];
+            const DrawBatch& batch = mDrawBatches[first];
+            uint32_t block = mMeshPool.GetRange(batch.meshIndex).block;
+            if(block != boundBlock){
+                boundBlock = block;
+                PBindMeshBlock(commandBuffer, boundBlock, positionOnly);
+            }
+            VkDescriptorSet set = mDescriptorSets[image * mMaterials.size() + batch.materialIndex];
+            uint32_t dynamicOffset = 0;
+            vkCmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,mPipelineLayout,0,1,&set,1,&dynamicOffset);
+            if(mGPUCullShader){
+                // only the batches with visible instances, compacted to the front of the run's range.
+                vkCmdDrawIndexedIndirectCount(commandBuffer,indirectBuffer,first * stride,mDrawCountBuffers[image]->mBuffer,
+                    run * sizeof(uint32_t),static_cast<uint32_t>(end - first),stride);
+            }
+            else if(mMultiDrawIndirectSupported && mIndirectFirstInstanceSupported){
+                vkCmdDrawIndexedIndirect(commandBuffer,indirectBuffer,first * stride,static_cast<uint32_t>(end - first),stride);
+            }
+            else if(mIndirectFirstInstanceSupported){
+                for(size_t b = first; b < end; b++){
+                    vkCmdDrawIndexedIndirect(commandBuffer,indirectBuffer,b * stride,1,stride);
+                }
+            }
+            else{
+                // indirect draws would all start at instance 0, the batches never change so draw them directly.
+                for(size_t b = first; b < end; b++){
+                    const MeshRange& range = mMeshPool.GetRange(mDrawBatches[b].meshIndex);
+                    vkCmdDrawIndexed(commandBuffer,range.indexCount,mDrawBatches[b].objectCount,range.firstIndex,range.vertexOffset,mDrawBatches[b].firstObject);
+                }
+            }
+        }
+    }
+
+    void VulkanRHI::PCreateGPUCulling(){
+        J_PROFILE_FUNCTION();
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &mGPUCullShader->GetDescriptorSetLayout();
+        VK_CHECK(vkCreatePipelineLayout(mDevice,&pipelineLayoutInfo,nullptr,&mCullPipelineLayout),"failed to create culling pipeline layout");
+        VulkanComputePSODesc desc{};
+        desc.pipelineLayout = mCullPipelineLayout;
+        desc.computeShaderPath = "shaders/cull.spv";
+        mCullPipeline = std::make_unique<VulkanComputePSO>(mDevice, desc);
+        desc.computeShaderPath = "shaders/cull_compact.spv";
+        mCompactPipeline = std::make_unique<VulkanComputePSO>(mDevice, desc);
+
+        // batches never change; objects get their world matrix and bounds again in Draw whenever they moved.
+        ComputeObjectBounds(mObjects, mMeshPool, mBounds);
+        std::vector<GPUCullObject> objects(mObjects.size());
+        std::vector<GPUCullBatch> batches(mDrawBatches.size());
+        for(uint32_t run = 0; run + 1 < mDrawRuns.size(); run++){
+            for(uint32_t b = mDrawRuns[run]; b < mDrawRuns[run + 1]; b++){
+                const DrawBatch& batch = mDrawBatches[b];
+                const MeshRange& range = mMeshPool.GetRange(batch.meshIndex);
+                batches[b].command.indexCount = range.indexCount;
+                batches[b].command.instanceCount = 0;
+                batches[b].command.firstIndex = range.firstIndex;
+                batches[b].command.vertexOffset = range.vertexOffset;
+                batches[b].command.firstInstance = batch.firstObject;
+                batches[b].run = run;
+                batches[b].runFirst = mDrawRuns[run];
+                for(uint32_t i = batch.firstObject; i < batch.firstObject + batch.objectCount; i++){
+                    objects[i].model = mObjects[i].model;
+                    objects[i].bounds = glm::vec4(mBounds.centerX[i], mBounds.centerY[i], mBounds.centerZ[i], mBounds.radius[i]);
+                    objects[i].positionOffset = range.positionOffset;
+                    objects[i].positionScale = range.positionScale;
+                    objects[i].batch = b;
+                }
+            }
+        }
+        mCullBatchBuffer = std::make_shared<VulkanDeviceBuffer>(*this, batches.data(), sizeof(GPUCullBatch) * batches.size(),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryTag::Storage);
+
+        size_t imageCount = mSwapChain->GetImageCount();
+        size_t runCount = mDrawRuns.size() - 1;
+        for(size_t i = 0; i < imageCount; i++){
+            // host visible so moved objects are rewritten in place, the static fields are set here once.
+            mCullObjectBuffers.push_back(std::make_shared<VulkanStorageBuffer<GPUCullObject> >(*this, mObjects.size(), VK_SHADER_STAGE_COMPUTE_BIT));
+            std::copy(objects.begin(), objects.end(), &mCullObjectBuffers.back()->At(0));
+            mCullBuffers.push_back(std::make_shared<VulkanDynamicUniformBuffer<CullUniformBufferObject> >(*this, 1, VK_SHADER_STAGE_COMPUTE_BIT));
+            CullUniformBufferObject& cull = mCullBuffers.back()->At(0);
+            cull.objectCount = static_cast<uint32_t>(mObjects.size());
+            cull.batchCount = static_cast<uint32_t>(mDrawBatches.size());
+            // the level count goes up from the second frame on, see Draw.
+            cull.pyramidLevelCount = 0;
+            cull.reverseZ = mConfig.reverseZ ? 1 : 0;
+            cull.depthWidth = mSwapChain->GetExtent().width;
+            cull.depthHeight = mSwapChain->GetExtent().height;
+            for(size_t level = 0; level < mDepthPyramidLevels.size(); level++){
+                const DepthPyramidLevel& pyramidLevel = mDepthPyramidLevels[level];
+                cull.pyramidLevels[level] = glm::uvec4(pyramidLevel.dstOffset, pyramidLevel.dstSize.x, pyramidLevel.dstSize.y, 0);
+            }
+            mCulledInstanceBuffers.push_back(std::make_shared<VulkanDeviceBuffer>(*this, sizeof(InstanceData) * mObjects.size(),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryTag::Storage));
+            mBatchCountBuffers.push_back(std::make_shared<VulkanDeviceBuffer>(*this, sizeof(uint32_t) * mDrawBatches.size(),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VulkanMemoryTag::Storage));
+            mCulledDrawBuffers.push_back(std::make_shared<VulkanDeviceBuffer>(*this, sizeof(VkDrawIndexedIndirectCommand) * mDrawBatches.size(),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VulkanMemoryTag::Indirect));
+            mDrawCountBuffers.push_back(std::make_shared<VulkanDeviceBuffer>(*this, sizeof(uint32_t) * runCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VulkanMemoryTag::Indirect));
+        }
+
+        mCullMovedObjects.Init(static_cast<uint32_t>(imageCount), static_cast<uint32_t>(mObjects.size()));
+
+        std::vector<VkDescriptorSetLayout> layouts(imageCount,mGPUCullShader->GetDescriptorSetLayout());
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = mGPUCullShader->GetDescriptorPool();
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(imageCount);
+        allocInfo.pSetLayouts = layouts.data();
+        mCullDescriptorSets.resize(imageCount);
+        VK_CHECK(vkAllocateDescriptorSets(mDevice,&allocInfo,mCullDescriptorSets.data()),"failed to allocate culling descriptor sets");
+        GPUCullShader::DescriptorData data;
+        for(size_t i = 0; i < imageCount; i++){
+            // binding order of ShaderParam<GPUCullShader>.
+            data[0].buffer = mCullBuffers[i]->GetBufferInfo();
+            data[1].buffer = mCullObjectBuffers[i]->GetBufferInfo();
+            data[2].buffer = mCullBatchBuffer->GetBufferInfo();
+            data[3].buffer = mCulledInstanceBuffers[i]->GetBufferInfo();
+            data[4].buffer = mBatchCountBuffers[i]->GetBufferInfo();
+            data[5].buffer = mCulledDrawBuffers[i]->GetBufferInfo();
+            data[6].buffer = mDrawCountBuffers[i]->GetBufferInfo();
+            // without occlusion culling cull.spv never reads the pyramid, any storage buffer keeps the set valid.
+            data[7].buffer = mDepthPyramidBuffer ? mDepthPyramidBuffer->GetBufferInfo() : mCullBatchBuffer->GetBufferInfo();
+            mGPUCullShader->UpdateDescriptorSet(mCullDescriptorSets[i], data);
+        }
+        JLOG_INFO("GPU culling {} objects into {} batches in {} runs", mObjects.size(), mDrawBatches.size(), runCount);
+    }
+    void VulkanRHI::PRecordGPUCulling(VkCommandBuffer commandBuffer, uint32_t image){
+        ScopedGPUTimer cullTimer(*mGPUProfiler,commandBuffer,image,"GPUCulling");
+        // the counters start from zero every frame, the previous use of this image's buffers has completed.
+        // The previous frame's pyramid writes are waited on along with the fills.
+        vkCmdFillBuffer(commandBuffer,mBatchCountBuffers[image]->mBuffer,0,VK_WHOLE_SIZE,0);
+        vkCmdFillBuffer(commandBuffer,mDrawCountBuffers[image]->mBuffer,0,VK_WHOLE_SIZE,0);
+        auto barrier = [commandBuffer](VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess){
+            VkMemoryBarrier memoryBarrier{};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.srcAccessMask = srcAccess;
+            memoryBarrier.dstAccessMask = dstAccess;
+            vkCmdPipelineBarrier(commandBuffer,srcStage,dstStage,0,1,&memoryBarrier,0,nullptr,0,nullptr);
+        };
+        barrier(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        constexpr uint32_t groupSize = 64;
+        uint32_t dynamicOffset = 0;
+        vkCmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_COMPUTE,mCullPipelineLayout,0,1,&mCullDescriptorSets[image],1,&dynamicOffset);
+        mCullPipeline->Bind(commandBuffer);
+        vkCmdDispatch(commandBuffer,(static_cast<uint32_t>(mObjects.size()) + groupSize - 1) / groupSize,1,1);
+        barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        mCompactPipeline->Bind(commandBuffer);
+        vkCmdDispatch(commandBuffer,(static_cast<uint32_t>(mDrawBatches.size()) + groupSize - 1) / groupSize,1,1);
+        barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+    }
+    void VulkanRHI::PCreateDepthPyramid(){
+        J_PROFILE_FUNCTION();
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DepthPyramidLevel);
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &mDepthPyramidShader->GetDescriptorSetLayout();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        VK_CHECK(vkCreatePipelineLayout(mDevice,&pipelineLayoutInfo,nullptr,&mDepthPyramidPipelineLayout),"failed to create depth pyramid pipeline layout");
+        VulkanComputePSODesc desc{};
+        desc.pipelineLayout = mDepthPyramidPipelineLayout;
+        desc.computeShaderPath = "shaders/depth_pyramid.spv";
+        mDepthPyramidPipeline = std::make_unique<VulkanComputePSO>(mDevice, desc);
+
+        // halving with the odd texel kept down to 1x1, the levels packed one after another.
+        glm::uvec2 srcSize(mSwapChain->GetExtent().width, mSwapChain->GetExtent().height);
+        uint32_t srcOffset = 0;
+        uint32_t dstOffset = 0;
+        while(mDepthPyramidLevels.size() < MAX_DEPTH_PYRAMID_LEVELS){
+            DepthPyramidLevel level{};
+            level.srcOffset = srcOffset;
+            level.dstOffset = dstOffset;
+            level.srcSize = srcSize;
+            level.dstSize = glm::uvec2(std::max(1u, (srcSize.x + 1) / 2), std::max(1u, (srcSize.y + 1) / 2));
+            level.fromDepth = mDepthPyramidLevels.empty() ? 1 : 0;
+            level.reverseZ = mConfig.reverseZ ? 1 : 0;
+            mDepthPyramidLevels.push_back(level);
+            srcOffset = dstOffset;
+            dstOffset += level.dstSize.x * level.dstSize.y;
+            srcSize = level.dstSize;
+            if(srcSize.x == 1 && srcSize.y == 1){
+                break;
+            }
+        }
+        mDepthPyramidBuffer = std::make_shared<VulkanDeviceBuffer>(*this, sizeof(float) * dstOffset,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryTag::Storage);
+        // read with texelFetch, the filter never applies.
+        mDepthSampler = std::make_unique<VulkanSampler>(*this, VulkanSamplerDesc{VK_FILTER_NEAREST, VK_FILTER_NEAREST,
+            VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE});
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = mDepthPyramidShader->GetDescriptorPool();
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &mDepthPyramidShader->GetDescriptorSetLayout();
+        VK_CHECK(vkAllocateDescriptorSets(mDevice,&allocInfo,&mDepthPyramidDescriptorSet),"failed to allocate depth pyramid descriptor set");
+        // binding order of ShaderParam<DepthPyramidShader>; one set, every image shares the depth target.
+        DepthPyramidShader::DescriptorData data;
+        data[0].image.sampler = mDepthSampler->GetSampler();
+        data[0].image.imageView = mDepthTarget->GetView();
+        data[0].image.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        data[1].buffer = mDepthPyramidBuffer->GetBufferInfo();
+        mDepthPyramidShader->UpdateDescriptorSet(mDepthPyramidDescriptorSet, data);
+        JLOG_INFO("occlusion culling against a {} level depth pyramid of {} texels", mDepthPyramidLevels.size(), dstOffset);
+    }
+    void VulkanRHI::PRecordDepthPyramid(VkCommandBuffer commandBuffer, uint32_t image){
+        ScopedGPUTimer pyramidTimer(*mGPUProfiler,commandBuffer,image,"DepthPyramid");
+        // the render pass' external dependency covers the depth, this frame's culling must be done reading the pyramid.
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,0,1,&memoryBarrier,0,nullptr,0,nullptr);
+        vkCmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_COMPUTE,mDepthPyramidPipelineLayout,0,1,&mDepthPyramidDescriptorSet,0,nullptr);
+        mDepthPyramidPipeline->Bind(commandBuffer);
+        constexpr uint32_t groupSize = 8;
+        for(size_t level = 0; level < mDepthPyramidLevels.size(); level++){
+            const DepthPyramidLevel& pyramidLevel = mDepthPyramidLevels[level];
+            if(level > 0){
+                // each level reads the one before.
+                memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                vkCmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,0,1,&memoryBarrier,0,nullptr,0,nullptr);
+            }
+            vkCmdPushConstants(commandBuffer,mDepthPyramidPipelineLayout,VK_SHADER_STAGE_COMPUTE_BIT,0,sizeof(DepthPyramidLevel),&pyramidLevel);
+            vkCmdDispatch(commandBuffer,(pyramidLevel.dstSize.x + groupSize - 1) / groupSize,(pyramidLevel.dstSize.y + groupSize - 1) / groupSize,1);
+        }
+    }
 }
@@ -5,13 +5,23 @@
 #include "VulkanResources.h"
 #include "VulkanCommand.h"
 #include "VulkanShader.h"
+#include "VulkanProfiler.h"
+#include "VulkanMemoryTracker.h"
+#include "VulkanReadback.h"
+#include "core/FrameArena.h"
+#include "core/FramePacket.h"
+#include "core/RenderConfig.h"
+#include "core/Scene.h"
+#include "core/Lod.h"
+#include "core/SceneGraph.h"
+#include "core/Visibility.h"
 #include <optional>
+#include <chrono>
 
 namespace ProjectJ{
     class RHI;
-    struct VulkanConfig{
-        bool enableValidationLayer;
-        J_WINDOW_HANDLE window;
+    // every option is shared with the other backends, see RenderConfig.
+    struct VulkanConfig : RenderConfig{
     };
     class VulkanRHI{
         friend class VulkanBufferBase;
@@ -19,11 +29,43 @@ namespace ProjectJ{
         friend class VulkanTexture;
         friend class VulkanQueue;
         friend class VulkanSampler;
-        template<typename> friend class VulkanShader;
+        friend class VulkanGPUProfiler;
+        friend class VulkanShaderBase;
     public:
         VulkanRHI(const VulkanConfig& config);
+        // cleans up if still initialized.
         ~VulkanRHI();
+        VulkanRHI(const VulkanRHI&) = delete;
+        VulkanRHI& operator=(const VulkanRHI&) = delete;
+        // animates by the backend's own clock, or fixedTimeStep.
         void Draw();
+        // renders what the simulation decided for the frame: its time and scene graph changes.
+        void Draw(const FramePacket& packet);
+        VulkanGPUProfiler& GetGPUProfiler() {return *mGPUProfiler;}
+        VulkanMemoryTracker& GetMemoryTracker() {return *mMemoryTracker;}
+        void SetReadbackCallback(ReadbackCallback callback);
+        uint32_t GetDrawCallCount() const {return static_cast<uint32_t>(mObjects.size());}
+        const std::string& GetDeviceName() const {return mDeviceName;}
+        VulkanQueue& GetQueue() {return *mQueue;}
+        VkDevice GetDevice() const {return mDevice;}
+        VkRenderPass GetRenderPass() const {return mRenderPass;}
+        // vertex layout, shaders and layout of the built-in pipeline.
+        VulkanPSODesc GetDefaultPSODesc() const;
+        // position only vertex layout and depth state of the pre-pass pipeline.
+        VulkanPSODesc GetDepthPrepassPSODesc() const;
+        TestShader& GetTestShader() {return *mTestShader;}
+        // backend neutral frame timings, see RenderBenchmark.
+        bool IsGPUTimingSupported() const {return mGPUProfiler->IsSupported();}
+        // latest completed MainPass, lags the current frame by the frames in flight.
+        double GetLastGPUFrameMs() const;
+        // MainPass samples collected so far, GetLastGPUFrameMs is a new one whenever this went up.
+        uint64_t GetGPUFrameSampleCount() const;
+        double GetLastFrameWaitMs() const {return mQueue->GetLastFenceWaitNs() / 1e6;}
+        // global LOD bias, see LodSelector::SetBias; no effect without enableLod.
+        void SetLodBias(float bias) {if(mLod) mLod->SetBias(bias);}
+        float GetLodBias() const {return mLod ? mLod->GetBias() : 0.0f;}
+        // the scene's transform hierarchy, nodes set here move their objects from the next Draw on.
+        SceneGraph& GetSceneGraph() {return mSceneGraph;}
     public:
         void Init();
         void Cleanup();
@@ -35,61 +77,137 @@ namespace ProjectJ{
         void PCreateSurface();
         void PPickPhysicalDevice();
         void PCreateLogicalDevice();
+        VkFormat PFindDepthFormat() const;
         void PCreateRenderPass();
         void PCreateGraphicsPipeline();
         void PCreateFramebuffers();
         void PCreateCommandPool();
-        void PCreateVertexBuffer();
-        void PCreateIndexBuffer();
+        void PCreateMeshBuffers();
         void PCreateUniformBuffer();
-        void PCreateTextureSampler();
+        void PCreateTextures(const Scene& scene);
         void PCreateDescriptorSet();
         void PPrepareCommandBuffers();
+        // every draw of the frame, binding only the position stream for the depth pre-pass.
+        void PRecordDraws(VkCommandBuffer commandBuffer, uint32_t image, bool positionOnly);
+        // applies the packet's transforms and propagates them, into the CPU side bounds of the objects that
+        // moved, and queues those for every image's GPU culling objects.
+        void PUpdateTransforms(const FramePacket& packet);
+        void PBindMeshBlock(VkCommandBuffer commandBuffer, uint32_t block, bool positionOnly);
+        void PRecordInstancedDraws(VkCommandBuffer commandBuffer, uint32_t image, bool positionOnly);
+        void PCreateGPUCulling();
+        void PRecordGPUCulling(VkCommandBuffer commandBuffer, uint32_t image);
+        void PCreateDepthPyramid();
+        // reduces the depth the main pass left into the pyramid the next frame's culling reads.
+        void PRecordDepthPyramid(VkCommandBuffer commandBuffer, uint32_t image);
 
         std::vector<const char*> HGetRequiredExtensions();
         VkDebugUtilsMessengerCreateInfoEXT HPopulateDebugMessengerCreateInfo() const;
     private:
         VulkanConfig mConfig;
-        VkInstance mInstance;
-        VkDebugUtilsMessengerEXT mDebugMessenger;
-        VkPhysicalDevice mPhysicalDevice;
-        VkDevice mDevice;
-        VkSurfaceKHR mSurface;
+        VkInstance mInstance = VK_NULL_HANDLE;
+        VkDebugUtilsMessengerEXT mDebugMessenger = VK_NULL_HANDLE;
+        VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+        VkDevice mDevice = VK_NULL_HANDLE;
+        VkSurfaceKHR mSurface = VK_NULL_HANDLE;
+        std::string mDeviceName;
         
         std::vector<VkFramebuffer> mSwapChainFramebuffers;
-        VkPipelineLayout mPipelineLayout;
-        VkRenderPass mRenderPass;
-        std::unique_ptr<VulkanVertexBuffer> mVertexBuffer;
-        std::unique_ptr<VulkanIndexBuffer> mIndexBuffer;
+        VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+        VkRenderPass mRenderPass = VK_NULL_HANDLE;
+        // VK_FORMAT_UNDEFINED without depth; one depth image shared by every framebuffer.
+        VkFormat mDepthFormat = VK_FORMAT_UNDEFINED;
+        std::unique_ptr<VulkanRenderTargetPool> mRenderTargets;
+        std::shared_ptr<VulkanTexture> mDepthTarget;
+        // [block * vertex stream count + stream], one index buffer per mesh pool block.
+        std::vector<std::unique_ptr<VulkanVertexBuffer> > mVertexBuffers;
+        std::vector<std::unique_ptr<VulkanIndexBuffer> > mIndexBuffers;
+        // [image * material count + material]
         std::vector<VkDescriptorSet> mDescriptorSets;
 
-        std::vector<std::unique_ptr<VulkanUniformBuffer<UniformBufferObject> > > mUniformBuffers;
-        std::shared_ptr<VulkanTextureSampler> mTextureSampler;
+        // one per swap chain image, one element per object.
+        std::vector<std::unique_ptr<VulkanDynamicUniformBuffer<UniformBufferObject> > > mObjectBuffers;
+        // instanced path instead of mObjectBuffers, one each per swap chain image.
+        std::vector<std::shared_ptr<VulkanDynamicUniformBuffer<ViewUniformBufferObject> > > mViewBuffers;
+        std::vector<std::shared_ptr<VulkanStorageBuffer<InstanceData> > > mInstanceBuffers;
+        // one command per draw batch, rewritten every frame.
+        std::vector<std::unique_ptr<VulkanIndirectBuffer> > mIndirectBuffers;
+        std::vector<DrawBatch> mDrawBatches;
+        // first batch of every run sharing block and material, then the batch count.
+        std::vector<uint32_t> mDrawRuns;
+        // with frustum culling, object bounds and this frame's visible objects in instance order.
+        BoundingSpheres mBounds;
+        std::unique_ptr<FrustumCuller> mCuller;
+        std::vector<uint32_t> mVisible;
+        // with LODs mDrawBatches are mLodBatches' per level batches.
+        std::unique_ptr<LodSelector> mLod;
+        LodDrawBatches mLodBatches;
+        std::chrono::high_resolution_clock::time_point mLastDrawTime;
+        std::vector<std::shared_ptr<VulkanTextureSampler> > mTextures;
+        std::vector<SceneMaterial> mMaterials;
+        // sorted by mesh block, then material; model in world space, the graph holds the local transforms.
+        std::vector<SceneObject> mObjects;
+        SceneGraph mSceneGraph;
         std::unique_ptr<TestShader> mTestShader;
+        std::unique_ptr<InstancedShader> mInstancedShader;
+        // GPU culling: batches uploaded once; per image objects, camera, instances and compacted draws.
+        std::unique_ptr<GPUCullShader> mGPUCullShader;
+        VkPipelineLayout mCullPipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<VulkanComputePSO> mCullPipeline;
+        std::unique_ptr<VulkanComputePSO> mCompactPipeline;
+        std::vector<std::shared_ptr<VulkanStorageBuffer<GPUCullObject> > > mCullObjectBuffers;
+        // by image, the objects moved since its objects were last written.
+        MovedObjectQueues mCullMovedObjects;
+        std::shared_ptr<VulkanDeviceBuffer> mCullBatchBuffer;
+        std::vector<std::shared_ptr<VulkanDynamicUniformBuffer<CullUniformBufferObject> > > mCullBuffers;
+        std::vector<std::shared_ptr<VulkanDeviceBuffer> > mCulledInstanceBuffers;
+        std::vector<std::shared_ptr<VulkanDeviceBuffer> > mBatchCountBuffers;
+        std::vector<std::shared_ptr<VulkanDeviceBuffer> > mCulledDrawBuffers;
+        std::vector<std::shared_ptr<VulkanDeviceBuffer> > mDrawCountBuffers;
+        std::vector<VkDescriptorSet> mCullDescriptorSets;
+        // occlusion culling: one pyramid after every frame's main pass, read by the next frame's culling.
+        std::unique_ptr<DepthPyramidShader> mDepthPyramidShader;
+        VkPipelineLayout mDepthPyramidPipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<VulkanComputePSO> mDepthPyramidPipeline;
+        std::unique_ptr<VulkanSampler> mDepthSampler;
+        std::shared_ptr<VulkanDeviceBuffer> mDepthPyramidBuffer;
+        std::vector<DepthPyramidLevel> mDepthPyramidLevels;
+        VkDescriptorSet mDepthPyramidDescriptorSet = VK_NULL_HANDLE;
+        // the camera of the last Draw, what the pyramid the next frame culls against was rendered with.
+        glm::mat4 mLastViewProj{1.0f};
 
         const std::vector<const char*> mValidationLayers = {
             "VK_LAYER_KHRONOS_validation"
         };
-        const std::vector<const char*> mDeviceExtensions = {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME
-        };
+        std::vector<const char*> mDeviceExtensions;
         QueueFamilyIndices mQueueFamilyIndices;
         SwapChainSupportDetails mSwapChainSupportDetails;
+        bool mMemoryBudgetSupported = false;
+        // drawIndirectFirstInstance and multiDrawIndirect, without them batches are drawn one at a time.
+        bool mIndirectFirstInstanceSupported = false;
+        bool mMultiDrawIndirectSupported = false;
+        // Vulkan 1.2 drawIndirectCount, needed by GPU culling.
+        bool mDrawIndirectCountSupported = false;
+        // Vulkan 1.1 descriptor update templates, shaders fall back to plain descriptor writes without them.
+        bool mDescriptorUpdateTemplateSupported = false;
+        bool mInitialized = false;
+        std::chrono::high_resolution_clock::time_point mStartTime;
+        uint64_t mFrameCount = 0;
+        uint32_t mMainPassScope = 0;
+        // reset at the start of every Draw, per-frame scratch lives here.
+        FrameArena mFrameArena;
+        // what Draw() hands to Draw(const FramePacket&), reused.
+        FramePacket mFramePacket;
 
-        const std::vector<Vertex> vertices = {
-            {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-            {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-            {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
-            {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}
-        };
-        const std::vector<uint16_t> indices = {
-            0,1,2,2,3,0
-        };
+        MeshPool mMeshPool;
     private:
-        std::shared_ptr<VulkanSwapChain> mSwapChain;
+        std::shared_ptr<VulkanSwapChainBase> mSwapChain;
         std::shared_ptr<VulkanPSO> mGraphicPipeline;
+        std::shared_ptr<VulkanPSO> mDepthPrepassPipeline;
         std::shared_ptr<VulkanQueue> mQueue;
         std::shared_ptr<VulkanCommandBuffer> mTestCommandBuffer;
+        std::unique_ptr<VulkanGPUProfiler> mGPUProfiler;
+        std::unique_ptr<VulkanMemoryTracker> mMemoryTracker;
+        std::unique_ptr<VulkanFrameReadback> mReadback;
     };
 
 }
\ No newline at end of file
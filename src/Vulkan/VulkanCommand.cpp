@@ -3,26 +3,28 @@
 
 namespace ProjectJ{
 
-    VulkanQueue::VulkanQueue(){    
-        vkGetDeviceQueue(RHI::Get().mDevice,RHI::Get().mQueueFamilyIndices.graphicsFamily.value(),0,&mGraphicQueue);
-        vkGetDeviceQueue(RHI::Get().mDevice,RHI::Get().mQueueFamilyIndices.presentFamily.value(),0,&mPresentQueue);
+    VulkanQueue::VulkanQueue(VulkanRHI& rhi)
+        :mRHI(rhi){    
+        vkGetDeviceQueue(mRHI.mDevice,mRHI.mQueueFamilyIndices.graphicsFamily.value(),0,&mGraphicQueue);
+        vkGetDeviceQueue(mRHI.mDevice,mRHI.mQueueFamilyIndices.presentFamily.value(),0,&mPresentQueue);
     
         VkCommandPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.queueFamilyIndex = RHI::Get().mQueueFamilyIndices.graphicsFamily.value();
+        poolInfo.queueFamilyIndex = mRHI.mQueueFamilyIndices.graphicsFamily.value();
         poolInfo.flags = 0;
-        VK_CHECK(vkCreateCommandPool(RHI::Get().mDevice,&poolInfo,nullptr,&mCommandPool),"failed to create command pool.");
+        VK_CHECK(vkCreateCommandPool(mRHI.mDevice,&poolInfo,nullptr,&mCommandPool),"failed to create command pool.");
         
         PCreateSyncObjects();
-        AllocCommandBuffer(RHI::Get().mSwapChain->GetImageCount(),mFrameCommandBuffers);
+        AllocCommandBuffer(mRHI.mSwapChain->GetImageCount(),mFrameCommandBuffers);
+        mImageFrameSerials.assign(mRHI.mSwapChain->GetImageCount(), 0);
     }
     VulkanQueue::~VulkanQueue(){ 
         for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
-            vkDestroySemaphore(RHI::Get().mDevice,mRenderFinishedSemaphores[i],nullptr);
-            vkDestroySemaphore(RHI::Get().mDevice,mImageAvailableSemaphores[i],nullptr);
-            vkDestroyFence(RHI::Get().mDevice,mInFlightFences[i],nullptr);
+            vkDestroySemaphore(mRHI.mDevice,mRenderFinishedSemaphores[i],nullptr);
+            vkDestroySemaphore(mRHI.mDevice,mImageAvailableSemaphores[i],nullptr);
+            vkDestroyFence(mRHI.mDevice,mInFlightFences[i],nullptr);
         }
-        vkDestroyCommandPool(RHI::Get().mDevice,mCommandPool,nullptr);
+        vkDestroyCommandPool(mRHI.mDevice,mCommandPool,nullptr);
         
     }
     VkCommandBuffer VulkanQueue::AllocCommandBuffer(){
@@ -32,7 +34,7 @@ namespace ProjectJ{
         allocInfo.commandPool = mCommandPool;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         allocInfo.commandBufferCount = 1;
-        VK_CHECK(vkAllocateCommandBuffers(RHI::Get().mDevice,&allocInfo,&commandBuffer),"failed to allocate command buffer.");
+        VK_CHECK(vkAllocateCommandBuffers(mRHI.mDevice,&allocInfo,&commandBuffer),"failed to allocate command buffer.");
         return commandBuffer;
     }
     void VulkanQueue::AllocCommandBuffer(uint32_t count,std::vector<VkCommandBuffer>& commandBuffers){
@@ -42,16 +44,17 @@ namespace ProjectJ{
         allocInfo.commandPool = mCommandPool;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
-        VK_CHECK(vkAllocateCommandBuffers(RHI::Get().mDevice,&allocInfo,commandBuffers.data()),"failed to allocate command buffers.");
+        VK_CHECK(vkAllocateCommandBuffers(mRHI.mDevice,&allocInfo,commandBuffers.data()),"failed to allocate command buffers.");
     }
 
-    void VulkanQueue::PrepareFrameCommands(std::function<void(uint32_t, VkCommandBuffer&)> func){
+    void VulkanQueue::PrepareFrameCommands(FunctionRef<void(uint32_t, VkCommandBuffer&)> func){
         for(uint32_t i = 0; i < mFrameCommandBuffers.size(); i++){
             func(i, mFrameCommandBuffers[i]);
         }
     }
     
-    void VulkanQueue::ExecuteDirectly(std::function<void(VkCommandBuffer&)> func){
+    void VulkanQueue::ExecuteDirectly(FunctionRef<void(VkCommandBuffer&)> func){
+        J_PROFILE_FUNCTION();
         auto commandBuffer = AllocCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -68,39 +71,77 @@ namespace ProjectJ{
         submitInfo.pCommandBuffers = &commandBuffer;
         vkQueueSubmit(mGraphicQueue,1,&submitInfo,VK_NULL_HANDLE);
         vkQueueWaitIdle(mGraphicQueue);
-        vkFreeCommandBuffers(RHI::Get().mDevice,mCommandPool,1,&commandBuffer);
+        vkFreeCommandBuffers(mRHI.mDevice,mCommandPool,1,&commandBuffer);
     }
 
     void VulkanQueue::BeginFrame(){ 
-        vkWaitForFences(RHI::Get().mDevice,1,&mInFlightFences[mCurrentFrame],VK_TRUE,UINT64_MAX);
-        mImageIndex = RHI::Get().mSwapChain->AcquireNextImage(mImageAvailableSemaphores[mCurrentFrame]);
+        {
+            J_PROFILE_SCOPE("WaitForFence");
+            uint64_t waitStart = Profiler::Now();
+            vkWaitForFences(mRHI.mDevice,1,&mInFlightFences[mCurrentFrame],VK_TRUE,UINT64_MAX);
+            mLastFenceWaitNs = Profiler::Now() - waitStart;
+            mCompletedFrameSerial = std::max(mCompletedFrameSerial, mInFlightFrameSerials[mCurrentFrame]);
+        }
+        mFrameSerial++;
+        J_PROFILE_SCOPE("AcquireNextImage");
+        mImageIndex = mRHI.mSwapChain->AcquireNextImage(mImageAvailableSemaphores[mCurrentFrame]);
         
     }
     void VulkanQueue::EndFrame(){
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+        auto& swapChain = mRHI.mSwapChain;
         VkSemaphore waitSemaphores[] = {mImageAvailableSemaphores[mCurrentFrame]};
         VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
+        VkSemaphore signalSemaphores[] = {mRenderFinishedSemaphores[mCurrentFrame]};
+        if(!swapChain->IsOffscreen()){
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = waitSemaphores;
+            submitInfo.pWaitDstStageMask = waitStages;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = signalSemaphores;
+        }
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &mFrameCommandBuffers[mImageIndex];
-        VkSemaphore signalSemaphores[] = {mRenderFinishedSemaphores[mCurrentFrame]};
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = signalSemaphores;
         
-        vkResetFences(RHI::Get().mDevice,1,&mInFlightFences[mCurrentFrame]);
-        VK_CHECK(vkQueueSubmit(mGraphicQueue,1,&submitInfo,mInFlightFences[mCurrentFrame]),"failed to submit draw command buffer.");
-
-        RHI::Get().mSwapChain->Present(mPresentQueue,mRenderFinishedSemaphores[mCurrentFrame]);
+        vkResetFences(mRHI.mDevice,1,&mInFlightFences[mCurrentFrame]);
+        {
+            J_PROFILE_SCOPE("QueueSubmit");
+            VK_CHECK(vkQueueSubmit(mGraphicQueue,1,&submitInfo,mInFlightFences[mCurrentFrame]),"failed to submit draw command buffer.");
+            mInFlightFrameSerials[mCurrentFrame] = mFrameSerial;
+        }
+        {
+            J_PROFILE_SCOPE("Present");
+            swapChain->Present(mPresentQueue,mRenderFinishedSemaphores[mCurrentFrame]);
+        }
         mCurrentFrame = (mCurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     }
+    uint64_t VulkanQueue::GetCompletedFrameSerial(){
+        // a signaled fence also covers every earlier submission to the queue.
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
+            if(mInFlightFrameSerials[i] > mCompletedFrameSerial && vkGetFenceStatus(mRHI.mDevice,mInFlightFences[i]) == VK_SUCCESS){
+                mCompletedFrameSerial = mInFlightFrameSerials[i];
+            }
+        }
+        return mCompletedFrameSerial;
+    }
+    void VulkanQueue::WaitForFrame(uint64_t frameSerial){
+        if(frameSerial <= GetCompletedFrameSerial()) return;
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
+            if(mInFlightFrameSerials[i] >= frameSerial){
+                J_PROFILE_SCOPE("WaitForFrame");
+                vkWaitForFences(mRHI.mDevice,1,&mInFlightFences[i],VK_TRUE,UINT64_MAX);
+                mCompletedFrameSerial = std::max(mCompletedFrameSerial, mInFlightFrameSerials[i]);
+                return;
+            }
+        }
+    }
     void VulkanQueue::PCreateSyncObjects(){
         mImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         mRenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         mInFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+        mInFlightFrameSerials.resize(MAX_FRAMES_IN_FLIGHT, 0);
 
         VkSemaphoreCreateInfo semaphoreInfo{};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -110,20 +151,24 @@ namespace ProjectJ{
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
         for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
-            VK_CHECK(vkCreateSemaphore(RHI::Get().mDevice,&semaphoreInfo,nullptr,&mImageAvailableSemaphores[i]),"failed to create semaphores.");
-            VK_CHECK(vkCreateSemaphore(RHI::Get().mDevice,&semaphoreInfo,nullptr,&mRenderFinishedSemaphores[i]),"failed to create semaphores.");    
-            VK_CHECK(vkCreateFence(RHI::Get().mDevice,&fenceInfo,nullptr,&mInFlightFences[i]),"failed to create fence.");
+            VK_CHECK(vkCreateSemaphore(mRHI.mDevice,&semaphoreInfo,nullptr,&mImageAvailableSemaphores[i]),"failed to create semaphores.");
+            VK_CHECK(vkCreateSemaphore(mRHI.mDevice,&semaphoreInfo,nullptr,&mRenderFinishedSemaphores[i]),"failed to create semaphores.");    
+            VK_CHECK(vkCreateFence(mRHI.mDevice,&fenceInfo,nullptr,&mInFlightFences[i]),"failed to create fence.");
         }
     }
 
     //------------------------------------ ScopedFrame -----------------------------------------//
-    ScopedFrame::ScopedFrame(std::shared_ptr<VulkanQueue> queue){
-        Queue = queue;
-        Queue->BeginFrame();
-        ImageIndex = queue->mImageIndex;
-    
+    ScopedFrame::ScopedFrame(VulkanQueue& queue)
+        :Queue(queue){
+        J_PROFILE_SCOPE("ScopedFrame::Begin");
+        Queue.BeginFrame();
+        ImageIndex = queue.mImageIndex;
+        FrameSerial = queue.mFrameSerial;
+        LastImageFrameSerial = queue.mImageFrameSerials[ImageIndex];
+        queue.mImageFrameSerials[ImageIndex] = FrameSerial;
     }
     ScopedFrame::~ScopedFrame(){
-        Queue->EndFrame();
+        J_PROFILE_SCOPE("ScopedFrame::End");
+        Queue.EndFrame();
     }
 }
\ No newline at end of file
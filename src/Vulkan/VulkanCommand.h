@@ -2,6 +2,7 @@
 #include "VulkanInclude.h"
 #include "VulkanDescs.h"
 #include "VulkanShader.h"
+#include "core/FunctionRef.h"
 #include "core/Reflection.hpp"
 
 namespace ProjectJ{
@@ -13,8 +14,8 @@ namespace ProjectJ{
         template<class TUniformBuffer>
         void AllocStaticUniformBuffer(const std::string& name);
 
-        static std::shared_ptr<VulkanTexture> CreateTexFromPath(const std::string& path);
-        static std::shared_ptr<VulkanTextureSampler> CreateTexSamplerFromPath(const std::string& path, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
+        static std::shared_ptr<VulkanTexture> CreateTexFromPath(VulkanRHI& rhi, const std::string& path);
+        static std::shared_ptr<VulkanTextureSampler> CreateTexSamplerFromPath(VulkanRHI& rhi, const std::string& path, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
         
     private:
     };
@@ -43,19 +44,25 @@ namespace ProjectJ{
         friend class ScopedFrame;
 
     public:
-        VulkanQueue();
+        VulkanQueue(VulkanRHI& rhi);
         ~VulkanQueue();
     public:
         VkCommandBuffer AllocCommandBuffer();
         void AllocCommandBuffer(uint32_t count, std::vector<VkCommandBuffer>& commandBuffers);
-        void ExecuteDirectly(std::function<void(VkCommandBuffer&)> func);
-        void PrepareFrameCommands(std::function<void(uint32_t, VkCommandBuffer&)> func);
+        void ExecuteDirectly(FunctionRef<void(VkCommandBuffer&)> func);
+        void PrepareFrameCommands(FunctionRef<void(uint32_t, VkCommandBuffer&)> func);
         void BeginFrame();
         void EndFrame();
+        // Frames are numbered from 1 in submission order. Polls the in-flight fences, never waits.
+        uint64_t GetCompletedFrameSerial();
+        void WaitForFrame(uint64_t frameSerial);
+        // time BeginFrame spent blocked on the in-flight fence.
+        uint64_t GetLastFenceWaitNs() const {return mLastFenceWaitNs;}
     private:
         void PCreateSyncObjects();
         void PCreateCommandBuffers();
     private:
+        VulkanRHI& mRHI;
         VkCommandPool mCommandPool;
         VkQueue mGraphicQueue;
         VkQueue mPresentQueue;
@@ -63,16 +70,31 @@ namespace ProjectJ{
         std::vector<VkSemaphore> mRenderFinishedSemaphores;
         std::vector<VkCommandBuffer> mFrameCommandBuffers;
         std::vector<VkFence> mInFlightFences;
+        std::vector<uint64_t> mInFlightFrameSerials;
+        // by swapchain image, the frame that last rendered to it, 0 if none did.
+        std::vector<uint64_t> mImageFrameSerials;
         const int MAX_FRAMES_IN_FLIGHT = 2;
         size_t mCurrentFrame = 0;
         size_t mImageIndex;
+        uint64_t mFrameSerial = 0;
+        uint64_t mCompletedFrameSerial = 0;
+        uint64_t mLastFenceWaitNs = 0;
     };
 
+    // Begins a frame on the queue and ends it when leaving the scope. The queue must outlive it,
+    // it is only referenced so that beginning a frame touches no reference count. Resources kept per
+    // swapchain image may only be touched after WaitForFrame(LastImageFrameSerial): the fences cover
+    // MAX_FRAMES_IN_FLIGHT frames, not the image the swapchain handed out.
     struct ScopedFrame{
         ScopedFrame() = delete;
-        ScopedFrame(std::shared_ptr<VulkanQueue> queue);
+        ScopedFrame(VulkanQueue& queue);
+        ScopedFrame(const ScopedFrame&) = delete;
+        ScopedFrame& operator=(const ScopedFrame&) = delete;
         ~ScopedFrame();
-        std::shared_ptr<VulkanQueue> Queue;
+        VulkanQueue& Queue;
         size_t ImageIndex;
+        uint64_t FrameSerial;
+        // the frame that last used ImageIndex, 0 if it is the image's first.
+        uint64_t LastImageFrameSerial;
     };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "VulkanInclude.h"
+#include "core/Mesh.h"
 
 namespace ProjectJ{
 
@@ -22,16 +23,67 @@ namespace ProjectJ{
         }
     };
     
-    struct Vertex{
-        glm::vec2 pos;
-        glm::vec3 color;
-        glm::vec2 texCoord;
-    };
     struct UniformBufferObject{
         glm::mat4 model;
         glm::mat4 view;
         glm::mat4 proj;
     };    
+    // instanced path, see InstancedShader.
+    struct ViewUniformBufferObject{
+        glm::mat4 view;
+        glm::mat4 proj;
+    };
+    struct InstanceData{
+        glm::mat4 model;
+    };
+    // levels of the occlusion culling depth pyramid, enough for a 65536 pixel wide target.
+    constexpr uint32_t MAX_DEPTH_PYRAMID_LEVELS = 16;
+    // GPU culling, see GPUCullShader; std140 for the uniform buffer, std430 for the rest.
+    struct CullUniformBufferObject{
+        // see Frustum.
+        glm::vec4 frustumPlanes[6];
+        glm::mat4 spin;
+        // the camera the depth pyramid was rendered with, the previous frame's.
+        glm::mat4 pyramidViewProj;
+        // offset in floats, width and height of every pyramid level, finest first.
+        glm::uvec4 pyramidLevels[MAX_DEPTH_PYRAMID_LEVELS];
+        uint32_t objectCount;
+        uint32_t batchCount;
+        // 0 only tests the frustum, e.g. before the first pyramid exists.
+        uint32_t pyramidLevelCount;
+        uint32_t reverseZ;
+        uint32_t depthWidth;
+        uint32_t depthHeight;
+        uint32_t padding[2];
+    };
+    // one level of the depth pyramid, see DepthPyramidShader; push constants.
+    struct DepthPyramidLevel{
+        uint32_t srcOffset;
+        uint32_t dstOffset;
+        glm::uvec2 srcSize;
+        glm::uvec2 dstSize;
+        // level 0 reads the depth attachment, the others the previous level.
+        uint32_t fromDepth;
+        uint32_t reverseZ;
+    };
+    struct GPUCullObject{
+        glm::mat4 model;
+        // world space sphere, center and radius in w.
+        glm::vec4 bounds;
+        // ApplyPositionDequantize, offset 0 and scale 1 for float vertices.
+        glm::vec3 positionOffset;
+        uint32_t batch;
+        glm::vec3 positionScale;
+        uint32_t padding;
+    };
+    struct GPUCullBatch{
+        // firstInstance is the batch's first slot in the instance buffer, instanceCount is filled in on the GPU.
+        VkDrawIndexedIndirectCommand command;
+        // the block and material run the batch is drawn in, its compacted commands start at runFirst.
+        uint32_t run;
+        uint32_t runFirst;
+        uint32_t padding;
+    };
     struct PSUniformBufferObject{
         glm::vec3 color;
     };
@@ -1,6 +1,6 @@
 
 #include <core/PlatformInclude.h>
-#include <Vulkan/vulkan.h>
+#include <vulkan/vulkan.h>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -0,0 +1,109 @@
+#include <Jpch.h>
+#include "VulkanMemoryTracker.h"
+
+namespace ProjectJ{
+    const char* ToString(VulkanMemoryTag tag){
+        switch(tag){
+            case VulkanMemoryTag::Vertex:   return "Vertex";
+            case VulkanMemoryTag::Index:    return "Index";
+            case VulkanMemoryTag::Uniform:  return "Uniform";
+            case VulkanMemoryTag::Storage:  return "Storage";
+            case VulkanMemoryTag::Indirect: return "Indirect";
+            case VulkanMemoryTag::Staging:  return "Staging";
+            case VulkanMemoryTag::Texture:  return "Texture";
+            case VulkanMemoryTag::RenderTarget: return "RenderTarget";
+            case VulkanMemoryTag::Readback: return "Readback";
+            default:                        return "Unknown";
+        }
+    }
+
+    void VulkanMemoryTracker::Counter::Add(VkDeviceSize size){
+        uint64_t live = liveBytes.fetch_add(size) + size;
+        uint64_t peak = peakBytes.load();
+        while(live > peak && !peakBytes.compare_exchange_weak(peak, live)){}
+        liveAllocations++;
+        totalAllocations++;
+    }
+    void VulkanMemoryTracker::Counter::Remove(VkDeviceSize size){
+        liveBytes.fetch_sub(size);
+        liveAllocations--;
+    }
+
+    VulkanMemoryTracker::VulkanMemoryTracker(VkPhysicalDevice physicalDevice, bool budgetSupported, uint32_t logInterval)
+        :mPhysicalDevice(physicalDevice), mBudgetSupported(budgetSupported), mLogInterval(logInterval){
+        vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice,&mMemoryProperties);
+    }
+    uint32_t VulkanMemoryTracker::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const{
+        for(uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++){
+            if(typeFilter & (1 << i) && (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties){
+                return i;
+            }
+        }
+        throw std::runtime_error("failed to find suitable memory type.");
+    }
+    uint32_t VulkanMemoryTracker::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags fallbackProperties) const{
+        for(uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++){
+            if(typeFilter & (1 << i) && (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties){
+                return i;
+            }
+        }
+        return FindMemoryType(typeFilter, fallbackProperties);
+    }
+    void VulkanMemoryTracker::OnAllocate(VulkanMemoryTag tag, uint32_t memoryTypeIndex, VkDeviceSize size){
+        mTags[static_cast<size_t>(tag)].Add(size);
+        mHeaps[mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].Add(size);
+    }
+    void VulkanMemoryTracker::OnFree(VulkanMemoryTag tag, uint32_t memoryTypeIndex, VkDeviceSize size){
+        mTags[static_cast<size_t>(tag)].Remove(size);
+        mHeaps[mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].Remove(size);
+    }
+    VulkanMemoryTagStats VulkanMemoryTracker::GetTagStats(VulkanMemoryTag tag) const{
+        const auto& counter = mTags[static_cast<size_t>(tag)];
+        return {counter.liveBytes.load(), counter.peakBytes.load(), counter.liveAllocations.load(), counter.totalAllocations.load()};
+    }
+    std::vector<VulkanMemoryHeapStats> VulkanMemoryTracker::GetHeapStats() const{
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        if(mBudgetSupported){
+            VkPhysicalDeviceMemoryProperties2 properties{};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            properties.pNext = &budgetProperties;
+            vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice,&properties);
+        }
+        std::vector<VulkanMemoryHeapStats> stats(mMemoryProperties.memoryHeapCount);
+        for(uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; i++){
+            stats[i].heapIndex = i;
+            stats[i].deviceLocal = mMemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+            stats[i].heapSize = mMemoryProperties.memoryHeaps[i].size;
+            stats[i].liveBytes = mHeaps[i].liveBytes.load();
+            stats[i].peakBytes = mHeaps[i].peakBytes.load();
+            stats[i].budget = budgetProperties.heapBudget[i];
+            stats[i].usage = budgetProperties.heapUsage[i];
+        }
+        return stats;
+    }
+    void VulkanMemoryTracker::Report() const{
+        constexpr double MiB = 1024.0 * 1024.0;
+        for(uint32_t i = 0; i < static_cast<uint32_t>(VulkanMemoryTag::Count); i++){
+            auto tag = static_cast<VulkanMemoryTag>(i);
+            auto s = GetTagStats(tag);
+            JLOG_REPORT("memory {}: live {:.2f} MiB, peak {:.2f} MiB, {} live / {} total allocations",
+                ToString(tag), s.liveBytes / MiB, s.peakBytes / MiB, s.liveAllocations, s.totalAllocations);
+        }
+        for(const auto& h : GetHeapStats()){
+            if(mBudgetSupported){
+                JLOG_REPORT("heap {}{}: live {:.2f} MiB, peak {:.2f} MiB, usage {:.2f} / budget {:.2f} MiB",
+                    h.heapIndex, h.deviceLocal ? " (device local)" : "", h.liveBytes / MiB, h.peakBytes / MiB, h.usage / MiB, h.budget / MiB);
+            }
+            else{
+                JLOG_REPORT("heap {}{}: live {:.2f} MiB, peak {:.2f} MiB, size {:.2f} MiB",
+                    h.heapIndex, h.deviceLocal ? " (device local)" : "", h.liveBytes / MiB, h.peakBytes / MiB, h.heapSize / MiB);
+            }
+        }
+    }
+    void VulkanMemoryTracker::OnFrame(){
+        if(mLogInterval > 0 && ++mFrameCount % mLogInterval == 0){
+            Report();
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "VulkanInclude.h"
+#include <atomic>
+
+namespace ProjectJ{
+    enum class VulkanMemoryTag : uint32_t{
+        Vertex,
+        Index,
+        Uniform,
+        Storage,
+        Indirect,
+        Staging,
+        Texture,
+        RenderTarget,
+        Readback,
+        Count
+    };
+    const char* ToString(VulkanMemoryTag tag);
+
+    struct VulkanMemoryTagStats{
+        uint64_t liveBytes;
+        uint64_t peakBytes;
+        uint64_t liveAllocations;
+        uint64_t totalAllocations;
+    };
+    struct VulkanMemoryHeapStats{
+        uint32_t heapIndex;
+        bool deviceLocal;
+        VkDeviceSize heapSize;
+        uint64_t liveBytes;
+        uint64_t peakBytes;
+        // Driver-reported, process-wide; only filled when VK_EXT_memory_budget is enabled.
+        VkDeviceSize budget;
+        VkDeviceSize usage;
+    };
+
+    // Counts every device memory allocation by tag and by heap. Safe to call from any thread.
+    class VulkanMemoryTracker{
+    public:
+        VulkanMemoryTracker(VkPhysicalDevice physicalDevice, bool budgetSupported, uint32_t logInterval = 0);
+        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        // the first type with properties, else the first with fallbackProperties.
+        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags fallbackProperties) const;
+        VkMemoryPropertyFlags GetMemoryTypeFlags(uint32_t memoryTypeIndex) const {return mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;}
+        void OnAllocate(VulkanMemoryTag tag, uint32_t memoryTypeIndex, VkDeviceSize size);
+        void OnFree(VulkanMemoryTag tag, uint32_t memoryTypeIndex, VkDeviceSize size);
+
+        VulkanMemoryTagStats GetTagStats(VulkanMemoryTag tag) const;
+        std::vector<VulkanMemoryHeapStats> GetHeapStats() const;
+        bool IsBudgetSupported() const {return mBudgetSupported;}
+        void Report() const;
+        void OnFrame();
+    private:
+        struct Counter{
+            std::atomic<uint64_t> liveBytes{0};
+            std::atomic<uint64_t> peakBytes{0};
+            std::atomic<uint64_t> liveAllocations{0};
+            std::atomic<uint64_t> totalAllocations{0};
+            void Add(VkDeviceSize size);
+            void Remove(VkDeviceSize size);
+        };
+        VkPhysicalDevice mPhysicalDevice;
+        VkPhysicalDeviceMemoryProperties mMemoryProperties;
+        bool mBudgetSupported;
+        uint32_t mLogInterval;
+        uint64_t mFrameCount = 0;
+        std::array<Counter, static_cast<size_t>(VulkanMemoryTag::Count)> mTags;
+        std::array<Counter, VK_MAX_MEMORY_HEAPS> mHeaps;
+    };
+}
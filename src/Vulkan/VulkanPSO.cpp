@@ -1,10 +1,10 @@
 #include <Jpch.h>
 #include "VulkanPSO.h"
+#include "core/VertexFormat.h"
 
 namespace ProjectJ{
-    VulkanPSO::VulkanPSO(VkRenderPass renderPass, VkDevice device, const VulkanPSODesc& desc)
-        :mDevice(device) {
-        auto readFile = [](const std::string& filename) {
+    namespace{
+        std::vector<char> HReadFile(const std::string& filename){
             std::ifstream file(filename,std::ios::ate | std::ios::binary);
             if(!file.is_open()){
                 throw std::runtime_error("failed to open file!");
@@ -15,10 +15,8 @@ namespace ProjectJ{
             file.read(buffer.data(),fileSize);
             file.close();
             return buffer;
-        };
-        auto vertShaderCode = readFile(desc.vertexShaderPath);
-        auto fragShaderCode = readFile(desc.fragmentShaderPath);
-        auto createShaderModule = [device](const std::vector<char>& code){
+        }
+        VkShaderModule HCreateShaderModule(VkDevice device, const std::vector<char>& code){
             VkShaderModuleCreateInfo createInfo{};
             createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
             createInfo.codeSize = code.size();
@@ -26,9 +24,76 @@ namespace ProjectJ{
             VkShaderModule shaderModule;
             VK_CHECK(vkCreateShaderModule(device,&createInfo,nullptr,&shaderModule),"failed to create shader module.");
             return shaderModule;
-        };
-        auto vertShaderModule = createShaderModule(vertShaderCode);
-        auto fragShaderModule = createShaderModule(fragShaderCode);
+        }
+        VkShaderModule HCreateShaderModule(VkDevice device, const std::string& path){
+            return HCreateShaderModule(device, HReadFile(path));
+        }
+        // components of the SPIR-V input variable at location, nothing when there is none or its type is not
+        // a scalar or vector.
+        std::optional<uint32_t> HGetInputComponentCount(const std::vector<char>& code, uint32_t location){
+            constexpr uint32_t kOpTypeInt = 21, kOpTypeFloat = 22, kOpTypeVector = 23, kOpTypePointer = 32;
+            constexpr uint32_t kOpVariable = 59, kOpDecorate = 71, kDecorationLocation = 30, kStorageClassInput = 1;
+            const uint32_t* words = reinterpret_cast<const uint32_t*>(code.data());
+            size_t wordCount = code.size() / sizeof(uint32_t);
+            std::unordered_map<uint32_t, uint32_t> componentCounts;
+            std::unordered_map<uint32_t, uint32_t> inputPointees;
+            std::vector<uint32_t> locatedIds;
+            std::vector<std::pair<uint32_t, uint32_t> > inputVariables;
+            // past the five word header, every instruction starts with its word count and opcode.
+            for(size_t i = 5; i < wordCount;){
+                uint32_t length = words[i] >> 16;
+                uint32_t opcode = words[i] & 0xffff;
+                if(length == 0 || i + length > wordCount){
+                    break;
+                }
+                const uint32_t* op = words + i + 1;
+                if((opcode == kOpTypeInt || opcode == kOpTypeFloat) && length >= 2){
+                    componentCounts[op[0]] = 1;
+                }
+                else if(opcode == kOpTypeVector && length >= 4){
+                    componentCounts[op[0]] = op[2];
+                }
+                else if(opcode == kOpTypePointer && length >= 4 && op[1] == kStorageClassInput){
+                    inputPointees[op[0]] = op[2];
+                }
+                else if(opcode == kOpVariable && length >= 4 && op[2] == kStorageClassInput){
+                    inputVariables.push_back({op[1], op[0]});
+                }
+                else if(opcode == kOpDecorate && length >= 4 && op[1] == kDecorationLocation && op[2] == location){
+                    locatedIds.push_back(op[0]);
+                }
+                i += length;
+            }
+            for(const auto& [variable, pointerType] : inputVariables){
+                if(std::find(locatedIds.begin(), locatedIds.end(), variable) == locatedIds.end()){
+                    continue;
+                }
+                auto pointee = inputPointees.find(pointerType);
+                if(pointee != inputPointees.end()){
+                    auto count = componentCounts.find(pointee->second);
+                    if(count != componentCounts.end()){
+                        return count->second;
+                    }
+                }
+            }
+            return std::nullopt;
+        }
+    }
+
+    VulkanPSO::VulkanPSO(VkRenderPass renderPass, VkDevice device, const VulkanPSODesc& desc)
+        :mDevice(device) {
+        auto vertCode = HReadFile(desc.vertexShaderPath);
+        // every vertex format carries a 3D position, a vec2 input draws meshes flat. Older shaders still
+        // work for the flat built-in quad, so this only warns.
+        bool hasPosition = std::any_of(desc.attributeDescriptions.begin(), desc.attributeDescriptions.end(),
+            [](const VkVertexInputAttributeDescription& attribute){ return attribute.location == VERTEX_POSITION_LOCATION; });
+        std::optional<uint32_t> positionComponents = hasPosition ? HGetInputComponentCount(vertCode, VERTEX_POSITION_LOCATION) : std::nullopt;
+        if(positionComponents && *positionComponents < 3){
+            JLOG_WARN("{} reads a {} component position, meshes lose z; declare layout(location = 0) in vec3 inPosition.",
+                desc.vertexShaderPath, *positionComponents);
+        }
+        auto vertShaderModule = HCreateShaderModule(device, vertCode);
+        auto fragShaderModule = desc.fragmentShaderPath.empty() ? VK_NULL_HANDLE : HCreateShaderModule(device, desc.fragmentShaderPath);
         
         VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
         vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -43,29 +108,14 @@ namespace ProjectJ{
         fragShaderStageInfo.pName = "main";
 
         VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+        uint32_t stageCount = fragShaderModule != VK_NULL_HANDLE ? 2 : 1;
         
         //Vertex Layout
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = desc.attributeStride;
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        // std::array<VkVertexInputAttributeDescription, 2> attributeDescription;
-        // attributeDescription[0].binding = 0;
-        // attributeDescription[0].location = 0;
-        // attributeDescription[0].format = VK_FORMAT_R32G32_SFLOAT;
-        // attributeDescription[0].offset = offsetof(Vertex,pos);
-
-        // attributeDescription[1].binding = 0;
-        // attributeDescription[1].location = 1;
-        // attributeDescription[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        // attributeDescription[1].offset = offsetof(Vertex,color);
-        
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.bindingDescriptions.size());
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.attributeDescriptions.size()); // Optional
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+        vertexInputInfo.pVertexBindingDescriptions = desc.bindingDescriptions.data();
         vertexInputInfo.pVertexAttributeDescriptions = desc.attributeDescriptions.data(); // Op
         
         VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
@@ -114,8 +164,21 @@ namespace ProjectJ{
         multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
         multisampling.alphaToOneEnable = VK_FALSE; // Optional
 
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = desc.depthStencil.depthTest ? VK_TRUE : VK_FALSE;
+        depthStencil.depthWriteEnable = desc.depthStencil.depthWrite ? VK_TRUE : VK_FALSE;
+        depthStencil.depthCompareOp = desc.depthStencil.depthCompareOp;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.stencilTestEnable = desc.depthStencil.stencilTest ? VK_TRUE : VK_FALSE;
+        depthStencil.front = desc.depthStencil.front;
+        depthStencil.back = desc.depthStencil.back;
+        depthStencil.minDepthBounds = 0.0f;
+        depthStencil.maxDepthBounds = 1.0f;
+
         VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.colorWriteMask = desc.colorWrite
+            ? VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT : 0;
         colorBlendAttachment.blendEnable = VK_FALSE;
         colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
         colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
@@ -148,14 +211,14 @@ namespace ProjectJ{
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
+        pipelineInfo.stageCount = stageCount;
         pipelineInfo.pStages = shaderStages;
         pipelineInfo.pVertexInputState = &vertexInputInfo;
         pipelineInfo.pInputAssemblyState = &inputAssembly;
         pipelineInfo.pViewportState = &viewportState;
         pipelineInfo.pRasterizationState = &rasterizer;
         pipelineInfo.pMultisampleState = &multisampling;
-        pipelineInfo.pDepthStencilState = nullptr; // Optional
+        pipelineInfo.pDepthStencilState = &depthStencil;
         pipelineInfo.pColorBlendState = &colorBlending;
         pipelineInfo.pDynamicState = nullptr; // Optional
         pipelineInfo.layout = desc.pipelineLayout;
@@ -166,7 +229,9 @@ namespace ProjectJ{
 
         VK_CHECK(vkCreateGraphicsPipelines(device,VK_NULL_HANDLE,1,&pipelineInfo,nullptr,&mPipeline),"failed to create graphics pipeline.");
         
-        vkDestroyShaderModule(device,fragShaderModule,nullptr);
+        if(fragShaderModule != VK_NULL_HANDLE){
+            vkDestroyShaderModule(device,fragShaderModule,nullptr);
+        }
         vkDestroyShaderModule(device,vertShaderModule,nullptr);
     }
     VulkanPSO::~VulkanPSO(){
@@ -175,4 +240,26 @@ namespace ProjectJ{
     void VulkanPSO::Bind(VkCommandBuffer& commandBuffer){
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
     }
+
+    VulkanComputePSO::VulkanComputePSO(VkDevice device, const VulkanComputePSODesc& desc)
+        :mDevice(device){
+        auto computeShaderModule = HCreateShaderModule(device, desc.computeShaderPath);
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = computeShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = desc.pipelineLayout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+        VK_CHECK(vkCreateComputePipelines(device,VK_NULL_HANDLE,1,&pipelineInfo,nullptr,&mPipeline),"failed to create compute pipeline.");
+        vkDestroyShaderModule(device,computeShaderModule,nullptr);
+    }
+    VulkanComputePSO::~VulkanComputePSO(){
+        vkDestroyPipeline(mDevice,mPipeline,nullptr);
+    }
+    void VulkanComputePSO::Bind(VkCommandBuffer& commandBuffer){
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+    }
 }
\ No newline at end of file
@@ -2,15 +2,29 @@
 #include "VulkanInclude.h"
 
 namespace ProjectJ{
+    // Tests against the subpass' depth/stencil attachment, all off for subpasses without one.
+    struct VulkanDepthStencilDesc{
+        bool depthTest = false;
+        bool depthWrite = false;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+        bool stencilTest = false;
+        VkStencilOpState front{};
+        VkStencilOpState back{};
+    };
     struct VulkanPSODesc{
         std::string vertexShaderPath;
+        // empty for depth only pipelines, which need no fragment stage.
         std::string fragmentShaderPath;
         
-        uint32_t attributeStride;
+        // one binding per vertex stream, see AddVertexStream.
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
         
         VkExtent2D extent;
         VkPipelineLayout pipelineLayout;
+        VulkanDepthStencilDesc depthStencil;
+        // off for depth only passes.
+        bool colorWrite = true;
     };
     class VulkanPSO{
     public:
@@ -21,4 +35,21 @@ namespace ProjectJ{
         VkDevice mDevice;
         VkPipeline mPipeline;
     };
+
+    struct VulkanComputePSODesc{
+        std::string computeShaderPath;
+        VkPipelineLayout pipelineLayout;
+    };
+    // Compute pipeline, recorded outside render passes; the dispatch size is up to the caller.
+    class VulkanComputePSO{
+    public:
+        VulkanComputePSO(VkDevice device, const VulkanComputePSODesc& desc);
+        ~VulkanComputePSO();
+        VulkanComputePSO(const VulkanComputePSO&) = delete;
+        VulkanComputePSO& operator=(const VulkanComputePSO&) = delete;
+        void Bind(VkCommandBuffer& commandBuffer);
+    private:
+        VkDevice mDevice;
+        VkPipeline mPipeline;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <Jpch.h>
+#include "VulkanProfiler.h"
+
+namespace ProjectJ{
+    VulkanGPUProfiler::VulkanGPUProfiler(VulkanRHI& rhi, uint32_t frameCount, uint32_t maxScopes, uint32_t logInterval)
+        :mMaxScopes(maxScopes), mLogInterval(logInterval) {
+        mDevice = rhi.mDevice;
+
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(rhi.mPhysicalDevice, &properties);
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(rhi.mPhysicalDevice,&queueFamilyCount,nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(rhi.mPhysicalDevice,&queueFamilyCount,queueFamilies.data());
+        uint32_t validBits = queueFamilies[rhi.mQueueFamilyIndices.graphicsFamily.value()].timestampValidBits;
+
+        mSupported = validBits > 0 && properties.limits.timestampPeriod > 0.0f;
+        if(!mSupported){
+            JLOG_WARN("GPU timestamps are not supported on the graphics queue, GPU profiler disabled.");
+            return;
+        }
+        mTimestampPeriod = properties.limits.timestampPeriod;
+        mTimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = mMaxScopes * 2;
+        mQueryPools.resize(frameCount);
+        mQueryCounts.resize(frameCount, 0);
+        for(auto& pool : mQueryPools){
+            VK_CHECK(vkCreateQueryPool(mDevice,&poolInfo,nullptr,&pool),"failed to create timestamp query pool.");
+        }
+        // queries have to be reset before their results may be read.
+        rhi.mQueue->ExecuteDirectly([this](VkCommandBuffer& commandBuffer){
+            for(auto pool : mQueryPools){
+                vkCmdResetQueryPool(commandBuffer,pool,0,mMaxScopes * 2);
+            }
+        });
+        // [timestamp, availability] pairs
+        mResults.resize(mMaxScopes * 2 * 2);
+    }
+    VulkanGPUProfiler::~VulkanGPUProfiler(){
+        for(auto pool : mQueryPools){
+            vkDestroyQueryPool(mDevice,pool,nullptr);
+        }
+    }
+    uint32_t VulkanGPUProfiler::GetScopeId(const std::string& name){
+        for(uint32_t i = 0; i < mScopeNames.size(); i++){
+            if(mScopeNames[i] == name){
+                return i;
+            }
+        }
+        if(mScopeNames.size() >= mMaxScopes){
+            throw std::runtime_error("too many GPU profiler scopes.");
+        }
+        mScopeNames.push_back(name);
+        mScopeStats.emplace_back();
+        mScopeLastMs.push_back(0.0);
+        mScopeSampleCounts.push_back(0);
+        return static_cast<uint32_t>(mScopeNames.size() - 1);
+    }
+    void VulkanGPUProfiler::ResetQueries(VkCommandBuffer commandBuffer, uint32_t frameIndex){
+        if(!mSupported) return;
+        vkCmdResetQueryPool(commandBuffer,mQueryPools[frameIndex],0,mMaxScopes * 2);
+    }
+    void VulkanGPUProfiler::WriteBegin(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scopeId){
+        if(!mSupported) return;
+        vkCmdWriteTimestamp(commandBuffer,VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,mQueryPools[frameIndex],scopeId * 2);
+        mQueryCounts[frameIndex] = std::max(mQueryCounts[frameIndex], scopeId * 2 + 2);
+    }
+    void VulkanGPUProfiler::WriteEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scopeId){
+        if(!mSupported) return;
+        vkCmdWriteTimestamp(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,mQueryPools[frameIndex],scopeId * 2 + 1);
+    }
+    void VulkanGPUProfiler::Collect(uint32_t frameIndex){
+        if(!mSupported || mQueryCounts[frameIndex] == 0) return;
+
+        uint32_t queryCount = mQueryCounts[frameIndex];
+        // VK_NOT_READY only means some queries are unavailable, the availability words tell which.
+        vkGetQueryPoolResults(mDevice,mQueryPools[frameIndex],0,queryCount,
+            queryCount * 2 * sizeof(uint64_t),mResults.data(),2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        for(uint32_t scope = 0; scope * 2 + 1 < queryCount; scope++){
+            const uint64_t* begin = &mResults[scope * 4];
+            const uint64_t* end = &mResults[scope * 4 + 2];
+            if(begin[1] == 0 || end[1] == 0){
+                continue;
+            }
+            uint64_t ticks = ((end[0] & mTimestampMask) - (begin[0] & mTimestampMask)) & mTimestampMask;
+            mScopeLastMs[scope] = ticks * mTimestampPeriod * 1e-6;
+            mScopeStats[scope].Add(mScopeLastMs[scope]);
+            mScopeSampleCounts[scope]++;
+        }
+        if(mLogInterval > 0 && ++mCollectCount % mLogInterval == 0){
+            LogStats();
+        }
+    }
+    std::vector<VulkanGPUScopeStats> VulkanGPUProfiler::GetStats() const{
+        std::vector<VulkanGPUScopeStats> stats;
+        for(size_t i = 0; i < mScopeNames.size(); i++){
+            VulkanGPUScopeStats s{};
+            s.name = mScopeNames[i];
+            s.avgMs = mScopeStats[i].Average();
+            s.p50Ms = mScopeStats[i].Percentile(0.5);
+            s.p99Ms = mScopeStats[i].Percentile(0.99);
+            s.sampleCount = mScopeStats[i].Count();
+            stats.push_back(s);
+        }
+        return stats;
+    }
+    void VulkanGPUProfiler::LogStats() const{
+        for(const auto& s : GetStats()){
+            JLOG_REPORT("GPU {}: avg {:.3f} ms, p50 {:.3f} ms, p99 {:.3f} ms ({} samples)", s.name, s.avgMs, s.p50Ms, s.p99Ms, s.sampleCount);
+        }
+    }
+
+    //------------------------------------ ScopedGPUTimer -----------------------------------------//
+    ScopedGPUTimer::ScopedGPUTimer(VulkanGPUProfiler& profiler, VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::string& name)
+        :mProfiler(profiler), mCommandBuffer(commandBuffer), mFrameIndex(frameIndex){
+        mScopeId = mProfiler.GetScopeId(name);
+        mProfiler.WriteBegin(mCommandBuffer,mFrameIndex,mScopeId);
+    }
+    ScopedGPUTimer::~ScopedGPUTimer(){
+        mProfiler.WriteEnd(mCommandBuffer,mFrameIndex,mScopeId);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "VulkanInclude.h"
+#include "core/Statistics.h"
+
+namespace ProjectJ{
+    class VulkanRHI;
+
+    struct VulkanGPUScopeStats{
+        std::string name;
+        double avgMs;
+        double p50Ms;
+        double p99Ms;
+        size_t sampleCount;
+    };
+
+    // Timestamp queries, one query pool per recorded frame command buffer.
+    // Results are read back with availability bits, so collecting never waits on the GPU.
+    class VulkanGPUProfiler{
+    public:
+        VulkanGPUProfiler(VulkanRHI& rhi, uint32_t frameCount, uint32_t maxScopes = 64, uint32_t logInterval = 0);
+        ~VulkanGPUProfiler();
+        bool IsSupported() const {return mSupported;}
+        uint32_t GetScopeId(const std::string& name);
+
+        // Must be recorded outside of a render pass, before any scope of the frame.
+        void ResetQueries(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+        void WriteBegin(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scopeId);
+        void WriteEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scopeId);
+
+        // Call once the frame's previous submission is known to be done (after the frame fence).
+        void Collect(uint32_t frameIndex);
+        std::vector<VulkanGPUScopeStats> GetStats() const;
+        // most recent collected sample, 0 before the first one.
+        double GetLastMs(uint32_t scopeId) const {return scopeId < mScopeLastMs.size() ? mScopeLastMs[scopeId] : 0.0;}
+        // samples collected so far, GetLastMs is a new one whenever this went up.
+        uint64_t GetSampleCount(uint32_t scopeId) const {return scopeId < mScopeSampleCounts.size() ? mScopeSampleCounts[scopeId] : 0;}
+        void LogStats() const;
+    private:
+        VkDevice mDevice;
+        std::vector<VkQueryPool> mQueryPools;
+        std::vector<uint32_t> mQueryCounts;
+        std::vector<uint64_t> mResults;
+        std::vector<std::string> mScopeNames;
+        std::vector<RollingStats> mScopeStats;
+        std::vector<double> mScopeLastMs;
+        std::vector<uint64_t> mScopeSampleCounts;
+        uint32_t mMaxScopes;
+        uint32_t mLogInterval;
+        uint64_t mCollectCount = 0;
+        uint64_t mTimestampMask = ~0ull;
+        double mTimestampPeriod = 1.0;
+        bool mSupported = false;
+    };
+
+    class ScopedGPUTimer{
+    public:
+        ScopedGPUTimer(VulkanGPUProfiler& profiler, VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::string& name);
+        ~ScopedGPUTimer();
+    private:
+        VulkanGPUProfiler& mProfiler;
+        VkCommandBuffer mCommandBuffer;
+        uint32_t mFrameIndex;
+        uint32_t mScopeId;
+    };
+}
@@ -0,0 +1,99 @@
+#include <Jpch.h>
+#include "VulkanReadback.h"
+
+namespace ProjectJ{
+    VulkanFrameReadback::VulkanFrameReadback(VulkanRHI& rhi, uint32_t slotCount, VkExtent2D extent, VkFormat format)
+        :mExtent(extent), mFormat(format){
+        // every color format the swap chains hand out is 4 bytes per pixel.
+        mRowPitch = mExtent.width * 4;
+        mSlots.resize(slotCount);
+        for(auto& slot : mSlots){
+            slot.buffer = std::make_unique<VulkanReadbackBuffer>(rhi, static_cast<size_t>(mRowPitch) * mExtent.height);
+        }
+    }
+    void VulkanFrameReadback::RecordCopy(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkImageLayout srcLayout){
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = srcLayout;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {mExtent.width, mExtent.height, 1};
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mSlots[slot].buffer->mBuffer, 1, &region);
+
+        VkBufferMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.buffer = mSlots[slot].buffer->mBuffer;
+        hostBarrier.offset = 0;
+        hostBarrier.size = VK_WHOLE_SIZE;
+        VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_HOST_BIT;
+
+        uint32_t imageBarrierCount = 0;
+        if(srcLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL){
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.newLayout = srcLayout;
+            dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+            imageBarrierCount = 1;
+        }
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages,
+            0, 0, nullptr, 1, &hostBarrier, imageBarrierCount, &barrier);
+    }
+    void VulkanFrameReadback::OnSubmit(uint32_t slot, uint64_t frameSerial){
+        mSlots[slot].frameSerial = frameSerial;
+        mSlots[slot].pending = true;
+    }
+    void VulkanFrameReadback::Poll(uint64_t completedFrameSerial){
+        while(true){
+            Slot* next = nullptr;
+            for(auto& slot : mSlots){
+                if(slot.pending && slot.frameSerial <= completedFrameSerial && (!next || slot.frameSerial < next->frameSerial)){
+                    next = &slot;
+                }
+            }
+            if(!next){
+                return;
+            }
+            next->pending = false;
+            next->buffer->Invalidate();
+            if(mCallback){
+                ReadbackFrame frame{};
+                frame.data = next->buffer->GetData();
+                frame.width = mExtent.width;
+                frame.height = mExtent.height;
+                frame.rowPitch = mRowPitch;
+                frame.format = mFormat;
+                frame.frameSerial = next->frameSerial;
+                mCallback(frame);
+            }
+            mDeliveredFrames++;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "VulkanInclude.h"
+#include "VulkanResources.h"
+#include "core/Readback.h"
+
+namespace ProjectJ{
+    // Ring of host buffers, one per recorded frame command buffer. Each frame copies its final color
+    // image into its slot; the slot is handed to the CPU once the frame's fence has signaled, so the
+    // GPU is never waited on just to read pixels back.
+    class VulkanFrameReadback{
+    public:
+        VulkanFrameReadback(VulkanRHI& rhi, uint32_t slotCount, VkExtent2D extent, VkFormat format);
+        void SetCallback(ReadbackCallback callback) {mCallback = std::move(callback);}
+        // recorded after the render pass, image is in srcLayout and is returned to it afterwards.
+        void RecordCopy(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkImageLayout srcLayout);
+        void OnSubmit(uint32_t slot, uint64_t frameSerial);
+        // delivers every completed, not yet delivered slot in frame order.
+        void Poll(uint64_t completedFrameSerial);
+        uint64_t GetDeliveredFrameCount() const {return mDeliveredFrames;}
+    private:
+        struct Slot{
+            std::unique_ptr<VulkanReadbackBuffer> buffer;
+            uint64_t frameSerial = 0;
+            bool pending = false;
+        };
+        std::vector<Slot> mSlots;
+        VkExtent2D mExtent;
+        VkFormat mFormat;
+        uint32_t mRowPitch;
+        ReadbackCallback mCallback;
+        uint64_t mDeliveredFrames = 0;
+    };
+}
@@ -1,20 +1,34 @@
 #include <Jpch.h>
 #include "VulkanResources.h"
+#include <tuple>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include "stb_image_resize.h"
 
 
 namespace ProjectJ{
-    VulkanBufferBase::VulkanBufferBase(size_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+    namespace{
+        VkImageAspectFlags HGetAspectMask(VkFormat format){
+            switch(format){
+                case VK_FORMAT_D16_UNORM:
+                case VK_FORMAT_X8_D24_UNORM_PACK32:
+                case VK_FORMAT_D32_SFLOAT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+                case VK_FORMAT_D16_UNORM_S8_UINT:
+                case VK_FORMAT_D24_UNORM_S8_UINT:
+                case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                default:
+                    return VK_IMAGE_ASPECT_COLOR_BIT;
+            }
+        }
+    }
+
+    VulkanBufferBase::VulkanBufferBase(VulkanRHI& rhi, size_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanMemoryTag tag, VkMemoryPropertyFlags fallbackProperties)
+        :mRHI(rhi), mMemoryTag(tag)
     {
+        J_PROFILE_SCOPE("VulkanBufferBase::Create");
         mSize = size;
-        mDevice = RHI::Get().mDevice;
-        mPhysicalDevice = RHI::Get().mPhysicalDevice;
+        mDevice = mRHI.mDevice;
+        mPhysicalDevice = mRHI.mPhysicalDevice;
 
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -25,41 +39,37 @@ namespace ProjectJ{
 
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(mDevice,mBuffer,&memRequirements);
-        auto findMemoryType = [this](uint32_t typeFilter, VkMemoryPropertyFlags properties){
-            VkPhysicalDeviceMemoryProperties memProperties;
-            vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice,&memProperties);
-
-            VkPhysicalDeviceProperties deviceProperties;
-            vkGetPhysicalDeviceProperties(mPhysicalDevice,&deviceProperties);
-            JLOG_INFO("physical limits: {}", deviceProperties.limits.nonCoherentAtomSize);
-            
-            for(uint32_t i = 0; i < memProperties.memoryTypeCount; i++){
-                if(typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties){
-                    return i;
-                }
-            }
-            throw std::runtime_error("failed to find suitable memory type.");
-        };
 
+        auto& memoryTracker = *mRHI.mMemoryTracker;
         VkMemoryAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
         allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(
-            memRequirements.memoryTypeBits,
-            properties
-        );
+        allocInfo.memoryTypeIndex = fallbackProperties == 0
+            ? memoryTracker.FindMemoryType(memRequirements.memoryTypeBits, properties)
+            : memoryTracker.FindMemoryType(memRequirements.memoryTypeBits, properties, fallbackProperties);
         
-        JLOG_INFO("{} {}",size,allocInfo.allocationSize);
+        JLOG_TRACE("buffer of {} bytes, allocation of {} bytes",size,allocInfo.allocationSize);
         VK_CHECK(vkAllocateMemory(mDevice,&allocInfo,nullptr,&mMemory),"failed to allocate vertex buffer memory.");
         vkBindBufferMemory(mDevice,mBuffer,mMemory,0);
+        mAllocationSize = allocInfo.allocationSize;
+        mMemoryTypeIndex = allocInfo.memoryTypeIndex;
+        memoryTracker.OnAllocate(mMemoryTag,mMemoryTypeIndex,mAllocationSize);
     }
     VulkanBufferBase::~VulkanBufferBase(){
         vkDestroyBuffer(mDevice,mBuffer,nullptr);
         vkFreeMemory(mDevice,mMemory,nullptr);
+        mRHI.mMemoryTracker->OnFree(mMemoryTag,mMemoryTypeIndex,mAllocationSize);
     }
-    VulkanStagingBuffer::VulkanStagingBuffer(void* data, size_t size) 
-        : VulkanBufferBase(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+    VkDeviceSize VulkanBufferBase::HGetUniformStride(VulkanRHI& rhi, VkDeviceSize size){
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(rhi.mPhysicalDevice, &properties);
+        VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+        return (size + alignment - 1) / alignment * alignment;
+    }
+    VulkanStagingBuffer::VulkanStagingBuffer(VulkanRHI& rhi, void* data, size_t size) 
+        : VulkanBufferBase(rhi, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VulkanMemoryTag::Staging)
         {
             void* p;
             vkMapMemory(mDevice,mMemory,0,size,0,&p);
@@ -67,7 +77,7 @@ namespace ProjectJ{
             vkUnmapMemory(mDevice,mMemory);
     }
     void VulkanStagingBuffer::CopyToBuffer(const VulkanBufferBase* dstBuffer){
-        auto queue = RHI::Get().mQueue;
+        auto queue = mRHI.mQueue;
         queue->ExecuteDirectly([this, dstBuffer](VkCommandBuffer& commandBuffer){
             VkBufferCopy copyRegion{};
             copyRegion.srcOffset = 0;
@@ -77,7 +87,7 @@ namespace ProjectJ{
         });        
     }
     void VulkanStagingBuffer::CopyToTexture(const VulkanTexture* dstTex){
-        auto queue = RHI::Get().mQueue;
+        auto queue = mRHI.mQueue;
         queue->ExecuteDirectly([this,dstTex](VkCommandBuffer& commandBuffer){
             VkBufferImageCopy region{};
             region.bufferOffset = 0;
@@ -105,43 +115,86 @@ namespace ProjectJ{
             );
         });
     }
-    VulkanVertexBuffer::VulkanVertexBuffer(void* data, size_t size)
+    VulkanReadbackBuffer::VulkanReadbackBuffer(VulkanRHI& rhi, size_t size)
+        : VulkanBufferBase(rhi, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        VulkanMemoryTag::Readback,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+    {
+        mCoherent = (mRHI.GetMemoryTracker().GetMemoryTypeFlags(mMemoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+        void* p;
+        VK_CHECK(vkMapMemory(mDevice,mMemory,0,VK_WHOLE_SIZE,0,&p),"failed to map readback buffer.");
+        mMapped = static_cast<uint8_t*>(p);
+    }
+    VulkanReadbackBuffer::~VulkanReadbackBuffer(){
+        vkUnmapMemory(mDevice,mMemory);
+    }
+    void VulkanReadbackBuffer::Invalidate(){
+        if(mCoherent){
+            return;
+        }
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = mMemory;
+        range.offset = 0;
+        range.size = VK_WHOLE_SIZE;
+        vkInvalidateMappedMemoryRanges(mDevice,1,&range);
+    }
+
+    VulkanVertexBuffer::VulkanVertexBuffer(VulkanRHI& rhi, void* data, size_t size)
         : VulkanBufferBase(
-            size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            rhi, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VulkanMemoryTag::Vertex)
     {
-        VulkanStagingBuffer stagingBuffer(data,size);
+        J_PROFILE_SCOPE("VulkanVertexBuffer::Upload");
+        VulkanStagingBuffer stagingBuffer(rhi,data,size);
         stagingBuffer.CopyToBuffer(this);
     }
 
-    VulkanVertexBuffer::VulkanVertexBuffer(size_t size)
+    VulkanVertexBuffer::VulkanVertexBuffer(VulkanRHI& rhi, size_t size)
         : VulkanBufferBase(
-            size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            rhi, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VulkanMemoryTag::Vertex)
     {
     }
 
-    VulkanIndexBuffer::VulkanIndexBuffer(void* data, size_t size)
+    VulkanIndexBuffer::VulkanIndexBuffer(VulkanRHI& rhi, void* data, size_t size)
         : VulkanBufferBase(
-            size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            rhi, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VulkanMemoryTag::Index)
     {
-        VulkanStagingBuffer stagingBuffer(data,size);
+        J_PROFILE_SCOPE("VulkanIndexBuffer::Upload");
+        VulkanStagingBuffer stagingBuffer(rhi,data,size);
         stagingBuffer.CopyToBuffer(this);
     }
 
-    VulkanIndexBuffer::VulkanIndexBuffer(size_t size)
+    VulkanIndexBuffer::VulkanIndexBuffer(VulkanRHI& rhi, size_t size)
         : VulkanBufferBase(
-            size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            rhi, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VulkanMemoryTag::Index)
+    {
+    }
+
+    VulkanDeviceBuffer::VulkanDeviceBuffer(VulkanRHI& rhi, size_t size, VkBufferUsageFlags usage, VulkanMemoryTag tag)
+        : VulkanBufferBase(rhi, std::max<size_t>(size, 4), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, tag)
     {
     }
 
-    VulkanTexture::VulkanTexture(uint32_t width, uint32_t height, VkFormat format) 
-        :Width(width), Height(height), Format(format)
+    VulkanDeviceBuffer::VulkanDeviceBuffer(VulkanRHI& rhi, const void* data, size_t size, VkBufferUsageFlags usage, VulkanMemoryTag tag)
+        : VulkanBufferBase(rhi, std::max<size_t>(size, 4), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, tag)
     {
-        auto& device = RHI::Get().mDevice;
-        auto& physicalDevice = RHI::Get().mPhysicalDevice;
+        if(size > 0){
+            J_PROFILE_SCOPE("VulkanDeviceBuffer::Upload");
+            VulkanStagingBuffer stagingBuffer(rhi,const_cast<void*>(data),size);
+            stagingBuffer.CopyToBuffer(this);
+        }
+    }
+
+    VulkanTexture::VulkanTexture(VulkanRHI& rhi, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VulkanMemoryTag tag) 
+        :mRHI(rhi), Width(width), Height(height), Format(format), mMemoryTag(tag)
+    {
+        J_PROFILE_SCOPE("VulkanTexture::Create");
+        auto& device = mRHI.mDevice;
 
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -151,10 +204,10 @@ namespace ProjectJ{
         imageInfo.extent.depth = 1;
         imageInfo.mipLevels = 1;
         imageInfo.arrayLayers = 1;
-        imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+        imageInfo.format = format;
         imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.usage = usage;
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageInfo.flags = 0; // Optional
@@ -163,31 +216,24 @@ namespace ProjectJ{
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device, mImage, &memRequirements);
         
-        auto findMemoryType = [physicalDevice](uint32_t typeFilter, VkMemoryPropertyFlags properties){
-            VkPhysicalDeviceMemoryProperties memProperties;
-            vkGetPhysicalDeviceMemoryProperties(physicalDevice,&memProperties);
-            for(uint32_t i = 0; i < memProperties.memoryTypeCount; i++){
-                if(typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties){
-                    return i;
-                }
-            }
-            throw std::runtime_error("failed to find suitable memory type.");
-        };
-
+        auto& memoryTracker = *mRHI.mMemoryTracker;
         VkMemoryAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
         allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        allocInfo.memoryTypeIndex = memoryTracker.FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
         VK_CHECK(vkAllocateMemory(device, &allocInfo, nullptr, &mMemory),"failed to allocate image memory!");
         vkBindImageMemory(device, mImage, mMemory, 0);
+        mAllocationSize = allocInfo.allocationSize;
+        mMemoryTypeIndex = allocInfo.memoryTypeIndex;
+        memoryTracker.OnAllocate(mMemoryTag,mMemoryTypeIndex,mAllocationSize);
 
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         viewInfo.image = mImage;
         viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
         viewInfo.format = format;
-        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.aspectMask = HGetAspectMask(format);
         viewInfo.subresourceRange.baseMipLevel = 0;
         viewInfo.subresourceRange.levelCount = 1;
         viewInfo.subresourceRange.baseArrayLayer = 0;
@@ -196,12 +242,13 @@ namespace ProjectJ{
 
     }
     VulkanTexture::~VulkanTexture(){  
-        vkDestroyImageView(RHI::Get().mDevice, mView, nullptr);
-        vkDestroyImage(RHI::Get().mDevice, mImage, nullptr);
-        vkFreeMemory(RHI::Get().mDevice, mMemory, nullptr);
+        vkDestroyImageView(mRHI.mDevice, mView, nullptr);
+        vkDestroyImage(mRHI.mDevice, mImage, nullptr);
+        vkFreeMemory(mRHI.mDevice, mMemory, nullptr);
+        mRHI.mMemoryTracker->OnFree(mMemoryTag,mMemoryTypeIndex,mAllocationSize);
     }
     void VulkanTexture::LayoutTransition(VkImageLayout oldLayout, VkImageLayout newLayout){
-        auto queue = RHI::Get().mQueue;
+        auto queue = mRHI.mQueue;
         queue->ExecuteDirectly([=](VkCommandBuffer& commandBuffer){
             VkImageMemoryBarrier barrier{};
             barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -210,7 +257,7 @@ namespace ProjectJ{
             barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             barrier.image = mImage;
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.aspectMask = HGetAspectMask(Format);
             barrier.subresourceRange.baseMipLevel = 0;
             barrier.subresourceRange.levelCount = 1;
             barrier.subresourceRange.baseArrayLayer = 0;
@@ -246,8 +293,25 @@ namespace ProjectJ{
         });
     }
 
+    bool VulkanRenderTargetPool::Key::operator<(const Key& other) const{
+        return std::tie(width, height, format, usage) < std::tie(other.width, other.height, other.format, other.usage);
+    }
+    VulkanRenderTargetPool::VulkanRenderTargetPool(VulkanRHI& rhi)
+        :mRHI(rhi){
+    }
+    std::shared_ptr<VulkanTexture> VulkanRenderTargetPool::Acquire(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage){
+        auto& target = mTargets[Key{width, height, format, usage}];
+        if(!target){
+            target = std::make_shared<VulkanTexture>(mRHI, width, height, format, usage, VulkanMemoryTag::RenderTarget);
+        }
+        return target;
+    }
+    void VulkanRenderTargetPool::Clear(){
+        mTargets.clear();
+    }
 
-    VulkanSampler::VulkanSampler(const VulkanSamplerDesc& desc){
+    VulkanSampler::VulkanSampler(VulkanRHI& rhi, const VulkanSamplerDesc& desc)
+        :mDevice(rhi.mDevice){
         VkSamplerCreateInfo samplerInfo{};
         samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
         samplerInfo.magFilter = desc.magFilter;
@@ -258,7 +322,7 @@ namespace ProjectJ{
         samplerInfo.anisotropyEnable = VK_TRUE;
         {
             VkPhysicalDeviceProperties properties{};
-            vkGetPhysicalDeviceProperties(RHI::Get().mPhysicalDevice, &properties);
+            vkGetPhysicalDeviceProperties(rhi.mPhysicalDevice, &properties);
             samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
         }
         samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
@@ -270,15 +334,15 @@ namespace ProjectJ{
         samplerInfo.minLod = 0.0f;
         samplerInfo.maxLod = 0.0f;
 
-        VK_CHECK(vkCreateSampler(RHI::Get().mDevice, &samplerInfo, nullptr, &mSampler),"failed to create sampler");
+        VK_CHECK(vkCreateSampler(mDevice, &samplerInfo, nullptr, &mSampler),"failed to create sampler");
     }
     VulkanSampler::~VulkanSampler(){
-        vkDestroySampler(RHI::Get().mDevice, mSampler, nullptr);
+        vkDestroySampler(mDevice, mSampler, nullptr);
     }
 
 
-    VulkanTextureSampler::VulkanTextureSampler(uint32_t width,uint32_t height, VkFormat format, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit)
-        :VulkanTexture(width,height,format),VulkanSampler(desc), mStageBit(stageBit){
+    VulkanTextureSampler::VulkanTextureSampler(VulkanRHI& rhi, uint32_t width,uint32_t height, VkFormat format, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit)
+        :VulkanTexture(rhi,width,height,format),VulkanSampler(rhi,desc), mStageBit(stageBit){
 
     }    
     VkDescriptorImageInfo VulkanTextureSampler::GetImageInfo() const {
@@ -290,43 +354,36 @@ namespace ProjectJ{
     }
 
     
-    std::shared_ptr<VulkanTexture> TextureLoader::CreateTexFromPath(const std::string& path){
-        int texWidth, texHeight, texChannels;
-        stbi_uc* pixels = stbi_load("textures/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-        if (!pixels) {
-            throw std::runtime_error("failed to load texture image!");
-        }
-        auto stagingBuffer = std::make_shared<VulkanStagingBuffer>(pixels,imageSize);
+    std::shared_ptr<VulkanTexture> TextureLoader::CreateTexFromPath(VulkanRHI& rhi, const std::string& path){
+        J_PROFILE_FUNCTION();
+        DecodedImage image = DecodeImage(path);
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(image.width) * image.height * 4;
+        auto stagingBuffer = std::make_shared<VulkanStagingBuffer>(rhi,image.pixels.get(),imageSize);
         
-        auto texture = std::make_shared<VulkanTexture>(texWidth,texHeight, VK_FORMAT_R8G8B8A8_SRGB);// TODO
+        auto texture = std::make_shared<VulkanTexture>(rhi,image.width,image.height, VK_FORMAT_R8G8B8A8_SRGB);// TODO
         
         texture->LayoutTransition(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
         stagingBuffer->CopyToTexture(texture.get());
         texture->LayoutTransition(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        
-        stbi_image_free(pixels);
         return texture;
     }
 
-    std::shared_ptr<VulkanTextureSampler> TextureLoader::CreateTexSamplerFromPath(const std::string& path, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit){
-        int texWidth, texHeight, texChannels;
-        stbi_uc* pixels = stbi_load("textures/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
+    std::shared_ptr<VulkanTextureSampler> TextureLoader::CreateTexSamplerFromPath(VulkanRHI& rhi, const std::string& path, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit){
+        J_PROFILE_FUNCTION();
+        DecodedImage image = DecodeImage(path);
+        return CreateTexSamplerFromPixels(rhi, image.pixels.get(), image.width, image.height, desc, stageBit);
+    }
 
-        if (!pixels) {
-            throw std::runtime_error("failed to load texture image!");
-        }
-        auto stagingBuffer = std::make_shared<VulkanStagingBuffer>(pixels,imageSize);
+    std::shared_ptr<VulkanTextureSampler> TextureLoader::CreateTexSamplerFromPixels(VulkanRHI& rhi, const uint8_t* pixels, uint32_t width, uint32_t height, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit){
+        J_PROFILE_FUNCTION();
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+        auto stagingBuffer = std::make_shared<VulkanStagingBuffer>(rhi,const_cast<uint8_t*>(pixels),imageSize);
         
-        auto texture = std::make_shared<VulkanTextureSampler>(texWidth,texHeight, VK_FORMAT_R8G8B8A8_SRGB, desc, stageBit);// TODO
+        auto texture = std::make_shared<VulkanTextureSampler>(rhi,width,height, VK_FORMAT_R8G8B8A8_SRGB, desc, stageBit);// TODO
         
         texture->LayoutTransition(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
         stagingBuffer->CopyToTexture(texture.get());
         texture->LayoutTransition(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        
-        stbi_image_free(pixels);
         return texture;
     }
 }
\ No newline at end of file
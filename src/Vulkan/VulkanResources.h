@@ -1,30 +1,44 @@
 #pragma once
 #include "VulkanInclude.h"
+#include "VulkanMemoryTracker.h"
+#include "core/FunctionRef.h"
+#include "core/Image.h"
 
 namespace ProjectJ{
+    class VulkanRHI;
+
+    // Resources are created against one VulkanRHI and must not outlive it.
     class VulkanBufferBase{
     public:
         VulkanBufferBase() = delete;
-        VulkanBufferBase(size_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+        // fallbackProperties, when not 0, are used if no memory type has all of properties.
+        VulkanBufferBase(VulkanRHI& rhi, size_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanMemoryTag tag, VkMemoryPropertyFlags fallbackProperties = 0);
         virtual ~VulkanBufferBase();
     protected:
+        // size rounded up to minUniformBufferOffsetAlignment.
+        static VkDeviceSize HGetUniformStride(VulkanRHI& rhi, VkDeviceSize size);
+        VulkanRHI& mRHI;
         VkDeviceMemory mMemory;
         VkDevice mDevice;
         VkPhysicalDevice mPhysicalDevice;
         VkDeviceSize mSize;
+        VkDeviceSize mAllocationSize;
+        uint32_t mMemoryTypeIndex;
+        VulkanMemoryTag mMemoryTag;
     //TODO: remove public 
     public:
         VkBuffer mBuffer;
     };
     using VulkanBufferPtr = std::shared_ptr<VulkanBufferBase>;
 
-    template<class TUniformBufferClass, size_t Size = sizeof TUniformBufferClass>
+    template<class TUniformBufferClass, size_t Size = sizeof(TUniformBufferClass)>
     class VulkanUniformBuffer : public VulkanBufferBase{
     public:
-        VulkanUniformBuffer(VkShaderStageFlags stageBit)
-            :VulkanBufferBase(Size,
+        VulkanUniformBuffer(VulkanRHI& rhi, VkShaderStageFlags stageBit)
+            :VulkanBufferBase(rhi, Size,
             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VulkanMemoryTag::Uniform), 
             mStageBit(stageBit){
                 
             }
@@ -35,7 +49,7 @@ namespace ProjectJ{
             memcpy(data, &mCpuBuffer, Size);
             vkUnmapMemory(mDevice, mMemory);
         }
-        void ModifyAndSync(std::function<void(TUniformBufferClass&)> modifyFunc){
+        void ModifyAndSync(FunctionRef<void(TUniformBufferClass&)> modifyFunc){
             modifyFunc(mCpuBuffer);
             Sync();
         }
@@ -46,18 +60,120 @@ namespace ProjectJ{
             info.range = Size;
             return info;
         }
-        void GetStageBit() const {return mStageBit;}
+        VkShaderStageFlags GetStageBit() const {return mStageBit;}
     private:
         TUniformBufferClass mCpuBuffer;
         VkShaderStageFlags mStageBit;
     };
 
+    // One T per element at the device's uniform offset alignment, selected with a dynamic offset
+    // when binding. Persistently mapped, elements are written in place.
+    template<class T>
+    class VulkanDynamicUniformBuffer : public VulkanBufferBase{
+    public:
+        VulkanDynamicUniformBuffer(VulkanRHI& rhi, size_t count, VkShaderStageFlags stageBit)
+            :VulkanBufferBase(rhi, HGetUniformStride(rhi, sizeof(T)) * std::max<size_t>(count, 1),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VulkanMemoryTag::Uniform),
+            mStride(HGetUniformStride(rhi, sizeof(T))), mCount(count), mStageBit(stageBit){
+            void* data;
+            VK_CHECK(vkMapMemory(mDevice, mMemory, 0, VK_WHOLE_SIZE, 0, &data),"failed to map dynamic uniform buffer.");
+            mMapped = static_cast<uint8_t*>(data);
+        }
+        ~VulkanDynamicUniformBuffer(){
+            vkUnmapMemory(mDevice, mMemory);
+        }
+        T& At(size_t index){
+            return *reinterpret_cast<T*>(mMapped + index * mStride);
+        }
+        uint32_t GetDynamicOffset(size_t index) const {return static_cast<uint32_t>(index * mStride);}
+        size_t GetCount() const {return mCount;}
+        VkDescriptorBufferInfo GetBufferInfo() const{
+            VkDescriptorBufferInfo info{};
+            info.buffer = mBuffer;
+            info.offset = 0;
+            info.range = sizeof(T);
+            return info;
+        }
+        VkShaderStageFlags GetStageBit() const {return mStageBit;}
+    private:
+        uint8_t* mMapped;
+        VkDeviceSize mStride;
+        size_t mCount;
+        VkShaderStageFlags mStageBit;
+    };
+
+    // count T in host visible memory, persistently mapped and written in place by the CPU every frame.
     template<class T>
-    class VulkanDynamicUniformBuffer : public VulkanUniformBuffer<T> {};
+    class VulkanMappedBuffer : public VulkanBufferBase{
+    public:
+        VulkanMappedBuffer(VulkanRHI& rhi, size_t count, VkBufferUsageFlags usage, VulkanMemoryTag tag)
+            :VulkanBufferBase(rhi, sizeof(T) * std::max<size_t>(count, 1), usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, tag),
+            mCount(count){
+            void* data;
+            VK_CHECK(vkMapMemory(mDevice, mMemory, 0, VK_WHOLE_SIZE, 0, &data),"failed to map buffer.");
+            mMapped = static_cast<T*>(data);
+        }
+        ~VulkanMappedBuffer(){
+            vkUnmapMemory(mDevice, mMemory);
+        }
+        T& At(size_t index){
+            return mMapped[index];
+        }
+        size_t GetCount() const {return mCount;}
+        VkDescriptorBufferInfo GetBufferInfo() const{
+            VkDescriptorBufferInfo info{};
+            info.buffer = mBuffer;
+            info.offset = 0;
+            info.range = VK_WHOLE_SIZE;
+            return info;
+        }
+    private:
+        T* mMapped;
+        size_t mCount;
+    };
+
+    // Array of T a shader indexes, e.g. per-instance data read with gl_InstanceIndex.
+    template<class T>
+    class VulkanStorageBuffer : public VulkanMappedBuffer<T>{
+    public:
+        VulkanStorageBuffer(VulkanRHI& rhi, size_t count, VkShaderStageFlags stageBit)
+            :VulkanMappedBuffer<T>(rhi, count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VulkanMemoryTag::Storage),
+            mStageBit(stageBit){
+        }
+        VkShaderStageFlags GetStageBit() const {return mStageBit;}
+    private:
+        VkShaderStageFlags mStageBit;
+    };
+
+    // Draw parameters for vkCmdDrawIndexedIndirect.
+    class VulkanIndirectBuffer : public VulkanMappedBuffer<VkDrawIndexedIndirectCommand>{
+    public:
+        VulkanIndirectBuffer(VulkanRHI& rhi, size_t count)
+            :VulkanMappedBuffer<VkDrawIndexedIndirectCommand>(rhi, count, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VulkanMemoryTag::Indirect){
+        }
+    };
+
+    // Device local buffer for data only the GPU reads and writes, e.g. compute shader in- and outputs.
+    class VulkanDeviceBuffer : public VulkanBufferBase{
+    public:
+        VulkanDeviceBuffer(VulkanRHI& rhi, size_t size, VkBufferUsageFlags usage, VulkanMemoryTag tag);
+        // uploads size bytes of data through a staging buffer.
+        VulkanDeviceBuffer(VulkanRHI& rhi, const void* data, size_t size, VkBufferUsageFlags usage, VulkanMemoryTag tag);
+        VkDescriptorBufferInfo GetBufferInfo() const{
+            VkDescriptorBufferInfo info{};
+            info.buffer = mBuffer;
+            info.offset = 0;
+            info.range = VK_WHOLE_SIZE;
+            return info;
+        }
+    };
 
     class VulkanStagingBuffer : public VulkanBufferBase{
     public:
-        VulkanStagingBuffer::VulkanStagingBuffer(void* data, size_t size);
+        VulkanStagingBuffer(VulkanRHI& rhi, void* data, size_t size);
         void CopyToBuffer(const VulkanBufferBase* dstBuffer);
         void CopyToTexture(const class VulkanTexture* dstTex);
     private:
@@ -65,16 +181,30 @@ namespace ProjectJ{
         VkQueue mGraphicQueue;
     };
 
+    // Host cached, persistently mapped destination for GPU to CPU copies.
+    class VulkanReadbackBuffer : public VulkanBufferBase{
+    public:
+        VulkanReadbackBuffer(VulkanRHI& rhi, size_t size);
+        ~VulkanReadbackBuffer();
+        // makes GPU writes visible to the host, needed when the memory is not host coherent.
+        void Invalidate();
+        const uint8_t* GetData() const {return mMapped;}
+    private:
+        uint8_t* mMapped;
+        // no cached type on the device, fell back to host coherent memory.
+        bool mCoherent;
+    };
+
     class VulkanVertexBuffer : public VulkanBufferBase{
     public:
-        VulkanVertexBuffer(void* data, size_t size);
-        VulkanVertexBuffer(size_t size);
+        VulkanVertexBuffer(VulkanRHI& rhi, void* data, size_t size);
+        VulkanVertexBuffer(VulkanRHI& rhi, size_t size);
     };
 
     class VulkanIndexBuffer : public VulkanBufferBase{
     public:
-        VulkanIndexBuffer(void* data, size_t size);
-        VulkanIndexBuffer(size_t size);
+        VulkanIndexBuffer(VulkanRHI& rhi, void* data, size_t size);
+        VulkanIndexBuffer(VulkanRHI& rhi, size_t size);
     };
 
     template<typename>
@@ -85,16 +215,33 @@ namespace ProjectJ{
     template<typename UB>
     struct is_uniform_buffer<std::shared_ptr<VulkanDynamicUniformBuffer<UB> > > : std::true_type {};
 
+    template<typename>
+    struct is_dynamic_uniform_buffer : std::false_type {};
+    template<typename UB>
+    struct is_dynamic_uniform_buffer<std::shared_ptr<VulkanDynamicUniformBuffer<UB> > > : std::true_type {};
+
+    template<typename>
+    struct is_storage_buffer : std::false_type {};
+    template<typename T>
+    struct is_storage_buffer<std::shared_ptr<VulkanStorageBuffer<T> > > : std::true_type {};
+    template<>
+    struct is_storage_buffer<std::shared_ptr<VulkanDeviceBuffer> > : std::true_type {};
+
 
     class VulkanTexture{
         friend class TextureLoader;
         friend class VulkanStagingBuffer;
         friend class VulkanSampler;
     public:
-        VulkanTexture(uint32_t width,uint32_t height, VkFormat format);
+        VulkanTexture(VulkanRHI& rhi, uint32_t width,uint32_t height, VkFormat format,
+            VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VulkanMemoryTag tag = VulkanMemoryTag::Texture);
         ~VulkanTexture();
         void LayoutTransition(VkImageLayout oldLayout, VkImageLayout newLayout);
+        VkImage GetImage() const {return mImage;}
+        VkImageView GetView() const {return mView;}
     private:
+        VulkanRHI& mRHI;
         uint32_t Width;
         uint32_t Height;
         VkFormat Format;
@@ -102,6 +249,29 @@ namespace ProjectJ{
         VkImage mImage;
         VkDeviceMemory mMemory;
         VkImageView mView;
+        VkDeviceSize mAllocationSize;
+        uint32_t mMemoryTypeIndex;
+        VulkanMemoryTag mMemoryTag;
+    };
+
+    // Attachments that passes and frames use one after another, so one image per size, format and usage
+    // serves them all; the render pass dependencies order the accesses. Created on first Acquire.
+    class VulkanRenderTargetPool{
+    public:
+        VulkanRenderTargetPool(VulkanRHI& rhi);
+        std::shared_ptr<VulkanTexture> Acquire(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage);
+        // frees every image not also held by a caller.
+        void Clear();
+    private:
+        struct Key{
+            uint32_t width;
+            uint32_t height;
+            VkFormat format;
+            VkImageUsageFlags usage;
+            bool operator<(const Key& other) const;
+        };
+        VulkanRHI& mRHI;
+        std::map<Key, std::shared_ptr<VulkanTexture> > mTargets;
     };
 
     struct VulkanSamplerDesc{
@@ -111,15 +281,17 @@ namespace ProjectJ{
     };
     class VulkanSampler{
     public:
-        VulkanSampler(const VulkanSamplerDesc& desc);
+        VulkanSampler(VulkanRHI& rhi, const VulkanSamplerDesc& desc);
         ~VulkanSampler();
+        VkSampler GetSampler() const {return mSampler;}
     protected:
+        VkDevice mDevice;
         VkSampler mSampler;
     };
 
     class VulkanTextureSampler : public VulkanTexture, public VulkanSampler {
     public:
-        VulkanTextureSampler(uint32_t width,uint32_t height, VkFormat format, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
+        VulkanTextureSampler(VulkanRHI& rhi, uint32_t width,uint32_t height, VkFormat format, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
 
         VkDescriptorImageInfo GetImageInfo() const;
         VkShaderStageFlags GetStageBit() const {return mStageBit;}
@@ -127,11 +299,13 @@ namespace ProjectJ{
         VkShaderStageFlags mStageBit;
     };
 
-    
+
     class TextureLoader{
     public:
-        static std::shared_ptr<VulkanTexture> CreateTexFromPath(const std::string& path);
-        static std::shared_ptr<VulkanTextureSampler> CreateTexSamplerFromPath(const std::string& path, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
+        static std::shared_ptr<VulkanTexture> CreateTexFromPath(VulkanRHI& rhi, const std::string& path);
+        static std::shared_ptr<VulkanTextureSampler> CreateTexSamplerFromPath(VulkanRHI& rhi, const std::string& path, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
+        // pixels are width x height RGBA8.
+        static std::shared_ptr<VulkanTextureSampler> CreateTexSamplerFromPixels(VulkanRHI& rhi, const uint8_t* pixels, uint32_t width, uint32_t height, const VulkanSamplerDesc& desc, VkShaderStageFlags stageBit);
         
     };
 }
\ No newline at end of file
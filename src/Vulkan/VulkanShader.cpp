@@ -0,0 +1,14 @@
+#include <Jpch.h>
+#include "VulkanShader.h"
+
+namespace ProjectJ{
+    VkDevice VulkanShaderBase::HGetDevice(const VulkanRHI& rhi){
+        return rhi.mDevice;
+    }
+    uint32_t VulkanShaderBase::HGetSwapChainImageCount(const VulkanRHI& rhi){
+        return rhi.mSwapChain->GetImageCount();
+    }
+    bool VulkanShaderBase::HIsUpdateTemplateSupported(const VulkanRHI& rhi){
+        return rhi.mDescriptorUpdateTemplateSupported;
+    }
+}
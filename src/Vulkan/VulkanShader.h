@@ -8,84 +8,162 @@
 namespace ProjectJ{
     template<class TShader> struct ShaderParam;
 
+    // One descriptor as a descriptor update template reads it, the buffer or the image one by binding type.
+    union VulkanDescriptorInfo{
+        VkDescriptorBufferInfo buffer;
+        VkDescriptorImageInfo image;
+    };
+    // the most members for_each_member reflects, so the most bindings a ShaderParam has.
+    constexpr uint32_t MAX_SHADER_BINDINGS = 8;
+
     class VulkanShaderBase{
     public:
         virtual ~VulkanShaderBase(){}
         virtual const VkDescriptorSetLayout& GetDescriptorSetLayout() const = 0;
         virtual const VkDescriptorPool& GetDescriptorPool() const = 0;
+    protected:
+        // VulkanRHI is still incomplete where VulkanShader is defined, so the template reaches it through these.
+        static VkDevice HGetDevice(const VulkanRHI& rhi);
+        static uint32_t HGetSwapChainImageCount(const VulkanRHI& rhi);
+        static bool HIsUpdateTemplateSupported(const VulkanRHI& rhi);
     };
 
+    // Descriptor set layout, pool and update template of one ShaderParam<TShader>, binding i being its
+    // i-th member. A set is written from a DescriptorData, the members' buffer or image infos in the
+    // same order, with one vkUpdateDescriptorSetWithTemplate instead of a VkWriteDescriptorSet per binding.
+    // Shader classes derive from this before their ShaderParam is complete, so the data has room for
+    // any parameter and only its first bindings are read.
     template<class TShader>
     class VulkanShader : public VulkanShaderBase {
-        using Param = typename ShaderParam<TShader>;
-    public:        
-        VulkanShader() 
+        using Param = ShaderParam<TShader>;
+    public:
+        using DescriptorData = std::array<VulkanDescriptorInfo, MAX_SHADER_BINDINGS>;
+
+        // the pool holds maxSets descriptor sets, 0 means one per swap chain image.
+        VulkanShader(VulkanRHI& rhi, uint32_t maxSets = 0) 
+            :mRHI(rhi)
         {
             PCreateDescriptorSetLayout();
-            PCreateDescriptorPool();
+            PCreateDescriptorPool(maxSets != 0 ? maxSets : HGetSwapChainImageCount(mRHI));
+            PCreateDescriptorUpdateTemplate();
         }
         virtual ~VulkanShader()
         {
-            vkDestroyDescriptorPool(RHI::Get().mDevice,mDescriptorPool,nullptr);
-            vkDestroyDescriptorSetLayout(RHI::Get().mDevice,mDescriptorSetLayout,nullptr);
+            if(mUpdateTemplate != VK_NULL_HANDLE){
+                vkDestroyDescriptorUpdateTemplate(HGetDevice(mRHI),mUpdateTemplate,nullptr);
+            }
+            vkDestroyDescriptorPool(HGetDevice(mRHI),mDescriptorPool,nullptr);
+            vkDestroyDescriptorSetLayout(HGetDevice(mRHI),mDescriptorSetLayout,nullptr);
         }
         virtual const VkDescriptorSetLayout& GetDescriptorSetLayout() const {return mDescriptorSetLayout;}
         virtual const VkDescriptorPool& GetDescriptorPool() const {return mDescriptorPool;}
+        // writes every binding of set, a set of this shader's layout.
+        void UpdateDescriptorSet(VkDescriptorSet set, const DescriptorData& data) const{
+            if(mUpdateTemplate != VK_NULL_HANDLE){
+                vkUpdateDescriptorSetWithTemplate(HGetDevice(mRHI),set,mUpdateTemplate,data.data());
+                return;
+            }
+            // Vulkan 1.0 devices have no templates, the same entries become plain writes.
+            std::array<VkWriteDescriptorSet, MAX_SHADER_BINDINGS> writes{};
+            for(uint32_t binding = 0; binding < mBindingCount; binding++){
+                writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[binding].dstSet = set;
+                writes[binding].dstBinding = binding;
+                writes[binding].descriptorCount = 1;
+                writes[binding].descriptorType = mDescriptorTypes[binding];
+                if(mDescriptorTypes[binding] == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER){
+                    writes[binding].pImageInfo = &data[binding].image;
+                }
+                else{
+                    writes[binding].pBufferInfo = &data[binding].buffer;
+                }
+            }
+            vkUpdateDescriptorSets(HGetDevice(mRHI),mBindingCount,writes.data(),0,nullptr);
+        }
+        // stages reading the uniform and storage buffers and the textures, a shader class may hide them.
+        static constexpr VkShaderStageFlags BufferStages = VK_SHADER_STAGE_VERTEX_BIT;
+        static constexpr VkShaderStageFlags ImageStages = VK_SHADER_STAGE_FRAGMENT_BIT;
     private:
+        template<class TMember>
+        static constexpr VkDescriptorType PGetDescriptorType(){
+            if constexpr (is_uniform_buffer<TMember>::value) {
+                return is_dynamic_uniform_buffer<TMember>::value ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            }
+            else if constexpr (is_storage_buffer<TMember>::value) {
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+            else {
+                static_assert(std::is_same_v<TMember, std::shared_ptr<VulkanTextureSampler> >, "unsupported shader parameter.");
+                return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            }
+        }
         void PCreateDescriptorSetLayout(){
+            static_assert(size<Param>() <= MAX_SHADER_BINDINGS, "DescriptorData has no room for every binding.");
             std::vector<VkDescriptorSetLayoutBinding> bindings;// TODO: change to std::array
             for_each_member(Param{}, [&bindings](int index, const auto& val){
-                if constexpr (is_uniform_buffer<std::decay_t<decltype(val)> >::value) {
-                    VkDescriptorSetLayoutBinding uboLayoutBinding{};
-                    uboLayoutBinding.binding = index;
-                    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                    uboLayoutBinding.descriptorCount = 1;
-                    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-                    uboLayoutBinding.pImmutableSamplers = nullptr;
-                    bindings.push_back(uboLayoutBinding);
-                }
-                else if constexpr (std::is_same_v<std::decay_t<decltype(val)>, std::shared_ptr<VulkanTextureSampler> >){       
-                    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-                    samplerLayoutBinding.binding = index;
-                    samplerLayoutBinding.descriptorCount = 1;
-                    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    samplerLayoutBinding.pImmutableSamplers = nullptr;
-                    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-                    bindings.push_back(samplerLayoutBinding);
-                }
+                VkDescriptorSetLayoutBinding binding{};
+                binding.binding = index;
+                binding.descriptorType = PGetDescriptorType<std::decay_t<decltype(val)> >();
+                binding.descriptorCount = 1;
+                binding.stageFlags = binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+                    ? TShader::ImageStages : TShader::BufferStages;
+                binding.pImmutableSamplers = nullptr;
+                bindings.push_back(binding);
             });
             VkDescriptorSetLayoutCreateInfo layoutInfo{};
             layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
             layoutInfo.bindingCount = bindings.size();
             layoutInfo.pBindings = bindings.data();
-            VK_CHECK(vkCreateDescriptorSetLayout(RHI::Get().mDevice,&layoutInfo,nullptr,&mDescriptorSetLayout),"failed to create descriptor set layout.");
+            VK_CHECK(vkCreateDescriptorSetLayout(HGetDevice(mRHI),&layoutInfo,nullptr,&mDescriptorSetLayout),"failed to create descriptor set layout.");
         }
-        void PCreateDescriptorPool(){
+        void PCreateDescriptorPool(uint32_t maxSets){
             std::vector<VkDescriptorPoolSize> poolSizes;
-            for_each_member(Param{}, [&poolSizes](int index, const auto& val){
-                if constexpr (is_uniform_buffer<std::decay_t<decltype(val)> >::value) {
-                    VkDescriptorPoolSize poolSize{};
-                    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                    poolSize.descriptorCount = static_cast<uint32_t>(RHI::Get().mSwapChain->GetImageCount());
-                    poolSizes.push_back(poolSize);
-                }
-                else if constexpr (std::is_same_v<std::decay_t<decltype(val)>, std::shared_ptr<VulkanTextureSampler> >){       
-                    VkDescriptorPoolSize poolSize{};
-                    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    poolSize.descriptorCount = static_cast<uint32_t>(RHI::Get().mSwapChain->GetImageCount());
-                    poolSizes.push_back(poolSize);
-                }
+            for_each_member(Param{}, [&poolSizes, maxSets](int index, const auto& val){
+                VkDescriptorPoolSize poolSize{};
+                poolSize.type = PGetDescriptorType<std::decay_t<decltype(val)> >();
+                poolSize.descriptorCount = maxSets;
+                poolSizes.push_back(poolSize);
             });
             VkDescriptorPoolCreateInfo poolInfo{};
             poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
             poolInfo.poolSizeCount = poolSizes.size();
             poolInfo.pPoolSizes = poolSizes.data();
-            poolInfo.maxSets = static_cast<uint32_t>(RHI::Get().mSwapChain->GetImageCount());   //TODO: fix image count
-            VK_CHECK(vkCreateDescriptorPool(RHI::Get().mDevice,&poolInfo,nullptr,&mDescriptorPool),"failed to create descriptor pool.");
+            poolInfo.maxSets = maxSets;
+            VK_CHECK(vkCreateDescriptorPool(HGetDevice(mRHI),&poolInfo,nullptr,&mDescriptorPool),"failed to create descriptor pool.");
+        }
+        void PCreateDescriptorUpdateTemplate(){
+            std::vector<VkDescriptorUpdateTemplateEntry> entries;
+            for_each_member(Param{}, [this, &entries](int index, const auto& val){
+                mDescriptorTypes[index] = PGetDescriptorType<std::decay_t<decltype(val)> >();
+                VkDescriptorUpdateTemplateEntry entry{};
+                entry.dstBinding = index;
+                entry.dstArrayElement = 0;
+                entry.descriptorCount = 1;
+                entry.descriptorType = mDescriptorTypes[index];
+                entry.offset = index * sizeof(VulkanDescriptorInfo);
+                entry.stride = sizeof(VulkanDescriptorInfo);
+                entries.push_back(entry);
+            });
+            mBindingCount = static_cast<uint32_t>(entries.size());
+            if(!HIsUpdateTemplateSupported(mRHI)){
+                return;
+            }
+            VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+            templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+            templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+            templateInfo.pDescriptorUpdateEntries = entries.data();
+            templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+            templateInfo.descriptorSetLayout = mDescriptorSetLayout;
+            VK_CHECK(vkCreateDescriptorUpdateTemplate(HGetDevice(mRHI),&templateInfo,nullptr,&mUpdateTemplate),"failed to create descriptor update template.");
         }
     private:
+        VulkanRHI& mRHI;
         VkDescriptorSetLayout mDescriptorSetLayout;
         VkDescriptorPool mDescriptorPool;
+        VkDescriptorUpdateTemplate mUpdateTemplate = VK_NULL_HANDLE;
+        // by binding, what the template entries and the fallback writes say.
+        std::array<VkDescriptorType, MAX_SHADER_BINDINGS> mDescriptorTypes{};
+        uint32_t mBindingCount = 0;
     };
     
     std::false_type is_shader_impl(...);
@@ -94,9 +172,15 @@ namespace ProjectJ{
     template<typename T> 
     using is_shader = decltype(is_shader_impl(std::declval<T&>()));
 
-
+    // Vertex inputs of every vertex shader: layout(location = 0) in vec3 inPosition, location 1 in vec3
+    // inColor, location 2 in vec2 inTexCoord. The packed encodings expand to the same inputs on fetch.
+    // VulkanPSO warns about a vertex shader whose position has fewer than 3 components, it drops z.
+    // shaders/vert_depth.vert and vert_instanced_depth.vert are the depth pre-pass versions of vert.vert and
+    // vert_instanced.vert: the same set and only the position input. Both versions declare gl_Position
+    // invariant, so the main pass' EQUAL depth test passes exactly where the pre-pass wrote.
     class TestShader : public VulkanShader<TestShader>{
     public:
+        using VulkanShader<TestShader>::VulkanShader;
     };
     
     template<> 
@@ -104,4 +188,61 @@ namespace ProjectJ{
         std::shared_ptr<VulkanDynamicUniformBuffer<UniformBufferObject> > uniformBuffer;
         std::shared_ptr<VulkanTextureSampler> textureSampler;
     };
+
+    // shaders/vert_instanced.vert: view and projection from viewBuffer, the model matrix from
+    // instanceBuffer[gl_InstanceIndex]. Same inputs as TestShader otherwise; frag_instanced.frag is
+    // frag.frag with the texture at binding 2.
+    class InstancedShader : public VulkanShader<InstancedShader>{
+    public:
+        using VulkanShader<InstancedShader>::VulkanShader;
+    };
+
+    template<>
+    struct ShaderParam<InstancedShader> {
+        std::shared_ptr<VulkanDynamicUniformBuffer<ViewUniformBufferObject> > viewBuffer;
+        std::shared_ptr<VulkanStorageBuffer<InstanceData> > instanceBuffer;
+        std::shared_ptr<VulkanTextureSampler> textureSampler;
+    };
+
+    // Two compute passes over one set, built from shaders/cull.comp and cull_compact.comp. cull.spv,
+    // one invocation per object (local size 64): objects whose bounds are inside the frustum take slot
+    // atomicAdd(batchCounts[batch], 1) of their batch and write model * spin * dequantize there in
+    // instanceBuffer. cull_compact.spv, one invocation per batch (local size 64): a batch with instances
+    // appends its command with that instanceCount to drawBuffer[runFirst + atomicAdd(drawCounts[run], 1)].
+    // With pyramidLevelCount set, cull.spv also drops objects whose bounds lie behind the farthest depth
+    // of pyramidBuffer, the DepthPyramidShader pyramid of the previous frame, under their footprint.
+    class GPUCullShader : public VulkanShader<GPUCullShader>{
+    public:
+        using VulkanShader<GPUCullShader>::VulkanShader;
+        static constexpr VkShaderStageFlags BufferStages = VK_SHADER_STAGE_COMPUTE_BIT;
+    };
+
+    template<>
+    struct ShaderParam<GPUCullShader> {
+        std::shared_ptr<VulkanDynamicUniformBuffer<CullUniformBufferObject> > cullBuffer;
+        std::shared_ptr<VulkanStorageBuffer<GPUCullObject> > objectBuffer;
+        std::shared_ptr<VulkanDeviceBuffer> batchBuffer;
+        std::shared_ptr<VulkanDeviceBuffer> instanceBuffer;
+        std::shared_ptr<VulkanDeviceBuffer> batchCountBuffer;
+        std::shared_ptr<VulkanDeviceBuffer> drawBuffer;
+        std::shared_ptr<VulkanDeviceBuffer> drawCountBuffer;
+        std::shared_ptr<VulkanDeviceBuffer> pyramidBuffer;
+    };
+
+    // shaders/depth_pyramid.comp, one dispatch per level (local size 8x8) with a DepthPyramidLevel push
+    // constant: every texel is the farthest of the 2x2 texels below it, level 0 of the depth attachment
+    // and the others of the previous level. The levels are packed into one float buffer, finest first;
+    // level 0 is half the attachment rounded up and the last one 1x1.
+    class DepthPyramidShader : public VulkanShader<DepthPyramidShader>{
+    public:
+        using VulkanShader<DepthPyramidShader>::VulkanShader;
+        static constexpr VkShaderStageFlags BufferStages = VK_SHADER_STAGE_COMPUTE_BIT;
+        static constexpr VkShaderStageFlags ImageStages = VK_SHADER_STAGE_COMPUTE_BIT;
+    };
+
+    template<>
+    struct ShaderParam<DepthPyramidShader> {
+        std::shared_ptr<VulkanTextureSampler> depth;
+        std::shared_ptr<VulkanDeviceBuffer> pyramid;
+    };
 }
\ No newline at end of file
@@ -103,6 +103,8 @@ namespace ProjectJ{
         createInfo.imageExtent = extent;
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        // lets frames be read back
+        createInfo.imageUsage |= mSwapChainSupportDetails.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
         uint32_t queueFamilyIndices[] = {mQueueFamilyIndices.graphicsFamily.value(), mQueueFamilyIndices.presentFamily.value()};
 
         if (mQueueFamilyIndices.graphicsFamily != mQueueFamilyIndices.presentFamily) {
@@ -128,6 +130,7 @@ namespace ProjectJ{
         vkGetSwapchainImagesKHR(mDevice, mSwapChain, &imageCount, mSwapChainImages.data());
 
         mSwapChainImageFormat = surfaceFormat.format;
+        mImageUsage = createInfo.imageUsage;
         mSwapChainExtent = extent;
     }
     void VulkanSwapChain::PCreateImageViews(){
@@ -150,4 +153,20 @@ namespace ProjectJ{
             VK_CHECK(vkCreateImageView(mDevice,&createInfo,nullptr,&mSwapChainImageViews[i]),"failed to create image views.");
         }
     }
+
+    //------------------------------------ VulkanOffscreenSwapChain -----------------------------------------//
+    VulkanOffscreenSwapChain::VulkanOffscreenSwapChain(VulkanRHI& rhi, const VulkanSwapChainDesc& desc, uint32_t imageCount, VkFormat format)
+        :mFormat(format){
+        mExtent = {desc.width, desc.height};
+        for(uint32_t i = 0; i < imageCount; i++){
+            mImages.push_back(std::make_unique<VulkanTexture>(rhi, desc.width, desc.height, format,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VulkanMemoryTag::RenderTarget));
+            mImageViews.push_back(mImages.back()->GetView());
+        }
+    }
+    uint32_t VulkanOffscreenSwapChain::AcquireNextImage(VkSemaphore semaphore){
+        uint32_t index = mImageIndex;
+        mImageIndex = (mImageIndex + 1) % GetImageCount();
+        return index;
+    }
 }
\ No newline at end of file
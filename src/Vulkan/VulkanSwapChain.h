@@ -1,20 +1,42 @@
 #pragma once
 #include "VulkanDescs.h"
+#include "VulkanResources.h"
 #include <map>
 
 namespace ProjectJ{
-    class VulkanSwapChain{
+    class VulkanSwapChainBase{
+    public:
+        virtual ~VulkanSwapChainBase(){}
+        virtual uint32_t GetImageCount() const = 0;
+        virtual uint32_t AcquireNextImage(VkSemaphore semaphore) = 0;
+        virtual void Present(VkQueue presentQueue, VkSemaphore waitSemaphore) = 0;
+        //TODO: Remove these
+        virtual std::vector<VkImageView>& GetImageViews() = 0;
+        virtual VkImage GetImage(uint32_t index) const = 0;
+        virtual VkImageUsageFlags GetImageUsage() const = 0;
+        virtual VkFormat GetFormat() const = 0;
+        virtual VkExtent2D GetExtent() const = 0;
+        // layout the render pass leaves the images in.
+        virtual VkImageLayout GetFinalLayout() const = 0;
+        // offscreen images need no acquire/present semaphores.
+        virtual bool IsOffscreen() const = 0;
+    };
+
+    class VulkanSwapChain : public VulkanSwapChainBase{
     public:
         VulkanSwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, 
             QueueFamilyIndices queueFamilyIndices, const VulkanSwapChainDesc& desc);
         ~VulkanSwapChain();
-        uint32_t GetImageCount() const {return mSwapChainImageViews.size();}
-        uint32_t AcquireNextImage(VkSemaphore semaphore);
-        void Present(VkQueue presentQueue, VkSemaphore waitSemaphore);
-        //TODO: Remove these
-        std::vector<VkImageView>& GetImageViews() {return mSwapChainImageViews;}
-        VkFormat GetFormat() const {return mSwapChainImageFormat;}
-        VkExtent2D GetExtent() const {return mSwapChainExtent;}
+        uint32_t GetImageCount() const override {return mSwapChainImageViews.size();}
+        uint32_t AcquireNextImage(VkSemaphore semaphore) override;
+        void Present(VkQueue presentQueue, VkSemaphore waitSemaphore) override;
+        std::vector<VkImageView>& GetImageViews() override {return mSwapChainImageViews;}
+        VkImage GetImage(uint32_t index) const override {return mSwapChainImages[index];}
+        VkImageUsageFlags GetImageUsage() const override {return mImageUsage;}
+        VkFormat GetFormat() const override {return mSwapChainImageFormat;}
+        VkExtent2D GetExtent() const override {return mSwapChainExtent;}
+        VkImageLayout GetFinalLayout() const override {return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;}
+        bool IsOffscreen() const override {return false;}
     private:
         void PCreateSwapChain();
         void PCreateImageViews();
@@ -26,6 +48,7 @@ namespace ProjectJ{
         std::vector<VkImage> mSwapChainImages;
         VkFormat mSwapChainImageFormat;
         VkExtent2D mSwapChainExtent;
+        VkImageUsageFlags mImageUsage;
         std::vector<VkImageView> mSwapChainImageViews;
         struct SwapChainSupportDetails{
             VkSurfaceCapabilitiesKHR capabilities;
@@ -38,4 +61,26 @@ namespace ProjectJ{
         VulkanSwapChainDesc mDesc;
         uint32_t mImageIndex = 0;
     };
+
+    // Renders into plain device images, cycled round robin, for running without a window or surface.
+    class VulkanOffscreenSwapChain : public VulkanSwapChainBase{
+    public:
+        VulkanOffscreenSwapChain(VulkanRHI& rhi, const VulkanSwapChainDesc& desc, uint32_t imageCount = 3, VkFormat format = VK_FORMAT_B8G8R8A8_SRGB);
+        uint32_t GetImageCount() const override {return static_cast<uint32_t>(mImages.size());}
+        uint32_t AcquireNextImage(VkSemaphore semaphore) override;
+        void Present(VkQueue presentQueue, VkSemaphore waitSemaphore) override {}
+        std::vector<VkImageView>& GetImageViews() override {return mImageViews;}
+        VkImage GetImage(uint32_t index) const override {return mImages[index]->GetImage();}
+        VkImageUsageFlags GetImageUsage() const override {return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;}
+        VkFormat GetFormat() const override {return mFormat;}
+        VkExtent2D GetExtent() const override {return mExtent;}
+        VkImageLayout GetFinalLayout() const override {return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;}
+        bool IsOffscreen() const override {return true;}
+    private:
+        std::vector<std::unique_ptr<VulkanTexture> > mImages;
+        std::vector<VkImageView> mImageViews;
+        VkFormat mFormat;
+        VkExtent2D mExtent;
+        uint32_t mImageIndex = 0;
+    };
 }
\ No newline at end of file
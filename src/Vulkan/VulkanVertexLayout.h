@@ -0,0 +1,56 @@
+#pragma once
+#include "VulkanInclude.h"
+#include "VulkanPSO.h"
+#include "core/VertexFormat.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+namespace ProjectJ{
+    // Vertex component type -> the VkFormat the input assembler reads it with.
+    template<typename T>
+    struct VulkanVertexFormat;
+    template<> struct VulkanVertexFormat<float>{static constexpr VkFormat value = VK_FORMAT_R32_SFLOAT;};
+    template<> struct VulkanVertexFormat<glm::vec2>{static constexpr VkFormat value = VK_FORMAT_R32G32_SFLOAT;};
+    template<> struct VulkanVertexFormat<glm::vec3>{static constexpr VkFormat value = VK_FORMAT_R32G32B32_SFLOAT;};
+    template<> struct VulkanVertexFormat<glm::vec4>{static constexpr VkFormat value = VK_FORMAT_R32G32B32A32_SFLOAT;};
+    template<> struct VulkanVertexFormat<Half2>{static constexpr VkFormat value = VK_FORMAT_R16G16_SFLOAT;};
+    template<> struct VulkanVertexFormat<Unorm8x4>{static constexpr VkFormat value = VK_FORMAT_R8G8B8A8_UNORM;};
+    template<> struct VulkanVertexFormat<Snorm8x4>{static constexpr VkFormat value = VK_FORMAT_R8G8B8A8_SNORM;};
+    template<> struct VulkanVertexFormat<Snorm16x4>{static constexpr VkFormat value = VK_FORMAT_R16G16B16A16_SNORM;};
+
+    // Adds V as one per-vertex binding plus an attribute for every entry of V::Attributes().
+    template<typename V>
+    void AddVertexStream(VulkanPSODesc& desc, uint32_t binding){
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = binding;
+        bindingDescription.stride = sizeof(V);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        desc.bindingDescriptions.push_back(bindingDescription);
+
+        static const V instance{};
+        std::apply([&desc, binding](const auto&... attributes){
+            auto add = [&desc, binding](const auto& attribute){
+                using Component = typename std::decay_t<decltype(attribute)>::ComponentType;
+                VkVertexInputAttributeDescription attributeDescription{};
+                attributeDescription.binding = binding;
+                attributeDescription.location = attribute.location;
+                attributeDescription.format = VulkanVertexFormat<Component>::value;
+                attributeDescription.offset = static_cast<uint32_t>(
+                    reinterpret_cast<const char*>(&(instance.*attribute.member)) - reinterpret_cast<const char*>(&instance));
+                desc.attributeDescriptions.push_back(attributeDescription);
+            };
+            (add(attributes), ...);
+        }, V::Attributes());
+    }
+
+    // AddVertexStream with only the VERTEX_POSITION_LOCATION attribute, for depth only passes over
+    // interleaved vertices. Split encodings bind their PackedPosition stream instead.
+    template<typename V>
+    void AddVertexPositionStream(VulkanPSODesc& desc, uint32_t binding){
+        AddVertexStream<V>(desc, binding);
+        auto& attributes = desc.attributeDescriptions;
+        attributes.erase(std::remove_if(attributes.begin(), attributes.end(), [binding](const VkVertexInputAttributeDescription& attribute){
+            return attribute.binding == binding && attribute.location != VERTEX_POSITION_LOCATION;
+        }), attributes.end());
+    }
+}
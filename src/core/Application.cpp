@@ -1,6 +1,8 @@
 #include "Jpch.h"
 #include "Application.h"
 #include "RHI.h"
+#include "JobSystem.h"
+#include "FramePacket.h"
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
@@ -9,31 +11,155 @@
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 namespace ProjectJ{
-    RHIType* RHI::gInstance = nullptr;
-    Application::Application(const AppInfo& appInfo){
+    Application::Application(const AppInfo& appInfo)
+        :mAppInfo(appInfo){
 
     }
     void Application::Run(){ 
         Logger::InitGlobally();
+        J_PROFILE_THREAD("Main");
         JLOG_INFO("HI, J-Project");
-        glfwInit();
+        // created here, this becomes the thread its main thread jobs, GLFW calls among them, run on.
+        JobSystem& jobs = JobSystem::Get();
+        GLFWwindow* window = nullptr;
+        std::unique_ptr<RHIType> rhi;
+        {
+            J_PROFILE_SCOPE("Application::Init");
+            if(!mAppInfo.headless){
+                glfwInit();
 
-        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        GLFWwindow* window = glfwCreateWindow(800, 600, "Vulkan window", nullptr, nullptr);
+                glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+                window = glfwCreateWindow(mAppInfo.width, mAppInfo.height, "Vulkan window", nullptr, nullptr);
+            }
 
-        {
             RHIConfig config;
-            config.enableValidationLayer = true;
+            config.enableValidationLayer = mAppInfo.enableValidationLayer;
             config.window = window;
-            RHI::Create(config);
-            while(!glfwWindowShouldClose(window)) {
-                glfwPollEvents();
-                RHI::Get().Draw();
+            config.headless = mAppInfo.headless;
+            config.width = mAppInfo.width;
+            config.height = mAppInfo.height;
+            config.enableReadback = mAppInfo.enableReadback || mAppInfo.enableCapture;
+            config.statsLogInterval = mAppInfo.statsLogInterval;
+            config.fixedTimeStep = mAppInfo.fixedTimeStep;
+            config.vertexEncoding = mAppInfo.vertexEncoding;
+            config.enableInstancing = mAppInfo.enableInstancing;
+            config.enableFrustumCulling = mAppInfo.enableFrustumCulling;
+            config.enableGPUCulling = mAppInfo.enableGPUCulling;
+            config.enableDepth = mAppInfo.enableDepth;
+            config.reverseZ = mAppInfo.reverseZ;
+            config.enableDepthPrepass = mAppInfo.enableDepthPrepass;
+            config.enableOcclusionCulling = mAppInfo.enableOcclusionCulling;
+            config.enableLod = mAppInfo.enableLod;
+            config.lodPixelError = mAppInfo.lodPixelError;
+            config.lodFrameBudgetMs = mAppInfo.lodFrameBudgetMs;
+            Scene scene = CreateDefaultScene();
+            if(!mAppInfo.meshPath.empty()){
+                scene.meshes.push_back({mAppInfo.meshPath, {}});
+                config.scene = &scene;
+            }
+            rhi = RHI::Create(config);
+        }
+        uint64_t readbackFrames = 0;
+        uint64_t readbackBytes = 0;
+        uint64_t readbackStartNs = 0;
+        uint64_t readbackLastNs = 0;
+        std::unique_ptr<FrameCapture> capture;
+        if(mAppInfo.enableCapture){
+            capture = std::make_unique<FrameCapture>(mAppInfo.capture);
+        }
+        if(mAppInfo.enableReadback || mAppInfo.enableCapture){
+            rhi->SetReadbackCallback([&](const ReadbackFrame& frame){
+                readbackLastNs = Profiler::Now();
+                if(readbackStartNs == 0){
+                    readbackStartNs = readbackLastNs;
+                }
+                readbackFrames++;
+                readbackBytes += static_cast<uint64_t>(frame.rowPitch) * frame.height;
+                if(capture){
+                    bool bgra = frame.format == VK_FORMAT_B8G8R8A8_SRGB || frame.format == VK_FORMAT_B8G8R8A8_UNORM;
+                    capture->Submit({frame.data, frame.width, frame.height, frame.rowPitch, bgra, frame.frameSerial});
+                }
+            });
+        }
+        if(mAppInfo.renderThread){
+            // GLFW and the simulation stay here, from now on only the render thread touches the RHI.
+            FramePacketQueue packets(mAppInfo.framePackets);
+            std::exception_ptr renderError;
+            std::thread renderThread([&](){
+                J_PROFILE_THREAD("Render");
+                try{
+                    while(FramePacket* packet = packets.BeginRead()){
+                        J_PROFILE_SCOPE("Frame");
+                        rhi->Draw(*packet);
+                        packets.EndRead();
+                    }
+                }
+                catch(...){
+                    renderError = std::current_exception();
+                    packets.Close();
+                }
+            });
+            uint64_t startNs = Profiler::Now();
+            for(uint64_t frameIndex = 0; mAppInfo.frameCount == 0 || frameIndex < mAppInfo.frameCount; frameIndex++) {
+                J_PROFILE_SCOPE("Simulate");
+                if(window){
+                    if(glfwWindowShouldClose(window)){
+                        break;
+                    }
+                    J_PROFILE_SCOPE("PollEvents");
+                    glfwPollEvents();
+                }
+                jobs.PumpMainThread();
+                FramePacket* packet = packets.BeginWrite();
+                if(!packet){
+                    break;
+                }
+                packet->time = mAppInfo.fixedTimeStep > 0.0f ? frameIndex * mAppInfo.fixedTimeStep : (Profiler::Now() - startNs) / 1e9f;
+                packets.EndWrite();
+            }
+            packets.Close();
+            renderThread.join();
+            JLOG_REPORT("render thread: {} packets, simulation waited {:.1f} ms for a free one, rendering {:.1f} ms for a new one",
+                packets.GetPacketCount(), packets.GetWriteWaitMs(), packets.GetReadWaitMs());
+            if(renderError){
+                std::rethrow_exception(renderError);
+            }
+        }
+        else{
+            for(uint64_t frameIndex = 0; mAppInfo.frameCount == 0 || frameIndex < mAppInfo.frameCount; frameIndex++) {
+                J_PROFILE_SCOPE("Frame");
+                if(window){
+                    if(glfwWindowShouldClose(window)){
+                        break;
+                    }
+                    J_PROFILE_SCOPE("PollEvents");
+                    glfwPollEvents();
+                }
+                jobs.PumpMainThread();
+                rhi->Draw();
             }
         }
-        RHI::Destroy();
-        glfwDestroyWindow(window);
+        {
+            J_PROFILE_SCOPE("Application::Shutdown");
+            // destroying drains the frames still in flight through the callback.
+            rhi.reset();
+            if(readbackFrames > 0){
+                // the first frame starts the clock, so the span holds one interval less than there are frames.
+                double seconds = (readbackLastNs - readbackStartNs) / 1e9;
+                double fps = seconds > 0.0 ? (readbackFrames - 1) / seconds : 0.0;
+                JLOG_REPORT("readback: {} frames, {:.1f} fps, {:.1f} MiB/s", readbackFrames,
+                    fps, fps * readbackBytes / readbackFrames / (1024.0 * 1024.0));
+            }
+            capture.reset();
+            if(window){
+                glfwDestroyWindow(window);
 
-        glfwTerminate();
+                glfwTerminate();
+            }
+        }
+#ifdef J_ENABLE_PROFILING
+        Profiler::WriteChromeTrace(mAppInfo.traceOutputPath);
+#endif
+        Logger::Shutdown();
     }
 }
\ No newline at end of file
@@ -1,13 +1,59 @@
 #pragma once
+#include "FrameCapture.h"
+#include "VertexFormat.h"
 
 namespace ProjectJ{
     struct AppInfo{
-        
+        // headless renders offscreen without GLFW, e.g. on display-less servers.
+        bool headless = false;
+        bool enableValidationLayer = true;
+        uint32_t width = 800;
+        uint32_t height = 600;
+        // 0 runs until the window is closed (or forever when headless).
+        uint64_t frameCount = 0;
+        // OBJ or glTF file drawn instead of the built-in quad when set.
+        std::string meshPath;
+        // seconds the animation advances per frame, 0 follows the wall clock.
+        float fixedTimeStep = 0.0f;
+        // how meshes are stored on the GPU, ignored by the software backend.
+        VertexEncoding vertexEncoding = VertexEncoding::Packed;
+        // one indirect draw per mesh/material batch instead of one draw per object.
+        bool enableInstancing = false;
+        // skips objects outside the camera frustum, only where draws are rebuilt every frame (instancing).
+        bool enableFrustumCulling = false;
+        // culls and compacts the instanced draws in compute shaders, takes precedence over enableFrustumCulling.
+        bool enableGPUCulling = false;
+        // depth tested rendering, optionally with a reverse-Z projection and a depth pre-pass (which implies depth).
+        bool enableDepth = false;
+        bool reverseZ = false;
+        bool enableDepthPrepass = false;
+        // GPU culling also tests against the previous frame's depth, implies depth.
+        bool enableOcclusionCulling = false;
+        // per-object level of detail by projected error, levels generated from the mesh at load. Where
+        // draws are rebuilt every frame: instancing on Vulkan, always on the software backend.
+        bool enableLod = false;
+        float lodPixelError = 1.0f;
+        // > 0 gives up detail while frames take longer than this many milliseconds.
+        float lodFrameBudgetMs = 0.0f;
+        // simulates on the main thread and draws on a thread of its own, handing frames over in a ring of
+        // framePackets (2 or 3) FramePackets, so the next frame is simulated while this one is submitted.
+        bool renderThread = false;
+        uint32_t framePackets = 2;
+        // logs the GPU scope, memory and backend stats every this many frames, 0 never.
+        uint32_t statsLogInterval = 0;
+        // copies every rendered frame back to the CPU and reports the sustained throughput.
+        bool enableReadback = false;
+        // writes every frame to capture.directory when set, implies enableReadback.
+        bool enableCapture = false;
+        FrameCaptureConfig capture;
+        std::string traceOutputPath = "ProjectJ-trace.json";
     };
 
     class Application{
     public:
         Application(const AppInfo& appInfo);
         void Run();
+    private:
+        AppInfo mAppInfo;
     };
 }
\ No newline at end of file
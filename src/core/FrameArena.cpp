@@ -0,0 +1,43 @@
+#include <Jpch.h>
+#include "FrameArena.h"
+
+namespace ProjectJ{
+    namespace{
+        size_t HBlockCount(size_t bytes){
+            return (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        }
+    }
+
+    FrameArena::FrameArena(size_t capacity)
+        :mBuffer(std::make_unique<std::max_align_t[]>(HBlockCount(capacity))), mCapacity(HBlockCount(capacity) * sizeof(std::max_align_t)){
+    }
+
+    void* FrameArena::Allocate(size_t size, size_t alignment){
+        if(alignment > alignof(std::max_align_t)){
+            throw std::runtime_error("frame arena alignment too large.");
+        }
+        size_t offset = (mOffset + alignment - 1) & ~(alignment - 1);
+        if(offset + size <= mCapacity){
+            mFrameBytes += offset + size - mOffset;
+            mOffset = offset + size;
+            return reinterpret_cast<uint8_t*>(mBuffer.get()) + offset;
+        }
+        mOverflow.push_back(std::make_unique<std::max_align_t[]>(std::max<size_t>(HBlockCount(size), 1)));
+        mFrameBytes += size;
+        return mOverflow.back().get();
+    }
+
+    void FrameArena::Reset(){
+        mPeakBytes = std::max(mPeakBytes, mFrameBytes);
+        if(!mOverflow.empty()){
+            // alignment padding makes the peak a little tight, the headroom covers it.
+            size_t capacity = std::max(mCapacity * 2, mPeakBytes + mPeakBytes / 4);
+            JLOG_INFO("frame arena grows from {} to {} bytes.", mCapacity, capacity);
+            mBuffer = std::make_unique<std::max_align_t[]>(HBlockCount(capacity));
+            mCapacity = HBlockCount(capacity) * sizeof(std::max_align_t);
+            mOverflow.clear();
+        }
+        mOffset = 0;
+        mFrameBytes = 0;
+    }
+}
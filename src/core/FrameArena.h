@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace ProjectJ{
+    constexpr size_t DEFAULT_FRAME_ARENA_SIZE = 1 << 20;
+
+    // Linear allocator for memory that only lives until the end of a frame: allocating bumps an
+    // offset, Reset at the start of the next frame releases everything at once. What does not fit
+    // goes to the heap for this frame, and the next Reset grows the arena to the frame's peak, so
+    // after warm-up a frame allocates nothing from the heap. Nothing is constructed or destroyed,
+    // only trivially destructible types belong here. One thread at a time.
+    class FrameArena{
+    public:
+        FrameArena(size_t capacity = DEFAULT_FRAME_ARENA_SIZE);
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        // alignment at most alignof(std::max_align_t).
+        void* Allocate(size_t size, size_t alignment);
+        // count uninitialized Ts, valid until the next Reset.
+        template<class T>
+        T* Allocate(size_t count){
+            static_assert(std::is_trivially_destructible<T>::value, "frame arena memory is never destroyed.");
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+        // frees this frame's allocations, grows the arena if they did not fit.
+        void Reset();
+
+        size_t GetCapacity() const {return mCapacity;}
+        // this frame's bytes so far and the most any frame used, overflow included.
+        size_t GetUsedBytes() const {return mFrameBytes;}
+        size_t GetPeakBytes() const {return mPeakBytes;}
+    private:
+        std::unique_ptr<std::max_align_t[]> mBuffer;
+        size_t mCapacity = 0;
+        size_t mOffset = 0;
+        size_t mFrameBytes = 0;
+        size_t mPeakBytes = 0;
+        // heap blocks of this frame's allocations past the capacity.
+        std::vector<std::unique_ptr<std::max_align_t[]> > mOverflow;
+    };
+}
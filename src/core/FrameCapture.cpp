@@ -0,0 +1,161 @@
+#include <Jpch.h>
+#include "FrameCapture.h"
+#include <cstring>
+#include <iomanip>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+namespace ProjectJ{
+    FrameCapture::FrameCapture(const FrameCaptureConfig& config)
+        :mConfig(config){
+        if(mConfig.queueCapacity == 0){
+            mConfig.queueCapacity = 1;
+        }
+        uint32_t workerCount = mConfig.workerCount;
+        if(workerCount == 0){
+            workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(mConfig.directory, error);
+        if(error){
+            JLOG_ERROR("failed to create capture directory {}: {}", mConfig.directory, error.message());
+        }
+        mWorkers.reserve(workerCount);
+        for(uint32_t i = 0; i < workerCount; i++){
+            mWorkers.emplace_back([this](){ PWorkerLoop(); });
+        }
+        JLOG_INFO("frame capture to {} with {} workers, {} buffers", mConfig.directory, workerCount, mConfig.queueCapacity);
+    }
+    FrameCapture::~FrameCapture(){
+        Flush();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mJobAvailable.notify_all();
+        for(auto& worker : mWorkers){
+            worker.join();
+        }
+        auto stats = GetStats();
+        JLOG_REPORT("frame capture: {} written, {} dropped, {} failed, {:.2f} ms blocked",
+            stats.written, stats.dropped, stats.failed, stats.blockedMs);
+    }
+    bool FrameCapture::Submit(const CaptureImage& image){
+        J_PROFILE_FUNCTION();
+        mSubmitted++;
+        std::vector<uint8_t> buffer;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if(mBuffersInUse == mConfig.queueCapacity){
+                if(mConfig.overflow == CaptureOverflow::Drop){
+                    mDropped++;
+                    return false;
+                }
+                uint64_t start = Profiler::Now();
+                mBufferAvailable.wait(lock, [this](){ return mBuffersInUse < mConfig.queueCapacity; });
+                mBlockedNs += Profiler::Now() - start;
+            }
+            mBuffersInUse++;
+            if(!mFreeBuffers.empty()){
+                buffer = std::move(mFreeBuffers.back());
+                mFreeBuffers.pop_back();
+            }
+        }
+
+        // the source is only valid during this call, copy it out tightly packed.
+        size_t rowSize = static_cast<size_t>(image.width) * 4;
+        buffer.resize(rowSize * image.height);
+        if(image.rowPitch == rowSize){
+            std::memcpy(buffer.data(), image.data, buffer.size());
+        }
+        else{
+            for(uint32_t y = 0; y < image.height; y++){
+                std::memcpy(buffer.data() + y * rowSize, image.data + static_cast<size_t>(y) * image.rowPitch, rowSize);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back({std::move(buffer), image.width, image.height, image.bgra, image.frameIndex});
+        }
+        mJobAvailable.notify_one();
+        return true;
+    }
+    void FrameCapture::Flush(){
+        std::unique_lock<std::mutex> lock(mMutex);
+        mIdle.wait(lock, [this](){ return mBuffersInUse == 0; });
+    }
+    FrameCaptureStats FrameCapture::GetStats() const{
+        return {mSubmitted.load(), mWritten.load(), mDropped.load(), mFailed.load(), mBlockedNs.load() / 1e6};
+    }
+    void FrameCapture::PWorkerLoop(){
+        J_PROFILE_THREAD("CaptureWorker");
+        while(true){
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobAvailable.wait(lock, [this](){ return mStop || !mJobs.empty(); });
+                if(mJobs.empty()){
+                    return;
+                }
+                job = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+
+            if(PEncode(job)){
+                mWritten++;
+            }
+            else{
+                mFailed++;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFreeBuffers.push_back(std::move(job.pixels));
+                mBuffersInUse--;
+                if(mBuffersInUse == 0){
+                    mIdle.notify_all();
+                }
+            }
+            mBufferAvailable.notify_one();
+        }
+    }
+    bool FrameCapture::PEncode(Job& job) const{
+        J_PROFILE_SCOPE("EncodeFrame");
+        if(job.bgra){
+            for(size_t i = 0; i < job.pixels.size(); i += 4){
+                std::swap(job.pixels[i], job.pixels[i + 2]);
+            }
+        }
+        std::string path = PGetPath(job.frameIndex);
+        int w = static_cast<int>(job.width);
+        int h = static_cast<int>(job.height);
+        bool result = false;
+        switch(mConfig.format){
+            case CaptureFormat::Png:
+                result = stbi_write_png(path.c_str(), w, h, 4, job.pixels.data(), w * 4) != 0;
+                break;
+            case CaptureFormat::Jpeg:
+                result = stbi_write_jpg(path.c_str(), w, h, 4, job.pixels.data(), mConfig.jpegQuality) != 0;
+                break;
+            case CaptureFormat::Raw:{
+                std::ofstream out(path, std::ios::binary);
+                out.write(reinterpret_cast<const char*>(job.pixels.data()), job.pixels.size());
+                result = out.good();
+                break;
+            }
+        }
+        if(!result){
+            JLOG_ERROR("failed to write capture {}", path);
+        }
+        return result;
+    }
+    std::string FrameCapture::PGetPath(uint64_t frameIndex) const{
+        static const char* extensions[] = {"png", "jpg", "rgba"};
+        std::ostringstream path;
+        path << mConfig.directory << '/' << mConfig.prefix << '_' << std::setw(6) << std::setfill('0') << frameIndex
+            << '.' << extensions[static_cast<size_t>(mConfig.format)];
+        return path.str();
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace ProjectJ{
+    enum class CaptureFormat{
+        Png,
+        Jpeg,
+        // tightly packed RGBA8 rows, no header.
+        Raw
+    };
+    // what Submit does when every pooled buffer is still waiting to be encoded.
+    enum class CaptureOverflow{
+        Block,
+        Drop
+    };
+
+    struct FrameCaptureConfig{
+        std::string directory = "capture";
+        std::string prefix = "frame";
+        CaptureFormat format = CaptureFormat::Png;
+        int jpegQuality = 90;
+        // 0 uses every core but the one driving the render loop.
+        uint32_t workerCount = 0;
+        // frames that may be queued or encoding at once, bounds the sink's memory.
+        uint32_t queueCapacity = 8;
+        CaptureOverflow overflow = CaptureOverflow::Block;
+    };
+
+    // 8 bit, 4 channel image; only needs to stay valid for the duration of Submit.
+    struct CaptureImage{
+        const uint8_t* data;
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitch;
+        bool bgra;
+        uint64_t frameIndex;
+    };
+
+    struct FrameCaptureStats{
+        uint64_t submitted;
+        uint64_t written;
+        uint64_t dropped;
+        uint64_t failed;
+        // time Submit spent waiting for a free buffer.
+        double blockedMs;
+    };
+
+    // Writes frames to disk on a pool of worker threads. Submit only copies the pixels into a
+    // pooled buffer; swizzling, encoding and file IO all happen on the workers.
+    class FrameCapture{
+    public:
+        FrameCapture(const FrameCaptureConfig& config);
+        // waits for every queued frame to be written.
+        ~FrameCapture();
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        // false if the frame was dropped.
+        bool Submit(const CaptureImage& image);
+        void Flush();
+        FrameCaptureStats GetStats() const;
+    private:
+        struct Job{
+            std::vector<uint8_t> pixels;
+            uint32_t width;
+            uint32_t height;
+            bool bgra;
+            uint64_t frameIndex;
+        };
+        void PWorkerLoop();
+        bool PEncode(Job& job) const;
+        std::string PGetPath(uint64_t frameIndex) const;
+
+        FrameCaptureConfig mConfig;
+        std::vector<std::thread> mWorkers;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mJobAvailable;
+        std::condition_variable mBufferAvailable;
+        std::condition_variable mIdle;
+        std::deque<Job> mJobs;
+        std::vector<std::vector<uint8_t> > mFreeBuffers;
+        uint32_t mBuffersInUse = 0;
+        bool mStop = false;
+
+        std::atomic<uint64_t> mSubmitted{0};
+        std::atomic<uint64_t> mWritten{0};
+        std::atomic<uint64_t> mDropped{0};
+        std::atomic<uint64_t> mFailed{0};
+        std::atomic<uint64_t> mBlockedNs{0};
+    };
+}
@@ -0,0 +1,65 @@
+#include <Jpch.h>
+#include "FramePacket.h"
+
+namespace ProjectJ{
+    FramePacketQueue::FramePacketQueue(uint32_t packetCount)
+        :mPackets(std::clamp(packetCount, 2u, MAX_FRAME_PACKETS)){
+    }
+
+    FramePacket* FramePacketQueue::BeginWrite(){
+        std::unique_lock<std::mutex> lock(mMutex);
+        uint64_t start = Profiler::Now();
+        mCondition.wait(lock, [this](){return mClosed || mWritten - mRead < mPackets.size();});
+        mWriteWaitNs += Profiler::Now() - start;
+        if(mClosed){
+            return nullptr;
+        }
+        FramePacket& packet = mPackets[mWritten % mPackets.size()];
+        packet.frameIndex = mWritten;
+        packet.time = 0.0f;
+        packet.transforms.clear();
+        return &packet;
+    }
+    void FramePacketQueue::EndWrite(){
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWritten++;
+        }
+        mCondition.notify_all();
+    }
+
+    FramePacket* FramePacketQueue::BeginRead(){
+        std::unique_lock<std::mutex> lock(mMutex);
+        uint64_t start = Profiler::Now();
+        mCondition.wait(lock, [this](){return mClosed || mRead < mWritten;});
+        mReadWaitNs += Profiler::Now() - start;
+        if(mRead == mWritten){
+            return nullptr;
+        }
+        return &mPackets[mRead % mPackets.size()];
+    }
+    void FramePacketQueue::EndRead(){
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mRead++;
+        }
+        mCondition.notify_all();
+    }
+
+    void FramePacketQueue::Close(){
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClosed = true;
+        }
+        mCondition.notify_all();
+    }
+
+    double FramePacketQueue::GetWriteWaitMs() const{
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mWriteWaitNs / 1e6;
+    }
+    double FramePacketQueue::GetReadWaitMs() const{
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mReadWaitNs / 1e6;
+    }
+}
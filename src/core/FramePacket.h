@@ -0,0 +1,60 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/mat4x4.hpp>
+#include <condition_variable>
+#include <mutex>
+
+namespace ProjectJ{
+    // A SceneGraph::SetLocal the simulation made for this frame.
+    struct NodeTransform{
+        uint32_t handle;
+        glm::mat4 local;
+    };
+    // Everything the simulation decided for one frame, what a backend's Draw(const FramePacket&) renders.
+    struct FramePacket{
+        uint64_t frameIndex = 0;
+        // animation time in seconds, what ComputeSceneView takes.
+        float time = 0.0f;
+        std::vector<NodeTransform> transforms;
+    };
+
+    // triple buffering, more only adds latency.
+    constexpr uint32_t MAX_FRAME_PACKETS = 3;
+
+    // Fixed ring of FramePackets handed from a simulation thread to a render thread: while the
+    // renderer draws packet N the simulation already fills N+1 (double buffered) or N+2 as well
+    // (triple buffered). Either side waits only when the ring is full or empty. Packets are reused,
+    // their vectors keep their capacity from frame to frame. One producer and one consumer thread.
+    class FramePacketQueue{
+    public:
+        // packetCount is clamped to [2, MAX_FRAME_PACKETS].
+        FramePacketQueue(uint32_t packetCount = 2);
+        FramePacketQueue(const FramePacketQueue&) = delete;
+        FramePacketQueue& operator=(const FramePacketQueue&) = delete;
+
+        // the next free packet, cleared; nullptr once closed. Owned by the producer until EndWrite.
+        FramePacket* BeginWrite();
+        void EndWrite();
+        // the oldest published packet; nullptr once closed and every published packet was read.
+        FramePacket* BeginRead();
+        void EndRead();
+        // wakes both sides, BeginWrite fails from now on and BeginRead once the ring is drained.
+        void Close();
+
+        uint32_t GetPacketCount() const {return static_cast<uint32_t>(mPackets.size());}
+        // time the producer waited for a free packet and the consumer for a published one.
+        double GetWriteWaitMs() const;
+        double GetReadWaitMs() const;
+    private:
+        std::vector<FramePacket> mPackets;
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+        // packets published by the producer and released by the consumer so far.
+        uint64_t mWritten = 0;
+        uint64_t mRead = 0;
+        bool mClosed = false;
+        uint64_t mWriteWaitNs = 0;
+        uint64_t mReadWaitNs = 0;
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ProjectJ{
+    template<class TSignature>
+    class FunctionRef;
+
+    // Non-owning view of a callable, for parameters that are only called before the function taking
+    // them returns. Unlike std::function it never copies the callable or allocates, so it is what
+    // per-frame APIs take; the callable has to outlive the FunctionRef.
+    template<class TResult, class... TArgs>
+    class FunctionRef<TResult(TArgs...)>{
+    public:
+        template<class TCallable, class = std::enable_if_t<!std::is_same<std::decay_t<TCallable>, FunctionRef>::value> >
+        FunctionRef(TCallable&& callable)
+            :mCallable(const_cast<void*>(static_cast<const void*>(std::addressof(callable)))),
+            mInvoke([](void* target, TArgs... args) -> TResult{
+                return (*static_cast<std::add_pointer_t<TCallable> >(target))(std::forward<TArgs>(args)...);
+            }){
+        }
+        TResult operator()(TArgs... args) const{
+            return mInvoke(mCallable, std::forward<TArgs>(args)...);
+        }
+    private:
+        void* mCallable;
+        TResult (*mInvoke)(void*, TArgs...);
+    };
+}
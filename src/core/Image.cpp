@@ -0,0 +1,27 @@
+#include <Jpch.h>
+#include "Image.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize.h"
+
+namespace ProjectJ{
+    void DecodedImage::Deleter::operator()(uint8_t* pixels) const{
+        stbi_image_free(pixels);
+    }
+    DecodedImage DecodeImage(const std::string& path){
+        J_PROFILE_FUNCTION();
+        int texWidth, texHeight, texChannels;
+        stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+        if (!pixels) {
+            throw std::runtime_error("failed to load texture image!");
+        }
+        DecodedImage image;
+        image.width = static_cast<uint32_t>(texWidth);
+        image.height = static_cast<uint32_t>(texHeight);
+        image.pixels.reset(pixels);
+        return image;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace ProjectJ{
+    struct DecodedImage{
+        struct Deleter{
+            void operator()(uint8_t* pixels) const;
+        };
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // RGBA8
+        std::unique_ptr<uint8_t, Deleter> pixels;
+    };
+    // png, jpg, bmp, tga... anything stb_image reads, expanded to RGBA8. Throws if the file can not be decoded.
+    DecodedImage DecodeImage(const std::string& path);
+}
@@ -0,0 +1,273 @@
+#include <Jpch.h>
+#include "JobSystem.h"
+
+namespace ProjectJ{
+    namespace{
+        // which pool's worker the current thread is, if any.
+        thread_local const JobSystem* tWorkerOwner = nullptr;
+        thread_local uint32_t tWorkerIndex = 0;
+    }
+
+    JobSystem::JobSystem(uint32_t workerCount)
+        :mMainThread(std::this_thread::get_id()){
+        if(workerCount == 0){
+            workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        }
+        for(uint32_t i = 0; i < workerCount; i++){
+            mQueues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for(uint32_t i = 0; i < workerCount; i++){
+            mWorkers.emplace_back([this, i](){
+                J_PROFILE_THREAD("JobWorker");
+                PWorkerLoop(i);
+            });
+        }
+    }
+    JobSystem::~JobSystem(){
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWakeCondition.notify_all();
+        for(auto& worker : mWorkers){
+            worker.join();
+        }
+    }
+    JobSystem& JobSystem::Get(){
+        static JobSystem system;
+        return system;
+    }
+
+    void JobSystem::Run(Job job, JobCounter* counter, JobCounter* dependency){
+        if(counter){
+            counter->mValue.fetch_add(1);
+        }
+        if(dependency){
+            std::lock_guard<std::mutex> lock(dependency->mMutex);
+            // whoever brings it to zero drains the continuations under the same lock.
+            if(dependency->mValue.load() != 0){
+                dependency->mContinuations.emplace_back(std::move(job), counter);
+                return;
+            }
+        }
+        PPush({std::move(job), counter});
+    }
+
+    void JobSystem::Wait(JobCounter& counter){
+        bool mainThread = IsMainThread();
+        while(counter.mValue.load() != 0){
+            if(mainThread && mPendingMainJobs.load() > 0){
+                PumpMainThread();
+                continue;
+            }
+            QueuedJob job;
+            if(PPop(job)){
+                PExecute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWakeCondition.wait(lock, [&](){
+                return counter.mValue.load() == 0 || mPendingJobs.load() > 0 || (mainThread && mPendingMainJobs.load() > 0);
+            });
+        }
+        // the job that brought it to zero may still hold its lock, the caller may destroy it after this.
+        std::lock_guard<std::mutex> lock(counter.mMutex);
+    }
+
+    void JobSystem::ParallelFor(uint32_t count, FunctionRef<void(uint32_t)> func, uint32_t maxThreads){
+        uint32_t threads = std::min(count, maxThreads == 0 ? GetThreadCount() : std::min(maxThreads, GetThreadCount()));
+        if(threads <= 1){
+            for(uint32_t i = 0; i < count; i++){
+                func(i);
+            }
+            return;
+        }
+        // one runner per thread pulling indices, not a job per index.
+        struct ParallelForState{
+            FunctionRef<void(uint32_t)> func;
+            uint32_t count;
+            std::atomic<uint32_t> nextIndex{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+        };
+        ParallelForState state{func, count};
+        // a single reference, well inside Job's inline storage.
+        auto runner = [&state](){
+            uint32_t index;
+            while((index = state.nextIndex.fetch_add(1)) < state.count){
+                try{
+                    state.func(index);
+                }
+                catch(...){
+                    if(!state.failed.exchange(true)){
+                        state.error = std::current_exception();
+                    }
+                    state.nextIndex.store(state.count);
+                }
+            }
+        };
+        JobCounter counter;
+        for(uint32_t i = 1; i < threads; i++){
+            Run(runner, &counter);
+        }
+        runner();
+        Wait(counter);
+        if(state.error){
+            std::rethrow_exception(state.error);
+        }
+    }
+
+    void JobSystem::RunOnMainThread(Job job, JobCounter* counter){
+        if(IsMainThread()){
+            job();
+            return;
+        }
+        if(counter){
+            counter->mValue.fetch_add(1);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMainQueue.mutex);
+            mMainQueue.PushBack({std::move(job), counter});
+        }
+        mPendingMainJobs.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+        }
+        mWakeCondition.notify_all();
+    }
+    void JobSystem::PumpMainThread(){
+        if(!IsMainThread()){
+            throw std::runtime_error("main thread jobs can only run on the main thread.");
+        }
+        if(mPendingMainJobs.load() == 0){
+            return;
+        }
+        // only what is queued now, jobs these queue run on the next pump.
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(mMainQueue.mutex);
+            count = mMainQueue.count;
+        }
+        for(size_t i = 0; i < count; i++){
+            QueuedJob job;
+            {
+                std::lock_guard<std::mutex> lock(mMainQueue.mutex);
+                mMainQueue.PopFront(job);
+            }
+            mPendingMainJobs.fetch_sub(1);
+            PExecute(job);
+        }
+    }
+
+    void JobSystem::PPush(QueuedJob job){
+        WorkerQueue& queue = tWorkerOwner == this ? *mQueues[tWorkerIndex] : mSharedQueue;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.PushBack(std::move(job));
+        }
+        mPendingJobs.fetch_add(1);
+        // taking the lock orders the count against a sleeper's check of it.
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+        }
+        mWakeCondition.notify_one();
+    }
+    bool JobSystem::PPop(QueuedJob& job){
+        bool isWorker = tWorkerOwner == this;
+        auto take = [&](WorkerQueue& queue, bool newest){
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(!(newest ? queue.PopBack(job) : queue.PopFront(job))){
+                return false;
+            }
+            mPendingJobs.fetch_sub(1);
+            return true;
+        };
+        // newest first keeps a worker on the data it just touched, thieves take the oldest work.
+        if(isWorker && take(*mQueues[tWorkerIndex], true)){
+            return true;
+        }
+        if(take(mSharedQueue, false)){
+            return true;
+        }
+        uint32_t queueCount = static_cast<uint32_t>(mQueues.size());
+        uint32_t first = isWorker ? tWorkerIndex + 1 : 0;
+        for(uint32_t i = 0; i < queueCount; i++){
+            uint32_t victim = (first + i) % queueCount;
+            if((!isWorker || victim != tWorkerIndex) && take(*mQueues[victim], false)){
+                return true;
+            }
+        }
+        return false;
+    }
+    void JobSystem::PExecute(QueuedJob& job){
+        job.func();
+        PFinish(job.counter);
+    }
+    void JobSystem::PFinish(JobCounter* counter){
+        if(!counter){
+            return;
+        }
+        std::vector<std::pair<Job, JobCounter*> > continuations;
+        {
+            std::lock_guard<std::mutex> lock(counter->mMutex);
+            if(counter->mValue.fetch_sub(1) != 1){
+                return;
+            }
+            continuations.swap(counter->mContinuations);
+        }
+        for(auto& continuation : continuations){
+            PPush({std::move(continuation.first), continuation.second});
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+        }
+        mWakeCondition.notify_all();
+    }
+
+    void JobSystem::PWorkerLoop(uint32_t worker){
+        tWorkerOwner = this;
+        tWorkerIndex = worker;
+        while(true){
+            QueuedJob job;
+            if(PPop(job)){
+                PExecute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWakeCondition.wait(lock, [this](){return mStop || mPendingJobs.load() > 0;});
+            if(mStop){
+                return;
+            }
+        }
+    }
+
+    void JobSystem::WorkerQueue::PushBack(QueuedJob job){
+        if(count == jobs.size()){
+            std::vector<QueuedJob> grown(std::max<size_t>(jobs.size() * 2, 16));
+            for(size_t i = 0; i < count; i++){
+                grown[i] = std::move(jobs[(head + i) % jobs.size()]);
+            }
+            jobs.swap(grown);
+            head = 0;
+        }
+        jobs[(head + count) % jobs.size()] = std::move(job);
+        count++;
+    }
+    bool JobSystem::WorkerQueue::PopFront(QueuedJob& job){
+        if(count == 0){
+            return false;
+        }
+        job = std::move(jobs[head]);
+        head = (head + 1) % jobs.size();
+        count--;
+        return true;
+    }
+    bool JobSystem::WorkerQueue::PopBack(QueuedJob& job){
+        if(count == 0){
+            return false;
+        }
+        count--;
+        job = std::move(jobs[(head + count) % jobs.size()]);
+        return true;
+    }
+}
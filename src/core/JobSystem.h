@@ -0,0 +1,168 @@
+#pragma once
+#include "FunctionRef.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+
+namespace ProjectJ{
+    // A queued callable, stored inline so queueing a job never allocates. Callables that don't fit
+    // fail to compile; capture a pointer to bigger state instead.
+    class Job{
+    public:
+        static constexpr size_t STORAGE_SIZE = 48;
+
+        Job() = default;
+        template<class TCallable, class = std::enable_if_t<!std::is_same<std::decay_t<TCallable>, Job>::value> >
+        Job(TCallable&& callable)
+            :mOps(&kOps<std::decay_t<TCallable> >){
+            using TStored = std::decay_t<TCallable>;
+            static_assert(sizeof(TStored) <= STORAGE_SIZE && alignof(TStored) <= alignof(std::max_align_t), "job callable too large to store inline.");
+            static_assert(std::is_nothrow_move_constructible<TStored>::value, "jobs move between queues, their callables must not throw when moved.");
+            new(mStorage) TStored(std::forward<TCallable>(callable));
+        }
+        Job(Job&& other) noexcept
+            :mOps(other.mOps){
+            if(mOps){
+                mOps->move(mStorage, other.mStorage);
+                other.PReset();
+            }
+        }
+        Job& operator=(Job&& other) noexcept{
+            if(this != &other){
+                PReset();
+                if(other.mOps){
+                    mOps = other.mOps;
+                    mOps->move(mStorage, other.mStorage);
+                    other.PReset();
+                }
+            }
+            return *this;
+        }
+        ~Job(){
+            PReset();
+        }
+        explicit operator bool() const {return mOps != nullptr;}
+        void operator()(){
+            mOps->invoke(mStorage);
+        }
+    private:
+        struct Ops{
+            void (*invoke)(void*);
+            // move constructs into dst and destroys src.
+            void (*move)(void* dst, void* src);
+            void (*destroy)(void*);
+        };
+        template<class TStored>
+        static constexpr Ops kOps = {
+            [](void* target){ (*static_cast<TStored*>(target))(); },
+            [](void* dst, void* src){
+                new(dst) TStored(std::move(*static_cast<TStored*>(src)));
+                static_cast<TStored*>(src)->~TStored();
+            },
+            [](void* target){ static_cast<TStored*>(target)->~TStored(); }
+        };
+        void PReset(){
+            if(mOps){
+                mOps->destroy(mStorage);
+                mOps = nullptr;
+            }
+        }
+
+        alignas(std::max_align_t) unsigned char mStorage[STORAGE_SIZE];
+        const Ops* mOps = nullptr;
+    };
+
+    // Counts unfinished jobs: Run increments it, the job decrements it when done. Waiting on it and
+    // jobs depending on it see zero once every job it was passed to has finished. Reusable, and only
+    // safe to destroy, once waited on.
+    class JobCounter{
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+        bool IsDone() const {return mValue.load() == 0;}
+    private:
+        friend class JobSystem;
+        std::atomic<uint32_t> mValue{0};
+        // jobs waiting for zero, queued by whoever brings it there.
+        std::mutex mMutex;
+        std::vector<std::pair<Job, JobCounter*> > mContinuations;
+    };
+
+    // One pool of worker threads sized to the machine, shared by everything in the process. Every
+    // worker pushes and pops the jobs it queues itself at the back of its own deque and steals from
+    // the front of the others' when it runs dry; other threads queue into a shared deque. Waiting
+    // never blocks a thread that could work, Wait runs queued jobs until its counter drops to zero.
+    //
+    // The main thread, the one that first called Get, additionally owns a queue of its own for work
+    // that has to happen there, like GLFW calls; it runs in PumpMainThread and while the main thread waits.
+    // Jobs must not throw, ParallelFor passes exceptions on to its caller. Jobs are stored inline, so
+    // once the queues have grown to the frame's job count neither queueing nor ParallelFor allocate.
+    class JobSystem{
+    public:
+        // workerCount 0 starts one worker per core but the calling thread's.
+        JobSystem(uint32_t workerCount = 0);
+        // drops the jobs still queued and joins the workers.
+        ~JobSystem();
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+        // the process wide pool, created on first use.
+        static JobSystem& Get();
+
+        // workers plus the thread waiting on them.
+        uint32_t GetThreadCount() const {return static_cast<uint32_t>(mWorkers.size()) + 1;}
+        bool IsMainThread() const {return std::this_thread::get_id() == mMainThread;}
+
+        // queues job; counter is incremented now and decremented once the job has run. With a
+        // dependency the job is only queued once that counter drops to zero.
+        void Run(Job job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+        // runs queued jobs until counter drops to zero.
+        void Wait(JobCounter& counter);
+        // func(0..count-1) on at most maxThreads threads, the caller included, 0 for all of them.
+        // Returns once every index ran; the first exception thrown is rethrown here.
+        void ParallelFor(uint32_t count, FunctionRef<void(uint32_t)> func, uint32_t maxThreads = 0);
+
+        // queues job for the main thread, runs it right away when called there.
+        void RunOnMainThread(Job job, JobCounter* counter = nullptr);
+        // runs the jobs queued for the main thread; only the main thread may call it.
+        void PumpMainThread();
+    private:
+        struct QueuedJob{
+            Job func;
+            JobCounter* counter;
+        };
+        // ring buffer that grows but never shrinks.
+        struct WorkerQueue{
+            std::mutex mutex;
+            std::vector<QueuedJob> jobs;
+            size_t head = 0;
+            size_t count = 0;
+
+            void PushBack(QueuedJob job);
+            bool PopFront(QueuedJob& job);
+            bool PopBack(QueuedJob& job);
+        };
+        void PPush(QueuedJob job);
+        // the calling thread's next job: its own newest, then the shared queue's oldest, then stolen.
+        bool PPop(QueuedJob& job);
+        void PExecute(QueuedJob& job);
+        // decrements counter, queues its continuations once it reaches zero and wakes its waiters.
+        void PFinish(JobCounter* counter);
+        void PWorkerLoop(uint32_t worker);
+    private:
+        std::thread::id mMainThread;
+        std::vector<std::thread> mWorkers;
+        std::vector<std::unique_ptr<WorkerQueue> > mQueues;
+        WorkerQueue mSharedQueue;
+        WorkerQueue mMainQueue;
+        // jobs queued and not yet taken, what sleeping threads wake up for.
+        std::atomic<uint32_t> mPendingJobs{0};
+        std::atomic<uint32_t> mPendingMainJobs{0};
+        std::mutex mMutex;
+        std::condition_variable mWakeCondition;
+        bool mStop = false;
+    };
+}
@@ -0,0 +1,215 @@
+#include <Jpch.h>
+#include "Lod.h"
+#include <cmath>
+#include <numeric>
+#include <glm/vec4.hpp>
+
+namespace ProjectJ{
+    namespace{
+        // closer than this the camera is treated as inside the bounds, which always draws level 0.
+        constexpr float MIN_LOD_DISTANCE = 1e-4f;
+        // bias change per frame over budget, and per frame back once under BUDGET_HEADROOM of it.
+        constexpr float BUDGET_RAISE_STEP = 0.25f;
+        constexpr float BUDGET_LOWER_STEP = 0.05f;
+        constexpr double BUDGET_HEADROOM = 0.8;
+    }
+
+    LodSelector::LodSelector(float pixelError, float hysteresis)
+        :mPixelError(std::max(pixelError, 0.0f)), mHysteresis(std::clamp(hysteresis, 0.0f, 0.9f)){
+    }
+
+    void LodSelector::Init(const std::vector<SceneObject>& objects, const MeshPool& pool, std::vector<LodChain> chains){
+        J_PROFILE_FUNCTION();
+        mChains = std::move(chains);
+        mMaxLevelCount = 1;
+        for(const auto& chain : mChains){
+            if(chain.meshes.empty() || chain.meshes.size() != chain.errors.size() || chain.meshes.size() > UINT8_MAX){
+                throw std::runtime_error("malformed LOD chain.");
+            }
+            mMaxLevelCount = std::max(mMaxLevelCount, static_cast<uint32_t>(chain.meshes.size()));
+        }
+        mObjectChains.resize(objects.size());
+        for(size_t i = 0; i < objects.size(); i++){
+            uint32_t meshIndex = objects[i].meshIndex;
+            if(meshIndex >= mChains.size()){
+                throw std::runtime_error("scene object references a mesh without a LOD chain.");
+            }
+            mObjectChains[i] = meshIndex;
+        }
+        mLevels.assign(objects.size(), 0);
+        mCoarseObjects = 0;
+        UpdateBounds(objects, pool);
+    }
+    void LodSelector::UpdateBounds(const std::vector<SceneObject>& objects, const MeshPool& pool){
+        J_PROFILE_FUNCTION();
+        size_t objectCount = objects.size();
+        mCenters.resize(objectCount);
+        mRadii.resize(objectCount);
+        mErrorScales.resize(objectCount);
+        for(size_t i = 0; i < objectCount; i++){
+            PUpdateObjectBounds(objects[i], pool, static_cast<uint32_t>(i));
+        }
+    }
+    void LodSelector::UpdateBounds(const std::vector<SceneObject>& objects, const MeshPool& pool, const std::vector<uint32_t>& moved){
+        J_PROFILE_FUNCTION();
+        for(uint32_t i : moved){
+            PUpdateObjectBounds(objects[i], pool, i);
+        }
+    }
+    void LodSelector::PUpdateObjectBounds(const SceneObject& object, const MeshPool& pool, uint32_t index){
+        const glm::mat4& model = object.model;
+        const MeshRange& range = pool.GetRange(object.meshIndex);
+        glm::vec4 center = model * glm::vec4(range.boundsCenter, 1.0f);
+        // the largest axis scale, errors are never underestimated under non-uniform scaling.
+        float scale = 0.0f;
+        for(int axis = 0; axis < 3; axis++){
+            const glm::vec4& column = model[axis];
+            scale = std::max(scale, column.x * column.x + column.y * column.y + column.z * column.z);
+        }
+        scale = std::sqrt(scale);
+        mCenters[index] = glm::vec3(center.x, center.y, center.z);
+        mRadii[index] = range.boundsRadius * scale;
+        mErrorScales[index] = scale;
+    }
+
+    void LodSelector::Select(const SceneView& sceneView, uint32_t viewportHeight, const std::vector<uint32_t>* visible){
+        J_PROFILE_FUNCTION();
+        // the camera of a rigid view matrix sits at -R^T t.
+        const glm::mat4& view = sceneView.view;
+        glm::vec3 eye;
+        for(int axis = 0; axis < 3; axis++){
+            eye[axis] = -(view[axis][0] * view[3][0] + view[axis][1] * view[3][1] + view[axis][2] * view[3][2]);
+        }
+        // an object space error e at distance d covers e * scale * pixelsPerUnit / d pixels.
+        float pixelsPerUnit = std::abs(sceneView.proj[1][1]) * viewportHeight * 0.5f;
+        float threshold = mPixelError * std::exp2(mBias);
+        float refineThreshold = threshold * (1.0f + mHysteresis);
+        float coarsenThreshold = threshold * (1.0f - mHysteresis);
+        uint64_t coarseObjects = 0;
+        auto selectObject = [&](uint32_t i){
+            const LodChain& chain = mChains[mObjectChains[i]];
+            uint32_t levelCount = static_cast<uint32_t>(chain.meshes.size());
+            glm::vec3 toObject = mCenters[i] - eye;
+            float distance = std::max(std::sqrt(glm::dot(toObject, toObject)) - mRadii[i], MIN_LOD_DISTANCE);
+            float pixelsPerError = mErrorScales[i] * pixelsPerUnit / distance;
+            uint32_t level = mLevels[i];
+            if(chain.errors[level] * pixelsPerError > refineThreshold){
+                while(level > 0 && chain.errors[level] * pixelsPerError > threshold){
+                    level--;
+                }
+            }
+            else{
+                while(level + 1 < levelCount && chain.errors[level + 1] * pixelsPerError <= coarsenThreshold){
+                    level++;
+                }
+            }
+            mLevels[i] = static_cast<uint8_t>(level);
+            coarseObjects += level > 0;
+        };
+        if(visible){
+            for(uint32_t i : *visible){
+                selectObject(i);
+            }
+        }
+        else{
+            for(uint32_t i = 0; i < static_cast<uint32_t>(mLevels.size()); i++){
+                selectObject(i);
+            }
+        }
+        mCoarseObjects = coarseObjects;
+    }
+
+    void LodSelector::SetBias(float bias){
+        mBias = std::clamp(bias, -MAX_LOD_BIAS, MAX_LOD_BIAS);
+    }
+    void LodSelector::UpdateBudget(double frameMs, double budgetMs){
+        if(budgetMs <= 0.0){
+            return;
+        }
+        if(frameMs > budgetMs){
+            mBias = std::min(mBias + BUDGET_RAISE_STEP, MAX_LOD_BIAS);
+        }
+        else if(frameMs < budgetMs * BUDGET_HEADROOM && mBias > 0.0f){
+            mBias = std::max(mBias - BUDGET_LOWER_STEP, 0.0f);
+        }
+    }
+
+    void LodDrawBatches::Init(const std::vector<DrawBatch>& batches, const LodSelector& selector, const MeshPool& pool){
+        J_PROFILE_FUNCTION();
+        mSourceBatches = batches;
+        mLevelCount = selector.GetMaxLevelCount();
+        mObjectCount = 0;
+        for(const DrawBatch& batch : batches){
+            mObjectCount += batch.objectCount;
+        }
+        std::vector<DrawBatch> splits;
+        std::vector<uint32_t> splitSlots;
+        for(uint32_t b = 0; b < static_cast<uint32_t>(batches.size()); b++){
+            const LodChain& chain = selector.GetChain(batches[b].firstObject);
+            for(uint32_t level = 0; level < static_cast<uint32_t>(chain.meshes.size()); level++){
+                DrawBatch split = batches[b];
+                split.meshIndex = chain.meshes[level];
+                splits.push_back(split);
+                splitSlots.push_back(b * mLevelCount + level);
+            }
+        }
+        // coarser levels may have landed in other blocks, they join that block's runs.
+        std::vector<uint32_t> order(splits.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+            uint32_t blockA = pool.GetRange(splits[a].meshIndex).block;
+            uint32_t blockB = pool.GetRange(splits[b].meshIndex).block;
+            return blockA != blockB ? blockA < blockB : splits[a].materialIndex < splits[b].materialIndex;
+        });
+        mBatches.resize(splits.size());
+        mSlots.assign(batches.size() * mLevelCount, UINT32_MAX);
+        for(uint32_t i = 0; i < static_cast<uint32_t>(order.size()); i++){
+            mBatches[i] = splits[order[i]];
+            mSlots[splitSlots[order[i]]] = i;
+        }
+        mFirstInstances.assign(mBatches.size() + 1, 0);
+        mInstances.clear();
+        mInstances.reserve(mObjectCount);
+    }
+
+    void LodDrawBatches::Fill(const LodSelector& selector, FrameArena& arena, const std::vector<uint32_t>* visible){
+        J_PROFILE_FUNCTION();
+        // this frame's drawn objects and their split batch, between the two passes.
+        size_t maxDrawn = visible ? visible->size() : mObjectCount;
+        uint32_t* drawnObjects = arena.Allocate<uint32_t>(maxDrawn);
+        uint32_t* drawnSlots = arena.Allocate<uint32_t>(maxDrawn);
+        uint32_t drawnCount = 0;
+        std::fill(mFirstInstances.begin(), mFirstInstances.end(), 0);
+        size_t nextVisible = 0;
+        for(uint32_t b = 0; b < static_cast<uint32_t>(mSourceBatches.size()); b++){
+            const DrawBatch& batch = mSourceBatches[b];
+            uint32_t batchEnd = batch.firstObject + batch.objectCount;
+            auto addObject = [&](uint32_t object){
+                uint32_t slot = mSlots[b * mLevelCount + selector.GetLevel(object)];
+                drawnObjects[drawnCount] = object;
+                drawnSlots[drawnCount] = slot;
+                drawnCount++;
+                mFirstInstances[slot]++;
+            };
+            if(visible){
+                // visible indices ascend, a batch's survivors are one run of them.
+                for(; nextVisible < visible->size() && (*visible)[nextVisible] < batchEnd; nextVisible++){
+                    addObject((*visible)[nextVisible]);
+                }
+            }
+            else{
+                for(uint32_t i = batch.firstObject; i < batchEnd; i++){
+                    addObject(i);
+                }
+            }
+        }
+        // counts to batch ends, then walking the objects backwards moves each end to the batch's start
+        // and keeps objects in their draw order within a batch.
+        std::partial_sum(mFirstInstances.begin(), mFirstInstances.end() - 1, mFirstInstances.begin());
+        mFirstInstances.back() = drawnCount;
+        mInstances.resize(drawnCount);
+        for(uint32_t i = drawnCount; i-- > 0;){
+            mInstances[--mFirstInstances[drawnSlots[i]]] = drawnObjects[i];
+        }
+    }
+}
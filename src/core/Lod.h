@@ -0,0 +1,82 @@
+#pragma once
+#include "FrameArena.h"
+#include "Scene.h"
+
+namespace ProjectJ{
+    // the most a frame budget may push the LOD bias, 16x the pixel error.
+    constexpr float MAX_LOD_BIAS = 4.0f;
+
+    // Picks a level of every object's LodChain: the coarsest whose error, projected from the object's
+    // nearest point to the camera, stays within pixelError pixels. Leaving the current level takes
+    // hysteresis more than that either way, so objects near a switching distance do not pop back and
+    // forth every frame. The threshold is scaled by 2^bias, which SetBias sets and UpdateBudget steers.
+    class LodSelector{
+    public:
+        LodSelector(float pixelError = 1.0f, float hysteresis = 0.25f);
+        // objects as drawn, model matrices in world space; chains indexed by SceneObject::meshIndex, from AddSceneMeshes.
+        void Init(const std::vector<SceneObject>& objects, const MeshPool& pool, std::vector<LodChain> chains);
+        // recomputes the world space bounds after the objects' model matrices changed; levels are kept.
+        void UpdateBounds(const std::vector<SceneObject>& objects, const MeshPool& pool);
+        // the same for only the moved object indices.
+        void UpdateBounds(const std::vector<SceneObject>& objects, const MeshPool& pool, const std::vector<uint32_t>& moved);
+        // visible, ascending object indices, limits the work to those; the others keep their level.
+        void Select(const SceneView& sceneView, uint32_t viewportHeight, const std::vector<uint32_t>* visible = nullptr);
+        uint32_t GetLevel(uint32_t object) const {return mLevels[object];}
+        // the pool mesh an object is drawn with at its current level.
+        uint32_t GetMesh(uint32_t object) const {return mChains[mObjectChains[object]].meshes[mLevels[object]];}
+        const LodChain& GetChain(uint32_t object) const {return mChains[mObjectChains[object]];}
+        uint32_t GetMaxLevelCount() const {return mMaxLevelCount;}
+        // objects Select left on a coarser level than their full mesh.
+        uint64_t GetCoarseObjectCount() const {return mCoarseObjects;}
+
+        // positive trades detail for triangles, clamped to [-MAX_LOD_BIAS, MAX_LOD_BIAS].
+        void SetBias(float bias);
+        float GetBias() const {return mBias;}
+        // raises the bias while frames take longer than budgetMs and lowers it again, more slowly, once
+        // they fit with room to spare. Never goes below 0, detail is only given up while over budget.
+        void UpdateBudget(double frameMs, double budgetMs);
+    private:
+        void PUpdateObjectBounds(const SceneObject& object, const MeshPool& pool, uint32_t index);
+
+        float mPixelError;
+        float mHysteresis;
+        float mBias = 0.0f;
+        std::vector<LodChain> mChains;
+        uint32_t mMaxLevelCount = 1;
+        // per object, world space bounds and what scales its mesh's object space errors to world space.
+        std::vector<uint32_t> mObjectChains;
+        std::vector<glm::vec3> mCenters;
+        std::vector<float> mRadii;
+        std::vector<float> mErrorScales;
+        std::vector<uint8_t> mLevels;
+        uint64_t mCoarseObjects = 0;
+    };
+
+    // Instanced draw batches split per level: batch b at level l becomes its own batch of that level's
+    // mesh. The splits keep the block then material order of SortObjectsForDrawing, so runs sharing both
+    // stay adjacent and are still one multi-draw; Fill sorts each frame's instances into them.
+    class LodDrawBatches{
+    public:
+        // batches from BuildDrawBatches over the objects the selector was initialized with.
+        void Init(const std::vector<DrawBatch>& batches, const LodSelector& selector, const MeshPool& pool);
+        // the objects drawn this frame, visible as for LodSelector::Select, bucketed by batch and level;
+        // the scratch between the two passes comes from arena.
+        void Fill(const LodSelector& selector, FrameArena& arena, const std::vector<uint32_t>* visible = nullptr);
+        // meshIndex is the level's mesh, objectCount the most instances it can get.
+        const std::vector<DrawBatch>& GetBatches() const {return mBatches;}
+        uint32_t GetFirstInstance(size_t batch) const {return mFirstInstances[batch];}
+        uint32_t GetInstanceCount(size_t batch) const {return mFirstInstances[batch + 1] - mFirstInstances[batch];}
+        // the object behind every instance, batch after batch.
+        const std::vector<uint32_t>& GetInstances() const {return mInstances;}
+    private:
+        std::vector<DrawBatch> mSourceBatches;
+        std::vector<DrawBatch> mBatches;
+        uint32_t mLevelCount = 1;
+        // [source batch * mLevelCount + level], the split batch drawing it.
+        std::vector<uint32_t> mSlots;
+        std::vector<uint32_t> mFirstInstances;
+        std::vector<uint32_t> mInstances;
+        // objects in the source batches, the most Fill can draw.
+        uint32_t mObjectCount = 0;
+    };
+}
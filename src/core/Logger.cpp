@@ -1,16 +1,258 @@
 #include <Jpch.h>
 #include "Logger.h"
+#include <spdlog/sinks/sink.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
-Logger::LoggerPtr Logger::Create(){
-	spdlog::set_pattern("%^[%T] %@ %n: %v%$");
-	return spdlog::stdout_color_mt("JProject");
+namespace{
+	constexpr const char* kLoggerName = "JProject";
+	bool gAsyncRunning = false;
+	bool gToStderr = false;
+	std::atomic<uint64_t> gDroppedMessages{0};
+
+	// Sink in front of the real one: callers copy the formatted message into a bounded lock-free
+	// MPSC ring (Vyukov's bounded queue, one sequence number per slot) and a writer thread
+	// forwards it. Logging never takes a lock or allocates; a full ring drops the message.
+	class RingSink : public spdlog::sinks::sink{
+	public:
+		RingSink(spdlog::sink_ptr target, size_t slotCount)
+			:mTarget(std::move(target)), mReportedDrops(gDroppedMessages.load()){
+			size_t size = 1;
+			while(size < slotCount){
+				size *= 2;
+			}
+			mSlots = std::make_unique<Slot[]>(size);
+			mMask = size - 1;
+			for(size_t i = 0; i < size; i++){
+				mSlots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			mWriter = std::thread([this](){ PWriterLoop(); });
+		}
+		~RingSink() override{
+			mFlushRequested.store(true);
+			mStop.store(true);
+			mWake.notify_one();
+			mWriter.join();
+		}
+
+		void log(const spdlog::details::log_msg& msg) override{
+			size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+			Slot* slot;
+			while(true){
+				slot = &mSlots[pos & mMask];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+				if(diff == 0){
+					if(mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+						break;
+					}
+				}
+				else if(diff < 0){
+					// the writer hasn't freed this slot yet, the ring is full.
+					gDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				else{
+					pos = mEnqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+			slot->time = msg.time;
+			slot->threadId = msg.thread_id;
+			slot->source = msg.source;
+			slot->level = msg.level;
+			size_t size = std::min(msg.payload.size(), Slot::PAYLOAD_SIZE);
+			std::memcpy(slot->payload, msg.payload.data(), size);
+			if(size < msg.payload.size()){
+				std::memcpy(slot->payload + size - 3, "...", 3);
+			}
+			slot->size = static_cast<uint16_t>(size);
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			// without the lock a wake-up can be missed, the writer's timed wait bounds the delay.
+			if(mWriterWaiting.load()){
+				mWake.notify_one();
+			}
+		}
+		// spdlog calls it from flush_on(err) and flush_every on the logging thread, so it only wakes
+		// the writer, which flushes the target once the ring is drained.
+		void flush() override{
+			mFlushRequested.store(true);
+			mWake.notify_one();
+		}
+		// returns once everything logged before the call is written, for InitGlobally and Shutdown only.
+		void WaitDrained(){
+			size_t target = mEnqueuePos.load();
+			mFlushRequested.store(true);
+			mWake.notify_one();
+			std::unique_lock<std::mutex> lock(mMutex);
+			mFlushed.wait(lock, [&](){ return mDequeuePos.load() >= target || mStop.load(); });
+			lock.unlock();
+			std::lock_guard<std::mutex> targetLock(mTargetMutex);
+			mTarget->flush();
+		}
+		// the writer formats with the target's formatter, so swap it under the writer's lock.
+		void set_pattern(const std::string& pattern) override{
+			std::lock_guard<std::mutex> lock(mTargetMutex);
+			mTarget->set_pattern(pattern);
+		}
+		void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override{
+			std::lock_guard<std::mutex> lock(mTargetMutex);
+			mTarget->set_formatter(std::move(formatter));
+		}
+	private:
+		struct Slot{
+			static constexpr size_t PAYLOAD_SIZE = 448;
+			std::atomic<size_t> sequence;
+			spdlog::log_clock::time_point time;
+			size_t threadId;
+			spdlog::source_loc source;
+			spdlog::level::level_enum level;
+			uint16_t size;
+			char payload[PAYLOAD_SIZE];
+		};
+
+		// pops and writes until the ring is empty, false if it already was.
+		bool PDrain(){
+			std::lock_guard<std::mutex> targetLock(mTargetMutex);
+			size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+			bool wrote = false;
+			while(true){
+				Slot& slot = mSlots[pos & mMask];
+				if(slot.sequence.load(std::memory_order_acquire) != pos + 1){
+					break;
+				}
+				spdlog::details::log_msg msg(slot.time, slot.source, kLoggerName, slot.level, spdlog::string_view_t(slot.payload, slot.size));
+				msg.thread_id = slot.threadId;
+				mTarget->log(msg);
+				slot.sequence.store(pos + mMask + 1, std::memory_order_release);
+				pos++;
+				mDequeuePos.store(pos);
+				wrote = true;
+			}
+			uint64_t dropped = gDroppedMessages.load(std::memory_order_relaxed);
+			if(dropped != mReportedDrops){
+				std::string text = fmt::format("log ring full, dropped {} messages", dropped - mReportedDrops);
+				mTarget->log(spdlog::details::log_msg(kLoggerName, spdlog::level::warn, text));
+				mReportedDrops = dropped;
+			}
+			if(mFlushRequested.exchange(false)){
+				mTarget->flush();
+			}
+			if(wrote){
+				std::lock_guard<std::mutex> lock(mMutex);
+				mFlushed.notify_all();
+			}
+			return wrote;
+		}
+		void PWriterLoop(){
+			while(true){
+				if(PDrain()){
+					continue;
+				}
+				if(mStop.load()){
+					PDrain();
+					std::lock_guard<std::mutex> lock(mMutex);
+					mFlushed.notify_all();
+					return;
+				}
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWriterWaiting.store(true);
+				size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+				if(mSlots[pos & mMask].sequence.load(std::memory_order_acquire) != pos + 1 && !mStop.load()){
+					mWake.wait_for(lock, std::chrono::milliseconds(10));
+				}
+				mWriterWaiting.store(false);
+			}
+		}
+
+		spdlog::sink_ptr mTarget;
+		std::unique_ptr<Slot[]> mSlots;
+		size_t mMask;
+		alignas(64) std::atomic<size_t> mEnqueuePos{0};
+		alignas(64) std::atomic<size_t> mDequeuePos{0};
+		uint64_t mReportedDrops = 0;
+		std::atomic<bool> mWriterWaiting{false};
+		std::atomic<bool> mStop{false};
+		std::atomic<bool> mFlushRequested{false};
+		std::mutex mMutex;
+		std::mutex mTargetMutex;
+		std::condition_variable mWake;
+		std::condition_variable mFlushed;
+		std::thread mWriter;
+	};
+
+	// blocks until the logger's ring sinks have written everything queued so far.
+	void HWaitDrained(spdlog::logger& logger){
+		for(auto& sink : logger.sinks()){
+			if(auto* ring = dynamic_cast<RingSink*>(sink.get())){
+				ring->WaitDrained();
+			}
+		}
+	}
+}
+
+Logger::LoggerPtr Logger::Create(const LoggerConfig& config){
+	// a previous InitGlobally or Shutdown left one registered under the same name.
+	spdlog::drop(kLoggerName);
+	spdlog::sink_ptr sink;
+	if(config.toStderr){
+		sink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+	}
+	else{
+		sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+	}
+	if(config.async){
+		sink = std::make_shared<RingSink>(std::move(sink), config.queueSize);
+	}
+	auto logger = std::make_shared<spdlog::logger>(kLoggerName, std::move(sink));
+	spdlog::register_logger(logger);
+	return logger;
+}
+
+uint64_t Logger::GetDroppedMessages(){
+	return gDroppedMessages.load();
 }
 
-Logger::LoggerPtr& Logger::Get(){
-	static auto mLogger = Create();
-	return mLogger;
+Logger::LoggerPtr Logger::Get(){
+	return spdlog::default_logger();
 }
 
-void Logger::InitGlobally(){
-    spdlog::set_pattern("%^[%T] %@ %n: %v%$");
-}
\ No newline at end of file
+void Logger::InitGlobally(const LoggerConfig& config){
+	if(auto previous = Get()){
+		HWaitDrained(*previous);
+		previous->flush();
+	}
+	auto logger = Create(config);
+	// INFO at most, JLOG_REPORT logs at INFO whatever the compile-time floor is.
+	logger->set_level(static_cast<spdlog::level::level_enum>(std::min(SPDLOG_ACTIVE_LEVEL, SPDLOG_LEVEL_INFO)));
+	// with the ring sink this only wakes its writer, the caller never waits on IO.
+	logger->flush_on(spdlog::level::err);
+	spdlog::set_default_logger(logger);
+	spdlog::set_pattern("%^[%T] %@ %n: %v%$");
+	if(config.async && config.flushIntervalSeconds > 0){
+		spdlog::flush_every(std::chrono::seconds(config.flushIntervalSeconds));
+	}
+	gAsyncRunning = config.async;
+	gToStderr = config.toStderr;
+}
+
+void Logger::Shutdown(){
+	if(!gAsyncRunning){
+		if(auto logger = Get()){
+			logger->flush();
+		}
+		return;
+	}
+	// spdlog::shutdown drops every logger, the default one included, and JLOG would dereference null.
+	// Dropping the last reference to the ring sink writes what is left and joins its thread.
+	if(auto logger = Get()){
+		HWaitDrained(*logger);
+	}
+	spdlog::shutdown();
+	gAsyncRunning = false;
+	LoggerConfig config;
+	config.async = false;
+	config.toStderr = gToStderr;
+	InitGlobally(config);
+}
@@ -1,17 +1,46 @@
 #pragma once
+// Compile-time floor: anything below SPDLOG_ACTIVE_LEVEL compiles to nothing, so hot paths keep no
+// TRACE/INFO calls in release builds.
+#ifndef SPDLOG_ACTIVE_LEVEL
+    #ifdef NDEBUG
+        #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_WARN
+    #else
+        #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+    #endif
+#endif
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+struct LoggerConfig{
+    // Async mode: the caller formats the message into a lock-free ring of queueSize slots and a
+    // background thread writes it. When the ring is full the message is dropped and counted
+    // instead of blocking the caller; messages longer than a slot are cut short.
+    bool async = true;
+    size_t queueSize = 8192;
+    uint32_t flushIntervalSeconds = 1;
+    // for tools whose stdout carries their results.
+    bool toStderr = false;
+};
+
 class Logger{
     public:
     using LoggerPtr = std::shared_ptr<spdlog::logger>;
-    static LoggerPtr& Get();
-    static LoggerPtr Create(); 
-    static void InitGlobally();
+    static LoggerPtr Get();
+    static LoggerPtr Create(const LoggerConfig& config = {}); 
+    // calling it again replaces the previous logger.
+    static void InitGlobally(const LoggerConfig& config = {});
+    // flushes and stops the async thread; later JLOG calls go to a synchronous logger, calling it again does nothing.
+    static void Shutdown();
+    // messages async mode dropped because its ring was full, since the process started.
+    static uint64_t GetDroppedMessages();
 };
 
 #define JLOG_ERROR(...)    SPDLOG_ERROR(__VA_ARGS__)
 #define JLOG_WARN(...)     SPDLOG_WARN(__VA_ARGS__)
 #define JLOG_INFO(...)     SPDLOG_INFO(__VA_ARGS__)
+#define JLOG_DEBUG(...)    SPDLOG_DEBUG(__VA_ARGS__)
 #define JLOG_TRACE(...)    SPDLOG_TRACE(__VA_ARGS__)
-#define JLOG_FATAL(...)    SPDLOG_FATAL(__VA_ARGS__)
+#define JLOG_FATAL(...)    SPDLOG_CRITICAL(__VA_ARGS__)
+// Reports the user asked for (statsLogInterval, --readback, ...), INFO but kept whatever the floor.
+// Only call it behind such an opt-in, never unconditionally on a hot path.
+#define JLOG_REPORT(...)   SPDLOG_LOGGER_CALL(spdlog::default_logger_raw(), spdlog::level::info, __VA_ARGS__)
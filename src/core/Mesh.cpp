@@ -0,0 +1,165 @@
+#include <Jpch.h>
+#include "Mesh.h"
+#include <cmath>
+
+namespace ProjectJ{
+    MeshData CreateQuadMesh(){
+        MeshData mesh;
+        mesh.vertices = {
+            {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+            {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+            {{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+            {{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}
+        };
+        mesh.indices = {
+            0,1,2,2,3,0
+        };
+        return mesh;
+    }
+
+    MeshData CreatePolygonMesh(uint32_t sides){
+        sides = std::max(3u, sides);
+        MeshData mesh;
+        mesh.vertices.reserve(sides + 1);
+        mesh.indices.reserve(sides * 3);
+        mesh.vertices.push_back({{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.5f, 0.5f}});
+        for(uint32_t i = 0; i < sides; i++){
+            float angle = 6.2831853f * i / sides;
+            float x = 0.5f * std::cos(angle);
+            float y = 0.5f * std::sin(angle);
+            mesh.vertices.push_back({{x, y, 0.0f}, {1.0f, 1.0f, 1.0f}, {x + 0.5f, y + 0.5f}});
+        }
+        // counter-clockwise, the same winding as the quad.
+        for(uint32_t i = 0; i < sides; i++){
+            mesh.indices.push_back(0);
+            mesh.indices.push_back(1 + i);
+            mesh.indices.push_back(1 + (i + 1) % sides);
+        }
+        return mesh;
+    }
+
+    glm::mat4 ApplyPositionDequantize(const glm::mat4& model, const MeshRange& range){
+        // model * translate(offset) * scale(scale) without the two full matrix products.
+        glm::mat4 result = model;
+        result[3] = model * glm::vec4(range.positionOffset, 1.0f);
+        result[0] *= range.positionScale.x;
+        result[1] *= range.positionScale.y;
+        result[2] *= range.positionScale.z;
+        return result;
+    }
+
+    MeshPool::MeshPool(VertexEncoding encoding, uint32_t maxBlockVertices, uint32_t maxBlockIndices)
+        :mEncoding(encoding), mMaxBlockVertices(maxBlockVertices), mMaxBlockIndices(maxBlockIndices){
+    }
+    uint32_t MeshPool::Add(const MeshData& mesh){
+        MeshIndexType indexType = mesh.vertices.size() <= 65536 ? MeshIndexType::UInt16 : MeshIndexType::UInt32;
+        uint32_t& open = mOpenBlocks[static_cast<uint32_t>(indexType)];
+        if(open == UINT32_MAX
+            || mBlocks[open].vertexCount + mesh.vertices.size() > mMaxBlockVertices
+            || mBlocks[open].indexCount + mesh.indices.size() > mMaxBlockIndices){
+            // an empty block takes any mesh, however big.
+            if(open == UINT32_MAX || mBlocks[open].vertexCount > 0){
+                open = static_cast<uint32_t>(mBlocks.size());
+                mBlocks.emplace_back();
+                mBlocks.back().indexType = indexType;
+                mBlocks.back().vertexEncoding = mEncoding;
+            }
+        }
+        MeshBlock& block = mBlocks[open];
+        MeshRange range{};
+        range.block = open;
+        range.firstIndex = block.indexCount;
+        range.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        range.vertexOffset = static_cast<int32_t>(block.vertexCount);
+        range.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        PComputeBounds(mesh, range);
+        PEncodeVertices(mesh, range, block);
+        block.vertexCount += range.vertexCount;
+        if(indexType == MeshIndexType::UInt16){
+            std::vector<uint16_t> narrow(mesh.indices.begin(), mesh.indices.end());
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(narrow.data());
+            block.indices.insert(block.indices.end(), bytes, bytes + narrow.size() * sizeof(uint16_t));
+        }
+        else{
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(mesh.indices.data());
+            block.indices.insert(block.indices.end(), bytes, bytes + mesh.indices.size() * sizeof(uint32_t));
+        }
+        block.indexCount += range.indexCount;
+        mRanges.push_back(range);
+        return static_cast<uint32_t>(mRanges.size() - 1);
+    }
+
+    void MeshPool::PComputeBounds(const MeshData& mesh, MeshRange& range){
+        range.boundsCenter = glm::vec3(0.0f);
+        range.boundsRadius = 0.0f;
+        if(mesh.vertices.empty()){
+            return;
+        }
+        float minZ = mesh.vertices[0].pos.z;
+        float maxZ = minZ;
+        for(const auto& vertex : mesh.vertices){
+            minZ = std::min(minZ, vertex.pos.z);
+            maxZ = std::max(maxZ, vertex.pos.z);
+        }
+        range.boundsCenter.z = (minZ + maxZ) * 0.5f;
+        float radiusSquared = 0.0f;
+        for(const auto& vertex : mesh.vertices){
+            float dz = vertex.pos.z - range.boundsCenter.z;
+            radiusSquared = std::max(radiusSquared, vertex.pos.x * vertex.pos.x + vertex.pos.y * vertex.pos.y + dz * dz);
+        }
+        range.boundsRadius = std::sqrt(radiusSquared);
+    }
+    void MeshPool::PEncodeVertices(const MeshData& mesh, MeshRange& range, MeshBlock& block){
+        range.positionOffset = glm::vec3(0.0f);
+        range.positionScale = glm::vec3(1.0f);
+        if(mEncoding == VertexEncoding::Float){
+            block.vertices.insert(block.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            return;
+        }
+        // snorm positions span the mesh bounds, center and half extent per axis.
+        if(!mesh.vertices.empty()){
+            glm::vec3 minimum = mesh.vertices[0].pos;
+            glm::vec3 maximum = minimum;
+            for(const auto& vertex : mesh.vertices){
+                for(int axis = 0; axis < 3; axis++){
+                    minimum[axis] = std::min(minimum[axis], vertex.pos[axis]);
+                    maximum[axis] = std::max(maximum[axis], vertex.pos[axis]);
+                }
+            }
+            for(int axis = 0; axis < 3; axis++){
+                range.positionOffset[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+                float halfExtent = (maximum[axis] - minimum[axis]) * 0.5f;
+                range.positionScale[axis] = halfExtent > 0.0f ? halfExtent : 1.0f;
+            }
+        }
+        auto encodePosition = [&range](const glm::vec3& pos){
+            Snorm16x4 encoded{};
+            encoded.x = EncodeSnorm16((pos.x - range.positionOffset.x) / range.positionScale.x);
+            encoded.y = EncodeSnorm16((pos.y - range.positionOffset.y) / range.positionScale.y);
+            encoded.z = EncodeSnorm16((pos.z - range.positionOffset.z) / range.positionScale.z);
+            encoded.w = INT16_MAX;
+            return encoded;
+        };
+        auto encodeColor = [](const glm::vec3& color){
+            return Unorm8x4{EncodeUnorm8(color.r), EncodeUnorm8(color.g), EncodeUnorm8(color.b), 255};
+        };
+        auto encodeTexCoord = [](const glm::vec2& texCoord){
+            return Half2{EncodeHalf(texCoord.x), EncodeHalf(texCoord.y)};
+        };
+        auto append = [](std::vector<uint8_t>& stream, const auto& value){
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+            stream.insert(stream.end(), bytes, bytes + sizeof(value));
+        };
+        if(mEncoding == VertexEncoding::Packed){
+            for(const auto& vertex : mesh.vertices){
+                append(block.vertexStreams[0], PackedVertex{encodePosition(vertex.pos), encodeColor(vertex.color), encodeTexCoord(vertex.texCoord)});
+            }
+        }
+        else{
+            for(const auto& vertex : mesh.vertices){
+                append(block.vertexStreams[0], PackedPosition{encodePosition(vertex.pos)});
+                append(block.vertexStreams[1], PackedAttributes{encodeColor(vertex.color), encodeTexCoord(vertex.texCoord)});
+            }
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include "VertexFormat.h"
+
+namespace ProjectJ{
+    // Import format, what meshes are processed in and what VertexEncoding::Float uploads.
+    struct Vertex{
+        glm::vec3 pos;
+        glm::vec3 color;
+        glm::vec2 texCoord;
+        static constexpr auto Attributes(){
+            return std::make_tuple(
+                MakeVertexAttribute(&Vertex::pos, VERTEX_POSITION_LOCATION),
+                MakeVertexAttribute(&Vertex::color, 1),
+                MakeVertexAttribute(&Vertex::texCoord, 2));
+        }
+    };
+    // Imported geometry always carries 32-bit indices, MeshPool narrows them where they fit.
+    struct MeshData{
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+    // The textured quad every scene object is drawn with.
+    MeshData CreateQuadMesh();
+    // Regular polygon in the xy plane with a unit diameter, triangle fan around the center.
+    MeshData CreatePolygonMesh(uint32_t sides);
+    struct MeshOptimizeStats;
+    // Wavefront OBJ (.obj) or glTF 2.0 (.gltf with embedded or external buffers, .glb), picked by
+    // extension. Every triangle primitive is merged into one mesh; node transforms are not applied.
+    // Runs OptimizeMesh on the result when optimize is set, and hands its stats to optimizeStats when
+    // that is not null. Throws on malformed files.
+    MeshData LoadMesh(const std::string& path, bool optimize = true, MeshOptimizeStats* optimizeStats = nullptr);
+
+    //---- Optimization ----//
+    // Average cache miss ratio, post-transform cache misses per triangle of a FIFO cache: 3 is no
+    // reuse at all, ~0.5-0.7 is what a good order reaches on a regular grid.
+    float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+    struct MeshOptimizeStats{
+        float acmrBefore = 0.0f;
+        float acmrAfter = 0.0f;
+        // vertices dropped because no triangle referenced them.
+        uint32_t unusedVertices = 0;
+        // runs of triangles the overdraw pass reordered as a whole.
+        uint32_t clusters = 0;
+    };
+    // Reorders triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm), then
+    // reorders the runs that start with a cold cache so outward facing ones draw first, which cuts
+    // overdraw without giving back cache hits, then renumbers vertices in first-use order so vertex
+    // fetch walks memory linearly. The rendered result is unchanged.
+    MeshOptimizeStats OptimizeMesh(MeshData& mesh);
+    // Quadric error edge collapse (Garland-Heckbert) down to at most targetIndexCount indices, or
+    // until no collapse is left that keeps the surface manifold and unflipped. Vertices are only
+    // removed, never moved, so the survivors keep their attributes; UV/color seams stay locked and
+    // open borders only shorten along themselves. error receives the largest area weighted RMS
+    // distance, in object space, a collapse moved the surface by.
+    MeshData SimplifyMesh(const MeshData& mesh, size_t targetIndexCount, float* error = nullptr);
+    // One coarser level of a mesh and its SimplifyMesh error against the full mesh.
+    struct MeshLod{
+        MeshData data;
+        float error = 0.0f;
+    };
+    // Up to maxLevels coarser levels, each with about half the triangles of the one before, optimized
+    // with OptimizeMesh. Stops early once simplification no longer makes real progress.
+    std::vector<MeshLod> GenerateMeshLods(const MeshData& mesh, uint32_t maxLevels = 3);
+
+    enum class MeshIndexType{
+        UInt16,
+        UInt32
+    };
+    // Vertices and indices of the meshes packed into one set of buffers. With VertexEncoding::Float
+    // the vertices live in vertices, otherwise vertexStreams holds the encoded PackedVertex, or
+    // PackedPosition and PackedAttributes streams. indices holds indexCount elements of indexType.
+    struct MeshBlock{
+        MeshIndexType indexType = MeshIndexType::UInt16;
+        VertexEncoding vertexEncoding = VertexEncoding::Float;
+        uint32_t vertexCount = 0;
+        std::vector<Vertex> vertices;
+        std::vector<uint8_t> vertexStreams[2];
+        std::vector<uint8_t> indices;
+        uint32_t indexCount = 0;
+
+        uint32_t GetVertexStreamCount() const{
+            return vertexEncoding == VertexEncoding::PackedSplit ? 2 : 1;
+        }
+        uint32_t GetIndex(size_t i) const{
+            return indexType == MeshIndexType::UInt16 ? reinterpret_cast<const uint16_t*>(indices.data())[i]
+                : reinterpret_cast<const uint32_t*>(indices.data())[i];
+        }
+    };
+
+    // Where one mesh lives inside a MeshPool block, what vkCmdDrawIndexed takes.
+    struct MeshRange{
+        uint32_t block;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t vertexOffset;
+        uint32_t vertexCount;
+        // object space position = positionOffset + positionScale * stored position. Identity unless
+        // the encoding quantizes positions to the mesh bounds.
+        glm::vec3 positionOffset;
+        glm::vec3 positionScale;
+        // object space sphere on the z axis holding the mesh at any SceneView::spin angle.
+        glm::vec3 boundsCenter;
+        float boundsRadius;
+    };
+    // model * the range's dequantization, what the vertex shader's model matrix has to be.
+    glm::mat4 ApplyPositionDequantize(const glm::mat4& model, const MeshRange& range);
+    // Packs meshes back to back into a few large vertex/index arrays, one buffer pair per block, so
+    // drawing thousands of meshes only rebinds buffers when the block changes. Indices stay local to
+    // their mesh and are rebased through vertexOffset, so every mesh of up to 65536 vertices goes into
+    // a 16-bit block and only bigger ones pay for 32-bit indices. Vertices are encoded as they are added.
+    class MeshPool{
+    public:
+        MeshPool(VertexEncoding encoding = VertexEncoding::Float, uint32_t maxBlockVertices = 1u << 20, uint32_t maxBlockIndices = 1u << 22);
+        // returns the mesh index; a mesh bigger than a block gets a block of its own.
+        uint32_t Add(const MeshData& mesh);
+        const MeshRange& GetRange(uint32_t mesh) const {return mRanges[mesh];}
+        uint32_t GetMeshCount() const {return static_cast<uint32_t>(mRanges.size());}
+        const std::vector<MeshBlock>& GetBlocks() const {return mBlocks;}
+        VertexEncoding GetVertexEncoding() const {return mEncoding;}
+    private:
+        void PComputeBounds(const MeshData& mesh, MeshRange& range);
+        void PEncodeVertices(const MeshData& mesh, MeshRange& range, MeshBlock& block);
+    private:
+        VertexEncoding mEncoding;
+        uint32_t mMaxBlockVertices;
+        uint32_t mMaxBlockIndices;
+        std::vector<MeshBlock> mBlocks;
+        // block still being filled per index type, UINT32_MAX when there is none.
+        uint32_t mOpenBlocks[2] = {UINT32_MAX, UINT32_MAX};
+        std::vector<MeshRange> mRanges;
+    };
+}
@@ -0,0 +1,623 @@
+#include <Jpch.h>
+#include "Mesh.h"
+#include <cstring>
+
+namespace ProjectJ{
+    namespace{
+        std::vector<uint8_t> HReadFile(const std::filesystem::path& path){
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if(!file){
+                throw std::runtime_error("failed to open " + path.string());
+            }
+            std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+            return bytes;
+        }
+
+        //---- OBJ ----//
+        MeshData HLoadOBJ(const std::string& path){
+            std::vector<uint8_t> bytes = HReadFile(path);
+            bytes.push_back('\0');
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> colors;
+            std::vector<glm::vec2> texCoords;
+            // (position, texcoord) pair to vertex, normals are not used by the pipeline.
+            std::unordered_map<uint64_t, uint32_t> vertexMap;
+            MeshData mesh;
+            std::vector<uint32_t> face;
+
+            auto resolve = [](long index, size_t count) -> long{
+                // 1-based, negative counts back from the latest element.
+                return index < 0 ? static_cast<long>(count) + index : index - 1;
+            };
+            const char* p = reinterpret_cast<const char*>(bytes.data());
+            while(*p){
+                while(*p == ' ' || *p == '\t'){
+                    p++;
+                }
+                if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')){
+                    char* end;
+                    glm::vec3 position, color(1.0f);
+                    position.x = std::strtof(p + 2, &end);
+                    position.y = std::strtof(end, &end);
+                    position.z = std::strtof(end, &end);
+                    // optional vertex colors, a common extension.
+                    const char* colorStart = end;
+                    color.r = std::strtof(colorStart, &end);
+                    if(end != colorStart){
+                        color.g = std::strtof(end, &end);
+                        color.b = std::strtof(end, &end);
+                    }
+                    else{
+                        color.r = 1.0f;
+                    }
+                    positions.push_back(position);
+                    colors.push_back(color);
+                    p = end;
+                }
+                else if(p[0] == 'v' && p[1] == 't'){
+                    char* end;
+                    glm::vec2 texCoord;
+                    texCoord.x = std::strtof(p + 2, &end);
+                    // OBJ puts v = 0 at the bottom, Vulkan samples from the top.
+                    texCoord.y = 1.0f - std::strtof(end, &end);
+                    texCoords.push_back(texCoord);
+                    p = end;
+                }
+                else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')){
+                    p++;
+                    face.clear();
+                    while(true){
+                        while(*p == ' ' || *p == '\t'){
+                            p++;
+                        }
+                        if(*p == '\0' || *p == '\n' || *p == '\r'){
+                            break;
+                        }
+                        char* end;
+                        long positionIndex = resolve(std::strtol(p, &end, 10), positions.size());
+                        if(end == p || positionIndex < 0 || positionIndex >= static_cast<long>(positions.size())){
+                            throw std::runtime_error("bad face in " + path);
+                        }
+                        long texCoordIndex = -1;
+                        p = end;
+                        if(*p == '/'){
+                            p++;
+                            if(*p != '/'){
+                                texCoordIndex = resolve(std::strtol(p, &end, 10), texCoords.size());
+                                if(end == p || texCoordIndex < 0 || texCoordIndex >= static_cast<long>(texCoords.size())){
+                                    throw std::runtime_error("bad face in " + path);
+                                }
+                                p = end;
+                            }
+                            if(*p == '/'){
+                                std::strtol(p + 1, &end, 10);
+                                p = end;
+                            }
+                        }
+                        uint64_t key = (static_cast<uint64_t>(positionIndex) << 32) | static_cast<uint32_t>(texCoordIndex);
+                        auto [it, inserted] = vertexMap.try_emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+                        if(inserted){
+                            Vertex vertex{};
+                            vertex.pos = positions[positionIndex];
+                            vertex.color = colors[positionIndex];
+                            vertex.texCoord = texCoordIndex >= 0 ? texCoords[texCoordIndex] : glm::vec2(0.0f);
+                            mesh.vertices.push_back(vertex);
+                        }
+                        face.push_back(it->second);
+                    }
+                    // polygons become triangle fans.
+                    for(size_t i = 2; i < face.size(); i++){
+                        mesh.indices.push_back(face[0]);
+                        mesh.indices.push_back(face[i - 1]);
+                        mesh.indices.push_back(face[i]);
+                    }
+                }
+                while(*p && *p != '\n'){
+                    p++;
+                }
+                if(*p){
+                    p++;
+                }
+            }
+            return mesh;
+        }
+
+        //---- JSON ----//
+        // just enough JSON for glTF, numbers are doubles.
+        struct JsonValue{
+            enum class Type{ Null, Bool, Number, String, Array, Object };
+            Type type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string string;
+            std::vector<JsonValue> array;
+            std::vector<std::pair<std::string, JsonValue> > object;
+
+            const JsonValue* Find(const char* key) const{
+                for(const auto& [name, value] : object){
+                    if(name == key){
+                        return &value;
+                    }
+                }
+                return nullptr;
+            }
+            double NumberOr(const char* key, double fallback) const{
+                const JsonValue* value = Find(key);
+                return value && value->type == Type::Number ? value->number : fallback;
+            }
+        };
+
+        class JsonParser{
+        public:
+            // glTF itself nests a handful of levels.
+            static constexpr uint32_t MAX_DEPTH = 64;
+            JsonParser(const char* begin, const char* end)
+                :mCurrent(begin), mEnd(end){
+            }
+            JsonValue Parse(){
+                JsonValue value = PParseValue();
+                PSkipSpace();
+                if(mCurrent != mEnd){
+                    PFail();
+                }
+                return value;
+            }
+        private:
+            [[noreturn]] void PFail(){
+                throw std::runtime_error("malformed JSON");
+            }
+            void PSkipSpace(){
+                while(mCurrent != mEnd && (*mCurrent == ' ' || *mCurrent == '\t' || *mCurrent == '\n' || *mCurrent == '\r')){
+                    mCurrent++;
+                }
+            }
+            void PExpect(char c){
+                PSkipSpace();
+                if(mCurrent == mEnd || *mCurrent != c){
+                    PFail();
+                }
+                mCurrent++;
+            }
+            bool PConsume(const char* literal){
+                size_t length = std::strlen(literal);
+                if(static_cast<size_t>(mEnd - mCurrent) >= length && std::memcmp(mCurrent, literal, length) == 0){
+                    mCurrent += length;
+                    return true;
+                }
+                return false;
+            }
+            // depth counts the arrays and objects around the value, deeper ones throw instead of running out of stack.
+            JsonValue PParseValue(uint32_t depth = 0){
+                if(depth > MAX_DEPTH){
+                    throw std::runtime_error("malformed JSON, nested too deeply");
+                }
+                PSkipSpace();
+                if(mCurrent == mEnd){
+                    PFail();
+                }
+                JsonValue value;
+                char c = *mCurrent;
+                if(c == '{'){
+                    value.type = JsonValue::Type::Object;
+                    mCurrent++;
+                    PSkipSpace();
+                    if(mCurrent != mEnd && *mCurrent == '}'){
+                        mCurrent++;
+                        return value;
+                    }
+                    do{
+                        PSkipSpace();
+                        std::string key = PParseString();
+                        PExpect(':');
+                        value.object.emplace_back(std::move(key), PParseValue(depth + 1));
+                        PSkipSpace();
+                    }while(mCurrent != mEnd && *mCurrent == ',' && ++mCurrent);
+                    PExpect('}');
+                }
+                else if(c == '['){
+                    value.type = JsonValue::Type::Array;
+                    mCurrent++;
+                    PSkipSpace();
+                    if(mCurrent != mEnd && *mCurrent == ']'){
+                        mCurrent++;
+                        return value;
+                    }
+                    do{
+                        value.array.push_back(PParseValue(depth + 1));
+                        PSkipSpace();
+                    }while(mCurrent != mEnd && *mCurrent == ',' && ++mCurrent);
+                    PExpect(']');
+                }
+                else if(c == '"'){
+                    value.type = JsonValue::Type::String;
+                    value.string = PParseString();
+                }
+                else if(PConsume("true") || PConsume("false")){
+                    value.type = JsonValue::Type::Bool;
+                    value.boolean = c == 't';
+                }
+                else if(PConsume("null")){
+                }
+                else{
+                    // strtod stops at the first character that is not part of the number.
+                    std::string number;
+                    while(mCurrent != mEnd && std::strchr("+-.0123456789eE", *mCurrent)){
+                        number.push_back(*mCurrent++);
+                    }
+                    if(number.empty()){
+                        PFail();
+                    }
+                    value.type = JsonValue::Type::Number;
+                    value.number = std::strtod(number.c_str(), nullptr);
+                }
+                return value;
+            }
+            std::string PParseString(){
+                if(mCurrent == mEnd || *mCurrent != '"'){
+                    PFail();
+                }
+                mCurrent++;
+                std::string result;
+                while(mCurrent != mEnd && *mCurrent != '"'){
+                    char c = *mCurrent++;
+                    if(c != '\\'){
+                        result.push_back(c);
+                        continue;
+                    }
+                    if(mCurrent == mEnd){
+                        PFail();
+                    }
+                    char escape = *mCurrent++;
+                    switch(escape){
+                        case 'b': result.push_back('\b'); break;
+                        case 'f': result.push_back('\f'); break;
+                        case 'n': result.push_back('\n'); break;
+                        case 'r': result.push_back('\r'); break;
+                        case 't': result.push_back('\t'); break;
+                        case 'u':{
+                            if(mEnd - mCurrent < 4){
+                                PFail();
+                            }
+                            uint32_t code = static_cast<uint32_t>(std::stoul(std::string(mCurrent, 4), nullptr, 16));
+                            mCurrent += 4;
+                            // surrogate pairs are kept as two code points, glTF names and URIs rarely need them.
+                            if(code < 0x80){
+                                result.push_back(static_cast<char>(code));
+                            }
+                            else if(code < 0x800){
+                                result.push_back(static_cast<char>(0xc0 | (code >> 6)));
+                                result.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                            }
+                            else{
+                                result.push_back(static_cast<char>(0xe0 | (code >> 12)));
+                                result.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                                result.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                            }
+                            break;
+                        }
+                        default: result.push_back(escape); break;
+                    }
+                }
+                if(mCurrent == mEnd){
+                    PFail();
+                }
+                mCurrent++;
+                return result;
+            }
+        private:
+            const char* mCurrent;
+            const char* mEnd;
+        };
+
+        //---- glTF ----//
+        std::vector<uint8_t> HDecodeBase64(const std::string& text, size_t begin){
+            auto decode = [](char c) -> int{
+                if(c >= 'A' && c <= 'Z') return c - 'A';
+                if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+                if(c >= '0' && c <= '9') return c - '0' + 52;
+                if(c == '+' || c == '-') return 62;
+                if(c == '/' || c == '_') return 63;
+                return -1;
+            };
+            std::vector<uint8_t> bytes;
+            bytes.reserve((text.size() - begin) * 3 / 4);
+            uint32_t bits = 0;
+            int bitCount = 0;
+            for(size_t i = begin; i < text.size(); i++){
+                int value = decode(text[i]);
+                if(value < 0){
+                    continue;
+                }
+                bits = (bits << 6) | static_cast<uint32_t>(value);
+                bitCount += 6;
+                if(bitCount >= 8){
+                    bitCount -= 8;
+                    bytes.push_back(static_cast<uint8_t>(bits >> bitCount));
+                }
+            }
+            return bytes;
+        }
+
+        class GLTFReader{
+        public:
+            GLTFReader(const std::string& path)
+                :mPath(path){
+                std::vector<uint8_t> bytes = HReadFile(path);
+                const char* json = reinterpret_cast<const char*>(bytes.data());
+                size_t jsonLength = bytes.size();
+                std::vector<uint8_t> binaryChunk;
+                // .glb: 12 byte header, a JSON chunk, then an optional BIN chunk.
+                if(bytes.size() >= 12 && std::memcmp(bytes.data(), "glTF", 4) == 0){
+                    size_t offset = 12;
+                    json = nullptr;
+                    while(offset + 8 <= bytes.size()){
+                        uint32_t chunkLength, chunkType;
+                        std::memcpy(&chunkLength, &bytes[offset], 4);
+                        std::memcpy(&chunkType, &bytes[offset + 4], 4);
+                        offset += 8;
+                        if(offset + chunkLength > bytes.size()){
+                            throw std::runtime_error("truncated chunk in " + path);
+                        }
+                        if(chunkType == 0x4e4f534a && json == nullptr){
+                            json = reinterpret_cast<const char*>(&bytes[offset]);
+                            jsonLength = chunkLength;
+                        }
+                        else if(chunkType == 0x004e4942 && binaryChunk.empty()){
+                            binaryChunk.assign(bytes.begin() + offset, bytes.begin() + offset + chunkLength);
+                        }
+                        offset += (chunkLength + 3) & ~3u;
+                    }
+                    if(json == nullptr){
+                        throw std::runtime_error("no JSON chunk in " + path);
+                    }
+                }
+                try{
+                    mRoot = JsonParser(json, json + jsonLength).Parse();
+                }
+                catch(const std::runtime_error& e){
+                    throw std::runtime_error(std::string(e.what()) + " in " + path);
+                }
+                PLoadBuffers(std::move(binaryChunk));
+            }
+
+            MeshData Read(){
+                MeshData mesh;
+                const JsonValue* meshes = mRoot.Find("meshes");
+                if(meshes == nullptr || meshes->array.empty()){
+                    throw std::runtime_error("no meshes in " + mPath);
+                }
+                for(const auto& gltfMesh : meshes->array){
+                    const JsonValue* primitives = gltfMesh.Find("primitives");
+                    if(primitives == nullptr){
+                        continue;
+                    }
+                    for(const auto& primitive : primitives->array){
+                        if(primitive.NumberOr("mode", 4) != 4){
+                            JLOG_WARN("skipping a non triangle list primitive in {}", mPath);
+                            continue;
+                        }
+                        PReadPrimitive(primitive, mesh);
+                    }
+                }
+                return mesh;
+            }
+        private:
+            void PLoadBuffers(std::vector<uint8_t> binaryChunk){
+                const JsonValue* buffers = mRoot.Find("buffers");
+                if(buffers == nullptr){
+                    return;
+                }
+                for(const auto& buffer : buffers->array){
+                    const JsonValue* uri = buffer.Find("uri");
+                    if(uri == nullptr){
+                        mBuffers.push_back(std::move(binaryChunk));
+                    }
+                    else if(uri->string.compare(0, 5, "data:") == 0){
+                        size_t comma = uri->string.find(',');
+                        if(comma == std::string::npos || uri->string.find(";base64") == std::string::npos){
+                            throw std::runtime_error("unsupported data URI in " + mPath);
+                        }
+                        mBuffers.push_back(HDecodeBase64(uri->string, comma + 1));
+                    }
+                    else{
+                        mBuffers.push_back(HReadFile(std::filesystem::path(mPath).parent_path() / uri->string));
+                    }
+                }
+            }
+
+            const JsonValue& PGet(const char* array, double index){
+                const JsonValue* values = mRoot.Find(array);
+                if(values == nullptr || index < 0 || index >= values->array.size()){
+                    throw std::runtime_error(std::string("bad ") + array + " index in " + mPath);
+                }
+                return values->array[static_cast<size_t>(index)];
+            }
+
+            // where an accessor's elements are, bounds checked. data is null for accessors without a buffer view.
+            struct AccessorView{
+                const uint8_t* data = nullptr;
+                size_t count = 0;
+                size_t stride = 0;
+                uint32_t components = 0;
+                uint32_t componentType = 0;
+                uint32_t componentSize = 0;
+                bool normalize = false;
+            };
+            AccessorView PViewAccessor(double index){
+                const JsonValue& accessor = PGet("accessors", index);
+                if(accessor.Find("sparse")){
+                    throw std::runtime_error("sparse accessors are not supported, " + mPath);
+                }
+                AccessorView result;
+                const JsonValue* type = accessor.Find("type");
+                std::string typeName = type ? type->string : "";
+                result.components = typeName == "SCALAR" ? 1 : typeName == "VEC2" ? 2 : typeName == "VEC3" ? 3 : typeName == "VEC4" ? 4 : 0;
+                if(result.components == 0){
+                    throw std::runtime_error("unsupported accessor type " + typeName + " in " + mPath);
+                }
+                result.componentType = static_cast<uint32_t>(accessor.NumberOr("componentType", 0));
+                result.componentSize = result.componentType == 5126 || result.componentType == 5125 ? 4
+                    : result.componentType == 5122 || result.componentType == 5123 ? 2
+                    : result.componentType == 5120 || result.componentType == 5121 ? 1 : 0;
+                if(result.componentSize == 0){
+                    throw std::runtime_error("unsupported component type in " + mPath);
+                }
+                const JsonValue* normalized = accessor.Find("normalized");
+                result.normalize = normalized && normalized->boolean;
+                result.count = static_cast<size_t>(accessor.NumberOr("count", 0));
+                const JsonValue* viewIndex = accessor.Find("bufferView");
+                if(viewIndex == nullptr){
+                    return result;
+                }
+                const JsonValue& view = PGet("bufferViews", viewIndex->number);
+                size_t bufferIndex = static_cast<size_t>(view.NumberOr("buffer", 0));
+                if(bufferIndex >= mBuffers.size()){
+                    throw std::runtime_error("bad buffer index in " + mPath);
+                }
+                const std::vector<uint8_t>& buffer = mBuffers[bufferIndex];
+                size_t offset = static_cast<size_t>(view.NumberOr("byteOffset", 0) + accessor.NumberOr("byteOffset", 0));
+                size_t elementSize = result.componentSize * result.components;
+                size_t stride = static_cast<size_t>(view.NumberOr("byteStride", 0));
+                result.stride = stride ? stride : elementSize;
+                if(result.count > 0 && offset + (result.count - 1) * result.stride + elementSize > buffer.size()){
+                    throw std::runtime_error("accessor out of bounds in " + mPath);
+                }
+                result.data = buffer.data() + offset;
+                return result;
+            }
+
+            // accessor as floats, components per element; normalized integers map to [0,1] / [-1,1].
+            std::vector<float> PReadAccessor(double index, uint32_t& components){
+                AccessorView accessor = PViewAccessor(index);
+                components = accessor.components;
+                // no data means all zeros.
+                std::vector<float> values(accessor.count * components, 0.0f);
+                if(accessor.data == nullptr){
+                    return values;
+                }
+                bool normalize = accessor.normalize;
+                for(size_t i = 0; i < accessor.count; i++){
+                    const uint8_t* element = accessor.data + i * accessor.stride;
+                    for(uint32_t c = 0; c < components; c++){
+                        const uint8_t* source = element + c * accessor.componentSize;
+                        float value = 0.0f;
+                        switch(accessor.componentType){
+                            case 5126:{ std::memcpy(&value, source, 4); break; }
+                            case 5125:{ uint32_t v; std::memcpy(&v, source, 4); value = static_cast<float>(v); break; }
+                            case 5123:{ uint16_t v; std::memcpy(&v, source, 2); value = normalize ? v / 65535.0f : v; break; }
+                            case 5122:{ int16_t v; std::memcpy(&v, source, 2); value = normalize ? std::max(v / 32767.0f, -1.0f) : v; break; }
+                            case 5121:{ value = normalize ? *source / 255.0f : *source; break; }
+                            case 5120:{ int8_t v = static_cast<int8_t>(*source); value = normalize ? std::max(v / 127.0f, -1.0f) : v; break; }
+                        }
+                        values[i * components + c] = value;
+                    }
+                }
+                return values;
+            }
+
+            // index accessors stay integers, floats would round indices past 2^24.
+            std::vector<uint32_t> PReadIndices(double index){
+                AccessorView accessor = PViewAccessor(index);
+                if(accessor.components != 1 || (accessor.componentType != 5121 && accessor.componentType != 5123 && accessor.componentType != 5125)){
+                    throw std::runtime_error("indices must be unsigned integer scalars in " + mPath);
+                }
+                std::vector<uint32_t> indices(accessor.count, 0);
+                if(accessor.data == nullptr){
+                    return indices;
+                }
+                for(size_t i = 0; i < accessor.count; i++){
+                    const uint8_t* source = accessor.data + i * accessor.stride;
+                    switch(accessor.componentType){
+                        case 5125:{ std::memcpy(&indices[i], source, 4); break; }
+                        case 5123:{ uint16_t v; std::memcpy(&v, source, 2); indices[i] = v; break; }
+                        case 5121:{ indices[i] = *source; break; }
+                    }
+                }
+                return indices;
+            }
+
+            void PReadPrimitive(const JsonValue& primitive, MeshData& mesh){
+                const JsonValue* attributes = primitive.Find("attributes");
+                const JsonValue* position = attributes ? attributes->Find("POSITION") : nullptr;
+                if(position == nullptr){
+                    throw std::runtime_error("primitive without POSITION in " + mPath);
+                }
+                uint32_t positionComponents, texCoordComponents = 0, colorComponents = 0;
+                std::vector<float> positions = PReadAccessor(position->number, positionComponents);
+                // glTF positions are VEC3, anything narrower would be read past its end.
+                if(positionComponents != 3){
+                    throw std::runtime_error("POSITION must be VEC3 in " + mPath);
+                }
+                std::vector<float> texCoords, colors;
+                if(const JsonValue* texCoord = attributes->Find("TEXCOORD_0")){
+                    texCoords = PReadAccessor(texCoord->number, texCoordComponents);
+                }
+                if(const JsonValue* color = attributes->Find("COLOR_0")){
+                    colors = PReadAccessor(color->number, colorComponents);
+                }
+                size_t vertexCount = positions.size() / 3;
+                size_t base = mesh.vertices.size();
+                for(size_t i = 0; i < vertexCount; i++){
+                    Vertex vertex{};
+                    vertex.pos = glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+                    vertex.color = glm::vec3(1.0f);
+                    if(colorComponents >= 3 && i * colorComponents + 2 < colors.size()){
+                        vertex.color = glm::vec3(colors[i * colorComponents], colors[i * colorComponents + 1], colors[i * colorComponents + 2]);
+                    }
+                    if(texCoordComponents >= 2 && i * texCoordComponents + 1 < texCoords.size()){
+                        vertex.texCoord = glm::vec2(texCoords[i * texCoordComponents], texCoords[i * texCoordComponents + 1]);
+                    }
+                    mesh.vertices.push_back(vertex);
+                }
+                if(const JsonValue* indices = primitive.Find("indices")){
+                    for(uint32_t index : PReadIndices(indices->number)){
+                        if(index >= vertexCount){
+                            throw std::runtime_error("index out of range in " + mPath);
+                        }
+                        mesh.indices.push_back(static_cast<uint32_t>(base + index));
+                    }
+                }
+                else{
+                    for(size_t i = 0; i < vertexCount; i++){
+                        mesh.indices.push_back(static_cast<uint32_t>(base + i));
+                    }
+                }
+            }
+        private:
+            std::string mPath;
+            JsonValue mRoot;
+            std::vector<std::vector<uint8_t> > mBuffers;
+        };
+    }
+
+    MeshData LoadMesh(const std::string& path, bool optimize, MeshOptimizeStats* optimizeStats){
+        J_PROFILE_FUNCTION();
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        MeshData mesh;
+        if(extension == ".obj"){
+            mesh = HLoadOBJ(path);
+        }
+        else if(extension == ".gltf" || extension == ".glb"){
+            mesh = GLTFReader(path).Read();
+        }
+        else{
+            throw std::runtime_error("unsupported mesh format " + path);
+        }
+        if(mesh.indices.empty()){
+            throw std::runtime_error("no triangles in " + path);
+        }
+        JLOG_INFO("loaded {}: {} vertices, {} triangles", path, mesh.vertices.size(), mesh.indices.size() / 3);
+        if(optimize){
+            MeshOptimizeStats stats = OptimizeMesh(mesh);
+            if(optimizeStats){
+                *optimizeStats = stats;
+            }
+            JLOG_INFO("optimized {}: ACMR {:.3f} -> {:.3f}, {} overdraw clusters, {} unused vertices removed",
+                path, stats.acmrBefore, stats.acmrAfter, stats.clusters, stats.unusedVertices);
+        }
+        return mesh;
+    }
+}
@@ -0,0 +1,568 @@
+#include <Jpch.h>
+#include "Mesh.h"
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <glm/geometric.hpp>
+
+namespace ProjectJ{
+    namespace{
+        //---- Vertex cache ----//
+        // Forsyth, "Linear-Speed Vertex Cache Optimisation": an LRU cache model scores vertices by how
+        // recently they were used and how few unemitted triangles still need them, the next triangle
+        // is the best scoring one touching the cache.
+        constexpr uint32_t CACHE_SIZE = 32;
+        constexpr uint32_t MAX_VALENCE_TABLE = 32;
+
+        struct ScoreTables{
+            float cache[CACHE_SIZE];
+            float valence[MAX_VALENCE_TABLE];
+            ScoreTables(){
+                for(uint32_t i = 0; i < CACHE_SIZE; i++){
+                    // the last triangle's vertices get a fixed score so it is not simply repeated.
+                    cache[i] = i < 3 ? 0.75f : std::pow(1.0f - (i - 3) / float(CACHE_SIZE - 3), 1.5f);
+                }
+                valence[0] = 0.0f;
+                for(uint32_t i = 1; i < MAX_VALENCE_TABLE; i++){
+                    valence[i] = 2.0f / std::sqrt(float(i));
+                }
+            }
+        };
+        float HVertexScore(const ScoreTables& tables, int32_t cachePosition, uint32_t remaining){
+            if(remaining == 0){
+                return -1.0f;
+            }
+            float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+            return score + (remaining < MAX_VALENCE_TABLE ? tables.valence[remaining] : 2.0f / std::sqrt(float(remaining)));
+        }
+
+        std::vector<uint32_t> HOptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount){
+            static const ScoreTables tables;
+            size_t triangleCount = indices.size() / 3;
+            // triangles per vertex, compressed rows.
+            std::vector<uint32_t> remaining(vertexCount, 0);
+            for(uint32_t index : indices){
+                remaining[index]++;
+            }
+            std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+            for(size_t v = 0; v < vertexCount; v++){
+                adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+            }
+            std::vector<uint32_t> adjacency(indices.size());
+            {
+                std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+                for(size_t i = 0; i < indices.size(); i++){
+                    adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+            std::vector<int32_t> cachePosition(vertexCount, -1);
+            std::vector<float> vertexScore(vertexCount);
+            for(size_t v = 0; v < vertexCount; v++){
+                vertexScore[v] = HVertexScore(tables, -1, remaining[v]);
+            }
+            std::vector<float> triangleScore(triangleCount);
+            std::vector<bool> emitted(triangleCount, false);
+            for(size_t t = 0; t < triangleCount; t++){
+                triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+            }
+
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            uint32_t cache[CACHE_SIZE + 3];
+            uint32_t cacheCount = 0;
+            uint32_t newCache[CACHE_SIZE + 3];
+            size_t cursor = 0;
+            int64_t best = -1;
+            for(size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++){
+                if(best < 0){
+                    // dead end, nothing in the cache has triangles left: continue in input order.
+                    while(emitted[cursor]){
+                        cursor++;
+                    }
+                    best = static_cast<int64_t>(cursor);
+                }
+                const uint32_t* triangle = &indices[best * 3];
+                emitted[best] = true;
+                uint32_t newCount = 0;
+                for(int k = 0; k < 3; k++){
+                    uint32_t v = triangle[k];
+                    result.push_back(v);
+                    newCache[newCount++] = v;
+                    // drop the triangle from the vertex's adjacency.
+                    uint32_t* begin = &adjacency[adjacencyOffset[v]];
+                    uint32_t* end = begin + remaining[v];
+                    *std::find(begin, end, static_cast<uint32_t>(best)) = *(end - 1);
+                    remaining[v]--;
+                }
+                for(uint32_t i = 0; i < cacheCount; i++){
+                    uint32_t v = cache[i];
+                    if(v != triangle[0] && v != triangle[1] && v != triangle[2]){
+                        newCache[newCount++] = v;
+                    }
+                }
+                // vertices pushed out of the cache lose their cache score.
+                for(uint32_t i = 0; i < newCount; i++){
+                    cachePosition[newCache[i]] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                }
+                for(uint32_t i = 0; i < newCount; i++){
+                    uint32_t v = newCache[i];
+                    float score = HVertexScore(tables, cachePosition[v], remaining[v]);
+                    float delta = score - vertexScore[v];
+                    vertexScore[v] = score;
+                    for(uint32_t a = 0; a < remaining[v]; a++){
+                        triangleScore[adjacency[adjacencyOffset[v] + a]] += delta;
+                    }
+                }
+                cacheCount = std::min(newCount, CACHE_SIZE);
+                best = -1;
+                float bestScore = -1.0f;
+                for(uint32_t i = 0; i < cacheCount; i++){
+                    uint32_t v = newCache[i];
+                    for(uint32_t a = 0; a < remaining[v]; a++){
+                        uint32_t t = adjacency[adjacencyOffset[v] + a];
+                        if(triangleScore[t] > bestScore){
+                            bestScore = triangleScore[t];
+                            best = t;
+                        }
+                    }
+                }
+                std::copy(newCache, newCache + cacheCount, cache);
+            }
+            return result;
+        }
+
+        //---- Overdraw ----//
+        // Splits the cache-ordered triangles where the cache starts cold anyway (every vertex of the
+        // triangle misses), then draws clusters facing away from the mesh center first: those are the
+        // ones most likely to occlude the rest. Reordering at cold starts keeps the ACMR.
+        std::vector<uint32_t> HOptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t& clusterCount){
+            size_t triangleCount = indices.size() / 3;
+            const uint32_t cacheSize = 16;
+            std::vector<uint32_t> clusterStarts;
+            std::vector<uint32_t> cacheTime(vertices.size(), 0);
+            uint32_t time = cacheSize + 1;
+            for(size_t t = 0; t < triangleCount; t++){
+                uint32_t misses = 0;
+                for(int k = 0; k < 3; k++){
+                    uint32_t v = indices[t * 3 + k];
+                    if(time - cacheTime[v] > cacheSize){
+                        cacheTime[v] = time++;
+                        misses++;
+                    }
+                }
+                if(t == 0 || misses == 3){
+                    clusterStarts.push_back(static_cast<uint32_t>(t));
+                }
+            }
+            clusterCount = static_cast<uint32_t>(clusterStarts.size());
+            clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+            glm::vec3 meshCenter(0.0f);
+            float meshArea = 0.0f;
+            struct Cluster{
+                uint32_t first;
+                uint32_t count;
+                float key;
+            };
+            std::vector<Cluster> clusters(clusterCount);
+            std::vector<glm::vec3> clusterCenters(clusterCount);
+            std::vector<glm::vec3> clusterNormals(clusterCount);
+            for(uint32_t c = 0; c < clusterCount; c++){
+                glm::vec3 center(0.0f), normal(0.0f);
+                float area = 0.0f;
+                for(uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++){
+                    const glm::vec3& a = vertices[indices[t * 3]].pos;
+                    const glm::vec3& b = vertices[indices[t * 3 + 1]].pos;
+                    const glm::vec3& d = vertices[indices[t * 3 + 2]].pos;
+                    // twice the area, pointing out of the counter-clockwise front face.
+                    glm::vec3 faceNormal = glm::cross(b - a, d - a);
+                    float faceArea = glm::length(faceNormal);
+                    center += (a + b + d) * (faceArea / 3.0f);
+                    normal += faceNormal;
+                    area += faceArea;
+                }
+                meshCenter += center;
+                meshArea += area;
+                clusterCenters[c] = area > 0.0f ? center / area : center;
+                clusterNormals[c] = normal;
+                clusters[c] = {clusterStarts[c], clusterStarts[c + 1] - clusterStarts[c], 0.0f};
+            }
+            if(meshArea > 0.0f){
+                meshCenter /= meshArea;
+            }
+            for(uint32_t c = 0; c < clusterCount; c++){
+                float length = glm::length(clusterNormals[c]);
+                clusters[c].key = length > 0.0f ? glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c] / length) : 0.0f;
+            }
+            std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b){
+                return a.key > b.key;
+            });
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            for(const auto& cluster : clusters){
+                result.insert(result.end(), indices.begin() + cluster.first * 3, indices.begin() + (cluster.first + cluster.count) * 3);
+            }
+            return result;
+        }
+
+        //---- Vertex fetch ----//
+        // renumbers vertices in the order the index buffer first touches them, unused ones are dropped.
+        uint32_t HOptimizeVertexFetch(MeshData& mesh){
+            std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+            std::vector<Vertex> vertices;
+            vertices.reserve(mesh.vertices.size());
+            for(uint32_t& index : mesh.indices){
+                if(remap[index] == UINT32_MAX){
+                    remap[index] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(mesh.vertices[index]);
+                }
+                index = remap[index];
+            }
+            uint32_t unused = static_cast<uint32_t>(mesh.vertices.size() - vertices.size());
+            mesh.vertices = std::move(vertices);
+            return unused;
+        }
+
+        //---- Simplification ----//
+        // Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", with half edge
+        // collapses. Planes are area weighted and the quadric keeps the summed weight, so
+        // Evaluate(p) / weight is the mean squared distance of p to the planes it collected.
+        struct Quadric{
+            double xx = 0.0, xy = 0.0, xz = 0.0, yy = 0.0, yz = 0.0, zz = 0.0;
+            double x = 0.0, y = 0.0, z = 0.0, c = 0.0;
+            double weight = 0.0;
+
+            // plane dot(normal, p) + d = 0, normal unit length.
+            void AddPlane(const glm::vec3& normal, float d, double planeWeight){
+                double nx = normal.x, ny = normal.y, nz = normal.z;
+                xx += planeWeight * nx * nx; xy += planeWeight * nx * ny; xz += planeWeight * nx * nz;
+                yy += planeWeight * ny * ny; yz += planeWeight * ny * nz; zz += planeWeight * nz * nz;
+                x += planeWeight * nx * d; y += planeWeight * ny * d; z += planeWeight * nz * d;
+                c += planeWeight * double(d) * d;
+                weight += planeWeight;
+            }
+            void Add(const Quadric& other){
+                xx += other.xx; xy += other.xy; xz += other.xz; yy += other.yy; yz += other.yz; zz += other.zz;
+                x += other.x; y += other.y; z += other.z; c += other.c;
+                weight += other.weight;
+            }
+            float Distance(const glm::vec3& p) const{
+                if(weight <= 0.0){
+                    return 0.0f;
+                }
+                double px = p.x, py = p.y, pz = p.z;
+                double sum = xx * px * px + yy * py * py + zz * pz * pz
+                    + 2.0 * (xy * px * py + xz * px * pz + yz * py * pz)
+                    + 2.0 * (x * px + y * py + z * pz) + c;
+                return static_cast<float>(std::sqrt(std::max(sum, 0.0) / weight));
+            }
+        };
+        struct Collapse{
+            float cost;
+            uint32_t from;
+            uint32_t to;
+            bool operator>(const Collapse& other) const {return cost > other.cost;}
+        };
+    }
+
+    float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize){
+        if(indices.size() < 3){
+            return 0.0f;
+        }
+        // FIFO: a hit does not move the vertex, so an entry is live for cacheSize misses.
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        size_t misses = 0;
+        for(uint32_t index : indices){
+            if(time - cacheTime[index] > cacheSize){
+                cacheTime[index] = time++;
+                misses++;
+            }
+        }
+        return static_cast<float>(misses) / (indices.size() / 3);
+    }
+
+    MeshOptimizeStats OptimizeMesh(MeshData& mesh){
+        J_PROFILE_FUNCTION();
+        MeshOptimizeStats stats;
+        // drop the trailing partial triangle a broken file may leave.
+        mesh.indices.resize(mesh.indices.size() / 3 * 3);
+        stats.acmrBefore = ComputeACMR(mesh.indices, mesh.vertices.size());
+        if(mesh.indices.empty()){
+            return stats;
+        }
+        mesh.indices = HOptimizeVertexCache(mesh.indices, mesh.vertices.size());
+        mesh.indices = HOptimizeOverdraw(mesh.indices, mesh.vertices, stats.clusters);
+        stats.unusedVertices = HOptimizeVertexFetch(mesh);
+        stats.acmrAfter = ComputeACMR(mesh.indices, mesh.vertices.size());
+        return stats;
+    }
+
+    MeshData SimplifyMesh(const MeshData& mesh, size_t targetIndexCount, float* error){
+        J_PROFILE_FUNCTION();
+        const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        const uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+        std::vector<uint32_t> indices(mesh.indices.begin(), mesh.indices.begin() + triangleCount * 3);
+        auto position = [&mesh](uint32_t vertex) -> const glm::vec3& {return mesh.vertices[vertex].pos;};
+        auto triangleNormal = [&position](uint32_t a, uint32_t b, uint32_t c){
+            return glm::cross(position(b) - position(a), position(c) - position(a));
+        };
+
+        // vertices sharing a position are one point of the surface, the first of them stands for all.
+        std::vector<uint32_t> point(vertexCount);
+        std::vector<uint32_t> wedges(vertexCount, 0);
+        {
+            std::vector<uint32_t> order(vertexCount);
+            std::iota(order.begin(), order.end(), 0u);
+            auto key = [&position](uint32_t vertex){
+                const glm::vec3& p = position(vertex);
+                return std::make_tuple(p.x, p.y, p.z);
+            };
+            std::stable_sort(order.begin(), order.end(), [&key](uint32_t a, uint32_t b){return key(a) < key(b);});
+            for(uint32_t i = 0; i < vertexCount; i++){
+                point[order[i]] = i > 0 && key(order[i]) == key(order[i - 1]) ? point[order[i - 1]] : order[i];
+                wedges[point[order[i]]]++;
+            }
+        }
+
+        std::vector<bool> removedTriangle(triangleCount, false);
+        std::vector<std::vector<uint32_t> > pointTriangles(vertexCount);
+        std::vector<Quadric> quadrics(vertexCount);
+        size_t indexCount = 0;
+        for(uint32_t t = 0; t < triangleCount; t++){
+            const uint32_t* triangle = &indices[t * 3];
+            uint32_t p0 = point[triangle[0]], p1 = point[triangle[1]], p2 = point[triangle[2]];
+            glm::vec3 normal = triangleNormal(triangle[0], triangle[1], triangle[2]);
+            float doubleArea = glm::length(normal);
+            if(p0 == p1 || p1 == p2 || p2 == p0 || doubleArea <= 0.0f){
+                // degenerate triangles cover no pixels, they are dropped.
+                removedTriangle[t] = true;
+                continue;
+            }
+            normal /= doubleArea;
+            for(uint32_t corner = 0; corner < 3; corner++){
+                quadrics[point[triangle[corner]]].AddPlane(normal, -glm::dot(normal, position(triangle[0])), doubleArea * 0.5);
+                pointTriangles[point[triangle[corner]]].push_back(t);
+            }
+            indexCount += 3;
+        }
+
+        // edges as sorted point pairs: used by one triangle on an open border, by more than two where
+        // the surface is not manifold.
+        auto edgeKey = [](uint32_t a, uint32_t b){
+            return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+        };
+        std::vector<uint64_t> edges;
+        edges.reserve(indexCount);
+        for(uint32_t t = 0; t < triangleCount; t++){
+            for(uint32_t corner = 0; !removedTriangle[t] && corner < 3; corner++){
+                edges.push_back(edgeKey(point[indices[t * 3 + corner]], point[indices[t * 3 + (corner + 1) % 3]]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        std::vector<bool> border(vertexCount, false);
+        std::vector<bool> locked(vertexCount, false);
+        for(uint32_t v = 0; v < vertexCount; v++){
+            // a seam point's wedges would each need their own collapse, keep them all.
+            locked[v] = wedges[v] > 1;
+        }
+        for(size_t begin = 0, end = 0; begin < edges.size(); begin = end){
+            while(end < edges.size() && edges[end] == edges[begin]){
+                end++;
+            }
+            uint32_t a = static_cast<uint32_t>(edges[begin] >> 32);
+            uint32_t b = static_cast<uint32_t>(edges[begin] & UINT32_MAX);
+            if(end - begin == 1){
+                border[a] = border[b] = true;
+            }
+            else if(end - begin > 2){
+                locked[a] = locked[b] = true;
+            }
+        }
+        // planes through border edges, perpendicular to their triangle, hold the outline in place.
+        for(uint32_t t = 0; t < triangleCount; t++){
+            if(removedTriangle[t]){
+                continue;
+            }
+            const uint32_t* triangle = &indices[t * 3];
+            glm::vec3 normal = glm::normalize(triangleNormal(triangle[0], triangle[1], triangle[2]));
+            for(uint32_t corner = 0; corner < 3; corner++){
+                uint32_t a = triangle[corner];
+                uint32_t b = triangle[(corner + 1) % 3];
+                auto range = std::equal_range(edges.begin(), edges.end(), edgeKey(point[a], point[b]));
+                if(range.second - range.first != 1){
+                    continue;
+                }
+                glm::vec3 edge = position(b) - position(a);
+                float lengthSquared = glm::dot(edge, edge);
+                if(lengthSquared <= 0.0f){
+                    continue;
+                }
+                glm::vec3 planeNormal = glm::normalize(glm::cross(edge, normal));
+                float d = -glm::dot(planeNormal, position(a));
+                quadrics[point[a]].AddPlane(planeNormal, d, lengthSquared);
+                quadrics[point[b]].AddPlane(planeNormal, d, lengthSquared);
+            }
+        }
+
+        // half edge collapses from -> to, cheapest first; to keeps its position.
+        auto collapseCost = [&](uint32_t from, uint32_t to){
+            Quadric quadric = quadrics[from];
+            quadric.Add(quadrics[to]);
+            return quadric.Distance(position(to));
+        };
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > queue;
+        auto pushEdge = [&](uint32_t a, uint32_t b){
+            if(!locked[a] && !locked[b]){
+                queue.push({collapseCost(a, b), a, b});
+                queue.push({collapseCost(b, a), b, a});
+            }
+        };
+        for(size_t i = 0; i < edges.size(); i++){
+            if(i == 0 || edges[i] != edges[i - 1]){
+                pushEdge(static_cast<uint32_t>(edges[i] >> 32), static_cast<uint32_t>(edges[i] & UINT32_MAX));
+            }
+        }
+        std::vector<uint32_t> fromNeighbors;
+        std::vector<uint32_t> toNeighbors;
+        auto gatherNeighbors = [&](uint32_t p, std::vector<uint32_t>& neighbors){
+            neighbors.clear();
+            for(uint32_t t : pointTriangles[p]){
+                for(uint32_t corner = 0; !removedTriangle[t] && corner < 3; corner++){
+                    if(point[indices[t * 3 + corner]] != p){
+                        neighbors.push_back(point[indices[t * 3 + corner]]);
+                    }
+                }
+            }
+            std::sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        };
+        auto containsPoint = [&](uint32_t t, uint32_t p){
+            return point[indices[t * 3]] == p || point[indices[t * 3 + 1]] == p || point[indices[t * 3 + 2]] == p;
+        };
+
+        std::vector<bool> removedPoint(vertexCount, false);
+        float maxError = 0.0f;
+        while(indexCount > targetIndexCount && !queue.empty()){
+            Collapse collapse = queue.top();
+            queue.pop();
+            uint32_t from = collapse.from;
+            uint32_t to = collapse.to;
+            if(removedPoint[from] || removedPoint[to]){
+                continue;
+            }
+            float cost = collapseCost(from, to);
+            if(cost > collapse.cost){
+                // quadrics only grow, a stale entry goes back in at its real cost.
+                queue.push({cost, from, to});
+                continue;
+            }
+            gatherNeighbors(from, fromNeighbors);
+            if(!std::binary_search(fromNeighbors.begin(), fromNeighbors.end(), to)){
+                continue;
+            }
+            uint32_t shared = 0;
+            bool flips = false;
+            for(uint32_t t : pointTriangles[from]){
+                if(removedTriangle[t]){
+                    continue;
+                }
+                if(containsPoint(t, to)){
+                    shared++;
+                    continue;
+                }
+                // unlocked points have a single wedge, the point is the vertex.
+                uint32_t moved[3] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+                glm::vec3 before = triangleNormal(moved[0], moved[1], moved[2]);
+                std::replace(std::begin(moved), std::end(moved), from, to);
+                glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+                // past ~75 degrees of turn a sliver is about to fold over, stop before it does.
+                flips = flips || glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+            }
+            // a border point only slides along its border, or the outline caves in.
+            if(flips || (border[from] && shared != 1)){
+                continue;
+            }
+            // link condition: points next to both must be the far corners of the shared triangles,
+            // anything else pinches the surface into a non-manifold one.
+            gatherNeighbors(to, toNeighbors);
+            size_t common = 0;
+            for(size_t i = 0, j = 0; i < fromNeighbors.size() && j < toNeighbors.size();){
+                if(fromNeighbors[i] == toNeighbors[j]){
+                    common++;
+                    i++;
+                    j++;
+                }
+                else if(fromNeighbors[i] < toNeighbors[j]){
+                    i++;
+                }
+                else{
+                    j++;
+                }
+            }
+            if(common != shared){
+                continue;
+            }
+
+            for(uint32_t t : pointTriangles[from]){
+                if(removedTriangle[t]){
+                    continue;
+                }
+                if(containsPoint(t, to)){
+                    removedTriangle[t] = true;
+                    indexCount -= 3;
+                    continue;
+                }
+                std::replace(indices.begin() + t * 3, indices.begin() + t * 3 + 3, from, to);
+                pointTriangles[to].push_back(t);
+            }
+            pointTriangles[from].clear();
+            auto& toTriangles = pointTriangles[to];
+            toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [&](uint32_t t){return removedTriangle[t];}), toTriangles.end());
+            quadrics[to].Add(quadrics[from]);
+            removedPoint[from] = true;
+            maxError = std::max(maxError, cost);
+            gatherNeighbors(to, toNeighbors);
+            for(uint32_t neighbor : toNeighbors){
+                pushEdge(neighbor, to);
+            }
+        }
+
+        MeshData result;
+        std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+        result.indices.reserve(indexCount);
+        for(uint32_t t = 0; t < triangleCount; t++){
+            for(uint32_t corner = 0; !removedTriangle[t] && corner < 3; corner++){
+                uint32_t vertex = indices[t * 3 + corner];
+                if(remap[vertex] == UINT32_MAX){
+                    remap[vertex] = static_cast<uint32_t>(result.vertices.size());
+                    result.vertices.push_back(mesh.vertices[vertex]);
+                }
+                result.indices.push_back(remap[vertex]);
+            }
+        }
+        if(error){
+            *error = maxError;
+        }
+        return result;
+    }
+
+    std::vector<MeshLod> GenerateMeshLods(const MeshData& mesh, uint32_t maxLevels){
+        J_PROFILE_FUNCTION();
+        std::vector<MeshLod> lods;
+        size_t triangleCount = mesh.indices.size() / 3;
+        size_t previousIndexCount = triangleCount * 3;
+        for(uint32_t level = 1; level <= maxLevels && level < 32; level++){
+            // every level starts from the full mesh, so its error is measured against it, not accumulated.
+            MeshLod lod;
+            lod.data = SimplifyMesh(mesh, (triangleCount >> level) * 3, &lod.error);
+            if(lod.data.indices.empty() || lod.data.indices.size() > previousIndexCount * 3 / 4){
+                break;
+            }
+            previousIndexCount = lod.data.indices.size();
+            OptimizeMesh(lod.data);
+            lods.push_back(std::move(lod));
+        }
+        return lods;
+    }
+}
@@ -1,15 +1,20 @@
-#define J_WINDOWS //TODO: move to cmake
-
-#ifdef J_WINDOWS
-    #define J_GLFW
+#ifdef _WIN32
+    #define J_WINDOWS
 #endif
 
+// GLFW is linked on every platform; headless runs simply never create a window.
+#define J_GLFW
+
 #ifdef J_GLFW
-    #define VK_USE_PLATFORM_WIN32_KHR
+    #ifdef J_WINDOWS
+        #define VK_USE_PLATFORM_WIN32_KHR
+    #endif
     #define GLFW_INCLUDE_VULKAN
     #include <GLFW/glfw3.h>
-    #define GLFW_EXPOSE_NATIVE_WIN32
-    #include <GLFW/glfw3native.h>
+    #ifdef J_WINDOWS
+        #define GLFW_EXPOSE_NATIVE_WIN32
+        #include <GLFW/glfw3native.h>
+    #endif
     typedef GLFWwindow* J_WINDOW_HANDLE;
 #else
-#endif
\ No newline at end of file
+#endif
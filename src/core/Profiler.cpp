@@ -0,0 +1,146 @@
+#include <Jpch.h>
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <iomanip>
+
+namespace ProjectJ{
+    namespace{
+        // Fields are relaxed atomics because a slot may be overwritten while the trace is being written.
+        struct ProfileEvent{
+            std::atomic<const char*> name{nullptr};
+            std::atomic<uint64_t> startNs{0};
+            std::atomic<uint64_t> durationNs{0};
+        };
+
+        // Every thread gets a fixed ring allocated when it registers. Recording never allocates,
+        // when the ring is full the oldest events are overwritten and counted as dropped.
+        constexpr size_t kRingSize = 1 << 16;
+
+        struct ThreadBuffer{
+            uint32_t threadId;
+            std::atomic<const char*> threadName{nullptr};
+            std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[kRingSize]};
+            // events ever pushed, the ring holds the last kRingSize of them. started runs ahead of
+            // count while a slot is being written, a reader checks it after copying (like a seqlock).
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> started{0};
+
+            void Push(const char* name, uint64_t startNs, uint64_t durationNs){
+                uint64_t index = count.load(std::memory_order_relaxed);
+                started.store(index + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                ProfileEvent& event = events[index % kRingSize];
+                event.name.store(name, std::memory_order_relaxed);
+                event.startNs.store(startNs, std::memory_order_relaxed);
+                event.durationNs.store(durationNs, std::memory_order_relaxed);
+                count.store(index + 1, std::memory_order_release);
+            }
+        };
+
+        struct Registry{
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer> > buffers;
+            std::atomic<uint32_t> nextThreadId{0};
+        };
+        Registry& GetRegistry(){
+            static Registry registry;
+            return registry;
+        }
+        ThreadBuffer& GetThreadBuffer(){
+            thread_local std::shared_ptr<ThreadBuffer> buffer = [](){
+                auto b = std::make_shared<ThreadBuffer>();
+                auto& registry = GetRegistry();
+                b->threadId = registry.nextThreadId.fetch_add(1);
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.buffers.push_back(b);
+                return b;
+            }();
+            return *buffer;
+        }
+        struct EventCopy{
+            const char* name;
+            uint64_t startNs;
+            uint64_t durationNs;
+        };
+        void WriteEscaped(std::ostream& out, const char* str){
+            for(const char* c = str; *c; c++){
+                if(*c == '"' || *c == '\\'){
+                    out << '\\';
+                }
+                out << *c;
+            }
+        }
+    }
+
+    uint64_t Profiler::Now(){
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+    void Profiler::Record(const char* name, uint64_t startNs, uint64_t endNs){
+        GetThreadBuffer().Push(name, startNs, endNs - startNs);
+    }
+    void Profiler::SetThreadName(const char* name){
+        GetThreadBuffer().threadName.store(name);
+    }
+    bool Profiler::WriteChromeTrace(const std::string& path){
+        std::ofstream out(path);
+        if(!out.is_open()){
+            JLOG_ERROR("failed to open trace file {}", path);
+            return false;
+        }
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        size_t eventCount = 0;
+        uint64_t droppedCount = 0;
+        std::vector<EventCopy> events;
+        for(const auto& buffer : registry.buffers){
+            if(const char* threadName = buffer->threadName.load()){
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":\"";
+                WriteEscaped(out, threadName);
+                out << "\"}}";
+                first = false;
+            }
+            // copy the ring, then drop what the writer may have overwritten while we were copying.
+            uint64_t end = buffer->count.load(std::memory_order_acquire);
+            uint64_t begin = end > kRingSize ? end - kRingSize : 0;
+            events.clear();
+            for(uint64_t i = begin; i < end; i++){
+                const ProfileEvent& event = buffer->events[i % kRingSize];
+                events.push_back({event.name.load(std::memory_order_relaxed), event.startNs.load(std::memory_order_relaxed),
+                    event.durationNs.load(std::memory_order_relaxed)});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t written = buffer->started.load(std::memory_order_relaxed);
+            size_t skip = static_cast<size_t>(std::min<uint64_t>(events.size(), written > kRingSize + begin ? written - kRingSize - begin : 0));
+            uint64_t dropped = begin + skip;
+            if(dropped > 0 && skip < events.size()){
+                // an instant event at the start of what is left, so the gap is visible in the viewer.
+                out << (first ? "" : ",") << "\n{\"name\":\"dropped events\",\"cat\":\"profiler\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->threadId
+                    << ",\"ts\":" << events[skip].startNs / 1000.0 << ",\"args\":{\"dropped\":" << dropped << "}}";
+                first = false;
+            }
+            for(size_t i = skip; i < events.size(); i++){
+                const EventCopy& event = events[i];
+                out << (first ? "" : ",") << "\n{\"name\":\"";
+                WriteEscaped(out, event.name);
+                out << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                    << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+                first = false;
+            }
+            eventCount += events.size() - skip;
+            droppedCount += dropped;
+            if(dropped > 0){
+                JLOG_WARN("profiler thread {} dropped {} events, its ring holds {}", buffer->threadId, dropped, kRingSize);
+            }
+        }
+        out << "\n],\"otherData\":{\"droppedEvents\":" << droppedCount << "}}\n";
+        JLOG_INFO("wrote {} profiler events to {}", eventCount, path);
+        return true;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#ifdef J_ENABLE_PROFILING
+    #define J_PROFILE_CONCAT_IMPL(a,b) a##b
+    #define J_PROFILE_CONCAT(a,b) J_PROFILE_CONCAT_IMPL(a,b)
+    // name must outlive the profiler, use string literals.
+    #define J_PROFILE_SCOPE(name) ::ProjectJ::ScopedCPUTimer J_PROFILE_CONCAT(jProfileScope,__LINE__)(name)
+    #define J_PROFILE_FUNCTION() J_PROFILE_SCOPE(__FUNCTION__)
+    #define J_PROFILE_THREAD(name) ::ProjectJ::Profiler::SetThreadName(name)
+#else
+    #define J_PROFILE_SCOPE(name)
+    #define J_PROFILE_FUNCTION()
+    #define J_PROFILE_THREAD(name)
+#endif
+
+namespace ProjectJ{
+    // Events go to a per-thread ring, recording never takes a lock or allocates.
+    // Only registering a thread's ring (its first event) and writing the trace do.
+    // A full ring overwrites its oldest events, the trace reports how many were lost.
+    class Profiler{
+    public:
+        static uint64_t Now();
+        static void Record(const char* name, uint64_t startNs, uint64_t endNs);
+        static void SetThreadName(const char* name);
+        // Chrome trace event format, loadable by chrome://tracing and Perfetto.
+        static bool WriteChromeTrace(const std::string& path);
+    };
+
+    class ScopedCPUTimer{
+    public:
+        ScopedCPUTimer(const char* name)
+            :mName(name), mStart(Profiler::Now()){
+        }
+        ~ScopedCPUTimer(){
+            Profiler::Record(mName, mStart, Profiler::Now());
+        }
+    private:
+        const char* mName;
+        uint64_t mStart;
+    };
+}
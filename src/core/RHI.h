@@ -1,23 +1,32 @@
 #pragma once
+// the backend is picked at build time, see J_RHI_BACKEND in CMakeLists.txt.
+#if defined(J_RHI_SOFTWARE)
+#include "../Software/SoftwareRHI.h"
+#elif defined(J_RHI_NULL)
+#include "../Null/NullRHI.h"
+#else
 #include "../Vulkan/VulkanApp.h"
+#endif
 
 namespace ProjectJ{
+#if defined(J_RHI_SOFTWARE)
+    using RHIType = SoftwareRHI;
+    using RHIConfig = SoftwareConfig;
+#elif defined(J_RHI_NULL)
+    using RHIType = NullRHI;
+    using RHIConfig = NullConfig;
+#else
     using RHIType = VulkanRHI;
     using RHIConfig = VulkanConfig;
+#endif
     class RHI {
     public:
-        static RHIType& Get(){
-            return *gInstance;
+        // Every instance owns its own device, queues, pools and resources, several may live in
+        // one process. An instance is driven by one thread at a time.
+        static std::unique_ptr<RHIType> Create(const RHIConfig& config){
+            auto rhi = std::make_unique<RHIType>(config);
+            rhi->Init();
+            return rhi;
         }
-        static void Create(const RHIConfig& config){
-            gInstance = new RHIType(config);
-            gInstance->Init();
-        }
-        static void Destroy(){
-            gInstance->Cleanup();
-            delete gInstance;
-        }
-    private:
-        static RHIType* gInstance;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+namespace ProjectJ{
+    // View into a finished frame's pixels. Only valid during the callback, backends reuse the
+    // memory for later frames.
+    struct ReadbackFrame{
+        const uint8_t* data;
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitch;
+        VkFormat format;
+        uint64_t frameSerial;
+    };
+    using ReadbackCallback = std::function<void(const ReadbackFrame&)>;
+}
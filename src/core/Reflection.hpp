@@ -10,6 +10,26 @@ struct init
   template <typename T>
   operator T(); // never defined
 };
+template <typename T>
+constexpr auto size_(tag<8>) 
+  -> decltype(T{init{}, init{}, init{}, init{}, init{}, init{}, init{}, init{}}, 0u)
+{ return 8u; }
+
+template <typename T>
+constexpr auto size_(tag<7>) 
+  -> decltype(T{init{}, init{}, init{}, init{}, init{}, init{}, init{}}, 0u)
+{ return 7u; }
+
+template <typename T>
+constexpr auto size_(tag<6>) 
+  -> decltype(T{init{}, init{}, init{}, init{}, init{}, init{}}, 0u)
+{ return 6u; }
+
+template <typename T>
+constexpr auto size_(tag<5>) 
+  -> decltype(T{init{}, init{}, init{}, init{}, init{}}, 0u)
+{ return 5u; }
+
 template <typename T>
 constexpr auto size_(tag<4>) 
   -> decltype(T{init{}, init{}, init{}, init{}}, 0u)
@@ -35,18 +55,50 @@ constexpr auto size_(tag<0>)
   -> decltype(T{}, 0u)
 { return 0u; }
 
+// T{} with one more initializer than size_ probes compiles for wider aggregates too, they would
+// silently reflect as their first 8 members.
+template <typename T>
+constexpr auto too_many_members_(int) 
+  -> decltype(T{init{}, init{}, init{}, init{}, init{}, init{}, init{}, init{}, init{}}, true)
+{ return true; }
+
+template <typename T>
+constexpr bool too_many_members_(...)
+{ return false; }
+
 template <typename T>
 constexpr size_t size() 
 { 
   static_assert(std::is_aggregate_v<T>);
-  return size_<T>(tag<4>{}); // highest supported number 
+  static_assert(!too_many_members_<T>(0), "more members than size() reflects, add size_ and for_each_member cases");
+  return size_<T>(tag<8>{}); // highest supported number 
 }
 template <typename T, typename F>
 void for_each_member(T const& v, F f)
 {
   static_assert(std::is_aggregate_v<T>);
 
-  if constexpr (size<T>() == 4u)
+  if constexpr (size<T>() == 8u)
+  {
+    const auto& [m0, m1, m2, m3, m4, m5, m6, m7] = v;
+    f(0, m0); f(1, m1); f(2, m2); f(3, m3); f(4, m4); f(5, m5); f(6, m6); f(7, m7);
+  }
+  else if constexpr (size<T>() == 7u)
+  {
+    const auto& [m0, m1, m2, m3, m4, m5, m6] = v;
+    f(0, m0); f(1, m1); f(2, m2); f(3, m3); f(4, m4); f(5, m5); f(6, m6);
+  }
+  else if constexpr (size<T>() == 6u)
+  {
+    const auto& [m0, m1, m2, m3, m4, m5] = v;
+    f(0, m0); f(1, m1); f(2, m2); f(3, m3); f(4, m4); f(5, m5);
+  }
+  else if constexpr (size<T>() == 5u)
+  {
+    const auto& [m0, m1, m2, m3, m4] = v;
+    f(0, m0); f(1, m1); f(2, m2); f(3, m3); f(4, m4);
+  }
+  else if constexpr (size<T>() == 4u)
   {
     const auto& [m0, m1, m2, m3] = v;
     f(0, m0); f(1, m1); f(2, m2); f(3, m3);
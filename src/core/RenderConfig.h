@@ -0,0 +1,55 @@
+#pragma once
+#include "PlatformInclude.h"
+#include "Scene.h"
+
+namespace ProjectJ{
+    // Options every backend takes, so one config fills whichever RHIConfig the build picked. Each
+    // backend's config derives from it and adds only its own fields; what a backend does not support
+    // is said on its config.
+    struct RenderConfig{
+        bool enableValidationLayer = false;
+        J_WINDOW_HANDLE window = nullptr;
+        // headless renders into offscreen images of width x height, no window, surface or VK_KHR_swapchain needed.
+        bool headless = false;
+        uint32_t width = 800;
+        uint32_t height = 600;
+        // copies every frame's color image back to host memory, see SetReadbackCallback.
+        bool enableReadback = false;
+        uint32_t statsLogInterval = 0;
+        // only read during Init, nullptr draws the default textured quad.
+        const Scene* scene = nullptr;
+        // animation advances by this many seconds per frame instead of wall time when > 0, for reproducible frames.
+        float fixedTimeStep = 0.0f;
+        // how mesh vertices are stored and fetched, the pipeline's vertex input follows it.
+        VertexEncoding vertexEncoding = VertexEncoding::Packed;
+        // draws every mesh and material batch as one instance range through vkCmdDrawIndexedIndirect
+        // instead of one draw per object, see InstancedShader.
+        bool enableInstancing = false;
+        // writes only the instances whose bounds intersect the camera frustum, see FrustumCuller. Needs
+        // enableInstancing and drawIndirectFirstInstance, per-object draws are recorded once at Init.
+        bool enableFrustumCulling = false;
+        // culls and compacts the instances in compute passes and draws them with vkCmdDrawIndexedIndirectCount,
+        // the CPU only writes the camera, and the objects that moved, each frame. Needs enableInstancing and drawIndirectCount, takes
+        // the place of enableFrustumCulling.
+        bool enableGPUCulling = false;
+        // depth attachment from the render target pool, tested and written with LESS, GREATER with reverseZ.
+        bool enableDepth = false;
+        // reverse-Z projection, see ComputeSceneView.
+        bool reverseZ = false;
+        // draws the scene's depth with a position only pipeline first, then shades with EQUAL and no depth
+        // writes, so each pixel is shaded once however much the scene overdraws. Implies enableDepth.
+        bool enableDepthPrepass = false;
+        // GPU culling also drops objects hidden behind the previous frame's depth, reduced into a depth
+        // pyramid after the main pass (see DepthPyramidShader). Needs enableGPUCulling and a sampleable D32
+        // depth format, implies enableDepth. Objects coming into view show up one frame late.
+        bool enableOcclusionCulling = false;
+        // picks every object's level of detail each frame by projected error, see LodSelector; levels come
+        // from SceneMesh::lods or GenerateMeshLods. Needs enableInstancing and drawIndirectFirstInstance,
+        // the GPU culling passes draw every object's full mesh.
+        bool enableLod = false;
+        // pixels of error a level may project to before the bias.
+        float lodPixelError = 1.0f;
+        // > 0 raises the LOD bias while frames take longer than this, see LodSelector::UpdateBudget.
+        float lodFrameBudgetMs = 0.0f;
+    };
+}
@@ -0,0 +1,160 @@
+#include <Jpch.h>
+#include "Scene.h"
+#include <random>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace ProjectJ{
+    SceneView ComputeSceneView(float time, float aspect, bool reverseZ){
+        SceneView sceneView;
+        sceneView.spin = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        sceneView.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        // swapping the planes maps near to 1 and far to 0.
+        sceneView.proj = reverseZ ? glm::perspective(glm::radians(45.0f), aspect, 10.0f, 0.1f)
+            : glm::perspective(glm::radians(45.0f), aspect, 0.1f, 10.0f);
+        sceneView.proj[1][1] *= -1;
+        return sceneView;
+    }
+
+    void AddSceneMeshes(const Scene& scene, MeshPool& pool, std::vector<LodChain>* lodChains){
+        J_PROFILE_FUNCTION();
+        // levels wait until every full mesh is in, which keeps scene mesh i at pool mesh i.
+        std::vector<std::vector<MeshLod> > levels;
+        auto addMesh = [&](const MeshData& data, const std::vector<MeshLod>& lods){
+            pool.Add(data);
+            if(lodChains){
+                levels.push_back(lods.empty() ? GenerateMeshLods(data) : lods);
+            }
+        };
+        if(scene.meshes.empty()){
+            addMesh(CreateQuadMesh(), {});
+        }
+        for(const auto& mesh : scene.meshes){
+            addMesh(mesh.path.empty() ? mesh.data : LoadMesh(mesh.path), mesh.lods);
+        }
+        if(!lodChains){
+            return;
+        }
+        lodChains->assign(levels.size(), LodChain());
+        for(uint32_t i = 0; i < static_cast<uint32_t>(levels.size()); i++){
+            LodChain& chain = (*lodChains)[i];
+            chain.meshes.push_back(i);
+            chain.errors.push_back(0.0f);
+            for(const auto& level : levels[i]){
+                chain.meshes.push_back(pool.Add(level.data));
+                chain.errors.push_back(level.error);
+            }
+        }
+    }
+    std::vector<uint32_t> SortObjectsForDrawing(std::vector<SceneObject>& objects, const MeshPool& pool){
+        for(const auto& object : objects){
+            if(object.meshIndex >= pool.GetMeshCount()){
+                throw std::runtime_error("scene object references a missing mesh.");
+            }
+        }
+        std::vector<uint32_t> order(objects.size());
+        for(uint32_t i = 0; i < static_cast<uint32_t>(order.size()); i++){
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+            uint32_t blockA = pool.GetRange(objects[a].meshIndex).block;
+            uint32_t blockB = pool.GetRange(objects[b].meshIndex).block;
+            if(blockA != blockB){
+                return blockA < blockB;
+            }
+            const SceneObject& objectA = objects[a];
+            const SceneObject& objectB = objects[b];
+            return objectA.materialIndex != objectB.materialIndex ? objectA.materialIndex < objectB.materialIndex : objectA.meshIndex < objectB.meshIndex;
+        });
+        std::vector<SceneObject> sorted;
+        sorted.reserve(objects.size());
+        for(uint32_t index : order){
+            sorted.push_back(objects[index]);
+        }
+        objects = std::move(sorted);
+        return order;
+    }
+    std::vector<DrawBatch> BuildDrawBatches(const std::vector<SceneObject>& objects){
+        std::vector<DrawBatch> batches;
+        for(uint32_t i = 0; i < static_cast<uint32_t>(objects.size()); i++){
+            if(batches.empty() || batches.back().meshIndex != objects[i].meshIndex || batches.back().materialIndex != objects[i].materialIndex){
+                batches.push_back({objects[i].meshIndex, objects[i].materialIndex, i, 0});
+            }
+            batches.back().objectCount++;
+        }
+        return batches;
+    }
+
+    Scene CreateDefaultScene(){
+        Scene scene;
+        SceneTexture texture{};
+        texture.path = "textures/texture.jpg";
+        scene.textures.push_back(texture);
+        scene.materials.push_back({0});
+        scene.objects.push_back({glm::mat4(1.0f), 0});
+        return scene;
+    }
+
+    Scene CreateSyntheticScene(const SyntheticSceneDesc& desc){
+        J_PROFILE_FUNCTION();
+        Scene scene;
+        std::mt19937 rng(desc.seed);
+        std::uniform_int_distribution<uint32_t> colorDist(64, 255);
+
+        uint32_t textureCount = std::max(1u, desc.textureCount);
+        uint32_t materialCount = std::max(1u, desc.materialCount);
+        uint32_t size = std::max(1u, desc.textureSize);
+        scene.textures.resize(textureCount);
+        for(auto& texture : scene.textures){
+            // checkerboard of two random colors, cheap to generate and not uniform for the sampler.
+            uint8_t a[3] = {uint8_t(colorDist(rng)), uint8_t(colorDist(rng)), uint8_t(colorDist(rng))};
+            uint8_t b[3] = {uint8_t(a[0] / 4), uint8_t(a[1] / 4), uint8_t(a[2] / 4)};
+            texture.width = size;
+            texture.height = size;
+            texture.pixels.resize(static_cast<size_t>(size) * size * 4);
+            for(uint32_t y = 0; y < size; y++){
+                for(uint32_t x = 0; x < size; x++){
+                    const uint8_t* c = ((x / 16 + y / 16) % 2) ? a : b;
+                    uint8_t* p = &texture.pixels[(static_cast<size_t>(y) * size + x) * 4];
+                    p[0] = c[0];
+                    p[1] = c[1];
+                    p[2] = c[2];
+                    p[3] = 255;
+                }
+            }
+        }
+
+        scene.materials.resize(materialCount);
+        for(uint32_t i = 0; i < materialCount; i++){
+            scene.materials[i].textureIndex = i % textureCount;
+        }
+
+        if(desc.meshCount > 1){
+            scene.meshes.resize(desc.meshCount);
+            for(uint32_t i = 0; i < desc.meshCount; i++){
+                // 3 to 64 sides, later meshes repeat the shape but are still uploaded separately.
+                scene.meshes[i].data = CreatePolygonMesh(3 + i % 62);
+            }
+        }
+
+        // identity groups, objects end up where they would be without them.
+        if(desc.groupCount > 0){
+            scene.nodes.assign(desc.groupCount + 1, {glm::mat4(1.0f), 0});
+            scene.nodes[0].parent = NO_PARENT;
+        }
+
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(1u, desc.objectCount)))));
+        float spacing = 3.0f / side;
+        std::uniform_real_distribution<float> jitter(-0.1f, 0.1f);
+        scene.objects.resize(desc.objectCount);
+        for(uint32_t i = 0; i < desc.objectCount; i++){
+            float x = -1.5f + spacing * (i % side + 0.5f + jitter(rng));
+            float y = -1.5f + spacing * (i / side + 0.5f + jitter(rng));
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+            model = glm::scale(model, glm::vec3(spacing * 0.8f));
+            uint32_t node = desc.groupCount > 0 ? 1 + i % desc.groupCount : NO_PARENT;
+            scene.objects[i] = {model, i % materialCount, i % std::max(1u, desc.meshCount), node};
+        }
+        return scene;
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/mat4x4.hpp>
+#include "Mesh.h"
+
+namespace ProjectJ{
+    // CPU-side description of what the renderer draws.
+    struct SceneTexture{
+        // loaded from disk when set, otherwise width x height RGBA8 pixels.
+        std::string path;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+    struct SceneMesh{
+        // loaded with LoadMesh when set, otherwise data.
+        std::string path;
+        MeshData data;
+        // coarser levels of detail from the artist, finest first, each error the object space distance
+        // from the full mesh. Left empty they are generated with GenerateMeshLods when LODs are used.
+        std::vector<MeshLod> lods;
+    };
+    struct SceneMaterial{
+        uint32_t textureIndex;
+    };
+    constexpr uint32_t NO_PARENT = UINT32_MAX;
+    // A transform of the hierarchy, local to its parent node; parents come before their children.
+    struct SceneNode{
+        glm::mat4 local;
+        uint32_t parent = NO_PARENT;
+    };
+    struct SceneObject{
+        // local to node, or world space without one.
+        glm::mat4 model;
+        uint32_t materialIndex;
+        uint32_t meshIndex = 0;
+        uint32_t node = NO_PARENT;
+    };
+    struct Scene{
+        // empty draws every object with the built-in quad.
+        std::vector<SceneMesh> meshes;
+        std::vector<SceneTexture> textures;
+        std::vector<SceneMaterial> materials;
+        std::vector<SceneNode> nodes;
+        std::vector<SceneObject> objects;
+    };
+
+    struct SyntheticSceneDesc{
+        uint32_t objectCount = 1000;
+        uint32_t textureCount = 16;
+        uint32_t materialCount = 64;
+        // 1 keeps the built-in quad, more generates that many distinct polygons.
+        uint32_t meshCount = 1;
+        uint32_t textureSize = 256;
+        // 0 leaves objects unparented, more puts them round robin under that many group nodes of one root.
+        uint32_t groupCount = 0;
+        uint32_t seed = 1;
+    };
+    // Camera and per-object spin shared by every backend, so they all render the same image.
+    // Clip space follows Vulkan: y points down, depth is 0 at the near plane, or 1 with reverseZ,
+    // which spreads float depth precision evenly over distance.
+    struct SceneView{
+        glm::mat4 spin;
+        glm::mat4 view;
+        glm::mat4 proj;
+    };
+    SceneView ComputeSceneView(float time, float aspect, bool reverseZ = false);
+    // The pool meshes of one scene mesh's levels of detail, finest first, and each level's object space
+    // error; level 0 is the mesh itself with no error.
+    struct LodChain{
+        std::vector<uint32_t> meshes;
+        std::vector<float> errors;
+    };
+    // Adds the scene's meshes, or the built-in quad when it has none, so scene mesh i is pool mesh i.
+    // With lodChains every mesh's coarser levels are added after all of them and chain i lists mesh i's.
+    void AddSceneMeshes(const Scene& scene, MeshPool& pool, std::vector<LodChain>* lodChains = nullptr);
+    // The order every backend draws in: by mesh block, so buffers are rebound once per block, then by
+    // material, then by mesh so equal objects are adjacent for instancing. Stable, so without a depth test
+    // overlapping objects land in the same order everywhere. Returns the index each sorted object had
+    // before, for SceneGraph::Build.
+    std::vector<uint32_t> SortObjectsForDrawing(std::vector<SceneObject>& objects, const MeshPool& pool);
+    // A run of sorted objects sharing mesh and material, drawn as one instanced draw.
+    struct DrawBatch{
+        uint32_t meshIndex;
+        uint32_t materialIndex;
+        uint32_t firstObject;
+        uint32_t objectCount;
+    };
+    // objects must be sorted with SortObjectsForDrawing, batches come out in the same order.
+    std::vector<DrawBatch> BuildDrawBatches(const std::vector<SceneObject>& objects);
+
+    // The textured quad the application has always drawn.
+    Scene CreateDefaultScene();
+    // Objects on a grid in front of the default camera, meshes, materials and textures assigned round
+    // robin so every one of them is actually used. Deterministic for a given seed.
+    Scene CreateSyntheticScene(const SyntheticSceneDesc& desc);
+}
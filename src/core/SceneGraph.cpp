@@ -0,0 +1,190 @@
+#include <Jpch.h>
+#include "SceneGraph.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define J_SCENE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace ProjectJ{
+    namespace{
+        // nodes per parallel job, smaller levels stay on the calling thread.
+        constexpr uint32_t CHUNK_SIZE = 4096;
+
+        // out = parent * local, column major like glm: every column of out is the parent's columns
+        // weighted by that column of local.
+        inline void HMultiply(const glm::mat4& parent, const glm::mat4& local, glm::mat4& out){
+#if defined(J_SCENE_SSE2)
+            const float* p = &parent[0][0];
+            const float* l = &local[0][0];
+            float* o = &out[0][0];
+            __m128 c0 = _mm_loadu_ps(p);
+            __m128 c1 = _mm_loadu_ps(p + 4);
+            __m128 c2 = _mm_loadu_ps(p + 8);
+            __m128 c3 = _mm_loadu_ps(p + 12);
+            for(int column = 0; column < 4; column++){
+                const float* w = l + column * 4;
+                __m128 r = _mm_mul_ps(c0, _mm_set1_ps(w[0]));
+                r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(w[1])));
+                r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(w[2])));
+                r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(w[3])));
+                _mm_storeu_ps(o + column * 4, r);
+            }
+#else
+            out = parent * local;
+#endif
+        }
+    }
+
+    SceneGraph::SceneGraph(uint32_t threadCount)
+        :mThreadCount(std::min(threadCount == 0 ? UINT32_MAX : threadCount, JobSystem::Get().GetThreadCount())){
+    }
+
+    void SceneGraph::Build(const std::vector<SceneNode>& nodes, const std::vector<SceneObject>& objects, const std::vector<uint32_t>& sceneOrder){
+        J_PROFILE_FUNCTION();
+        if(!sceneOrder.empty() && sceneOrder.size() != objects.size()){
+            throw std::runtime_error("scene order does not match the objects.");
+        }
+        mSceneNodeCount = static_cast<uint32_t>(nodes.size());
+        mObjectHandles.resize(objects.size());
+        for(uint32_t i = 0; i < static_cast<uint32_t>(objects.size()); i++){
+            mObjectHandles[sceneOrder.empty() ? i : sceneOrder[i]] = mSceneNodeCount + i;
+        }
+        uint32_t handleCount = mSceneNodeCount + static_cast<uint32_t>(objects.size());
+        std::vector<uint32_t> parents(handleCount);
+        std::vector<uint32_t> depths(handleCount);
+        uint32_t levelCount = 0;
+        for(uint32_t handle = 0; handle < handleCount; handle++){
+            bool isNode = handle < mSceneNodeCount;
+            uint32_t parent = isNode ? nodes[handle].parent : objects[handle - mSceneNodeCount].node;
+            if(parent != NO_PARENT && parent >= (isNode ? handle : mSceneNodeCount)){
+                throw std::runtime_error(isNode ? "scene node parent must come before the node." : "scene object references a missing node.");
+            }
+            parents[handle] = parent;
+            depths[handle] = parent == NO_PARENT ? 0 : depths[parent] + 1;
+            levelCount = std::max(levelCount, depths[handle] + 1);
+        }
+
+        // counting sort by depth, stable so siblings keep their order.
+        mLevelStarts.assign(levelCount + 1, 0);
+        for(uint32_t depth : depths){
+            mLevelStarts[depth + 1]++;
+        }
+        for(uint32_t level = 0; level < levelCount; level++){
+            mLevelStarts[level + 1] += mLevelStarts[level];
+        }
+        std::vector<uint32_t> nextSlots(mLevelStarts.begin(), mLevelStarts.end() - 1);
+        mSlots.resize(handleCount);
+        for(uint32_t handle = 0; handle < handleCount; handle++){
+            mSlots[handle] = nextSlots[depths[handle]]++;
+        }
+        mParents.resize(handleCount);
+        mLocal.resize(handleCount);
+        mWorld.resize(handleCount);
+        for(uint32_t handle = 0; handle < handleCount; handle++){
+            uint32_t slot = mSlots[handle];
+            mParents[slot] = parents[handle] == NO_PARENT ? NO_PARENT : mSlots[parents[handle]];
+            mLocal[slot] = handle < mSceneNodeCount ? nodes[handle].local : objects[handle - mSceneNodeCount].model;
+        }
+        mSlotObjects.assign(handleCount, NO_OBJECT);
+        for(uint32_t i = 0; i < static_cast<uint32_t>(objects.size()); i++){
+            mSlotObjects[mSlots[mSceneNodeCount + i]] = i;
+        }
+        mMovedScratch.resize(handleCount);
+        mMovedObjects.clear();
+        mMovedObjects.reserve(objects.size());
+        mDirty.assign(handleCount, 1);
+        mFirstDirtyLevel = levelCount > 0 ? 0 : UINT32_MAX;
+    }
+
+    void SceneGraph::SetLocal(uint32_t handle, const glm::mat4& local){
+        uint32_t slot = mSlots[handle];
+        mLocal[slot] = local;
+        mDirty[slot] = 1;
+        uint32_t level = static_cast<uint32_t>(std::upper_bound(mLevelStarts.begin(), mLevelStarts.end(), slot) - mLevelStarts.begin()) - 1;
+        mFirstDirtyLevel = std::min(mFirstDirtyLevel, level);
+    }
+
+    uint32_t SceneGraph::Update(){
+        J_PROFILE_FUNCTION();
+        mMovedObjects.clear();
+        if(mFirstDirtyLevel == UINT32_MAX){
+            return 0;
+        }
+        uint32_t updated = 0;
+        for(uint32_t level = mFirstDirtyLevel; level + 1 < static_cast<uint32_t>(mLevelStarts.size()); level++){
+            uint32_t levelBegin = mLevelStarts[level];
+            uint32_t levelEnd = mLevelStarts[level + 1];
+            uint32_t chunkCount = (levelEnd - levelBegin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            mChunkCounts.resize(chunkCount);
+            mChunkMoved.resize(chunkCount);
+            // the level above is complete, so every node of this one reads a final parent.
+            JobSystem::Get().ParallelFor(chunkCount, [&](uint32_t chunk){
+                uint32_t begin = levelBegin + chunk * CHUNK_SIZE;
+                mChunkCounts[chunk] = PUpdateRange(begin, std::min(begin + CHUNK_SIZE, levelEnd), mChunkMoved[chunk]);
+            }, mThreadCount);
+            for(uint32_t chunk = 0; chunk < chunkCount; chunk++){
+                updated += mChunkCounts[chunk];
+                const uint32_t* moved = &mMovedScratch[levelBegin + chunk * CHUNK_SIZE];
+                mMovedObjects.insert(mMovedObjects.end(), moved, moved + mChunkMoved[chunk]);
+            }
+        }
+        std::fill(mDirty.begin() + mLevelStarts[mFirstDirtyLevel], mDirty.end(), 0);
+        mFirstDirtyLevel = UINT32_MAX;
+        return updated;
+    }
+
+    uint32_t SceneGraph::PUpdateRange(uint32_t begin, uint32_t end, uint32_t& moved){
+        uint32_t updated = 0;
+        moved = 0;
+        for(uint32_t slot = begin; slot < end; slot++){
+            uint32_t parent = mParents[slot];
+            // a recomputed parent moves the whole subtree, the flag travels down a level at a time.
+            if(parent != NO_PARENT){
+                mDirty[slot] |= mDirty[parent];
+            }
+            if(!mDirty[slot]){
+                continue;
+            }
+            if(parent == NO_PARENT){
+                mWorld[slot] = mLocal[slot];
+            }
+            else{
+                HMultiply(mWorld[parent], mLocal[slot], mWorld[slot]);
+            }
+            if(mSlotObjects[slot] != NO_OBJECT){
+                // the range's own part of the scratch, at most one entry per slot.
+                mMovedScratch[begin + moved++] = mSlotObjects[slot];
+            }
+            updated++;
+        }
+        return updated;
+    }
+
+    void MovedObjectQueues::Init(uint32_t queueCount, uint32_t objectCount){
+        mObjectCount = objectCount;
+        mQueues.resize(queueCount);
+        for(auto& queue : mQueues){
+            queue.clear();
+            queue.reserve(objectCount);
+        }
+        mQueued.assign(static_cast<size_t>(queueCount) * objectCount, 0);
+    }
+    void MovedObjectQueues::Add(const std::vector<uint32_t>& moved){
+        for(size_t q = 0; q < mQueues.size(); q++){
+            uint8_t* queued = &mQueued[q * mObjectCount];
+            for(uint32_t object : moved){
+                if(!queued[object]){
+                    queued[object] = 1;
+                    mQueues[q].push_back(object);
+                }
+            }
+        }
+    }
+    void MovedObjectQueues::Clear(uint32_t queue){
+        uint8_t* queued = &mQueued[static_cast<size_t>(queue) * mObjectCount];
+        for(uint32_t object : mQueues[queue]){
+            queued[object] = 0;
+        }
+        mQueues[queue].clear();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "Scene.h"
+#include "JobSystem.h"
+
+namespace ProjectJ{
+    // Transform hierarchy as flat arrays sorted by depth: every level is one contiguous range and
+    // parents always sit in an earlier one, so world matrices are computed level by level with each
+    // level split over JobSystem threads and no node ever waiting on another of its level. Only nodes set
+    // since the last Update and their subtrees are recomputed.
+    //
+    // Handles: scene node i is handle i, object j of the scene is GetObjectHandle(j), a leaf under the
+    // object's node whose local transform is SceneObject::model. The objects passed to Build are in draw
+    // order, sceneOrder maps them back to the scene's order; GetObjectWorld takes the draw order index.
+    class SceneGraph{
+    public:
+        // threads of the shared JobSystem to use, 0 for all of them, 1 updates on the calling thread only.
+        SceneGraph(uint32_t threadCount = 0);
+        SceneGraph(const SceneGraph&) = delete;
+        SceneGraph& operator=(const SceneGraph&) = delete;
+
+        // throws unless every parent comes before its node; every node starts out dirty.
+        // sceneOrder is what SortObjectsForDrawing returned, empty when the objects are in scene order.
+        void Build(const std::vector<SceneNode>& nodes, const std::vector<SceneObject>& objects, const std::vector<uint32_t>& sceneOrder = {});
+        uint32_t GetObjectHandle(uint32_t sceneObject) const {return mObjectHandles[sceneObject];}
+        void SetLocal(uint32_t handle, const glm::mat4& local);
+        // recomputes the world matrices of dirty nodes and everything below them, returns how many.
+        uint32_t Update();
+        // the objects, as indices into the objects passed to Build, whose world matrix the last Update
+        // recomputed; in no particular order. Lets callers follow moves at the cost of what moved.
+        const std::vector<uint32_t>& GetMovedObjects() const {return mMovedObjects;}
+        const glm::mat4& GetWorld(uint32_t handle) const {return mWorld[mSlots[handle]];}
+        const glm::mat4& GetObjectWorld(uint32_t object) const {return mWorld[mSlots[mSceneNodeCount + object]];}
+        uint32_t GetLevelCount() const {return static_cast<uint32_t>(mLevelStarts.size()) - 1;}
+        uint32_t GetThreadCount() const {return mThreadCount;}
+    private:
+        // world matrices of the dirty slots in [begin, end), returns how many; moved of them are objects,
+        // listed from mMovedScratch[begin] on.
+        uint32_t PUpdateRange(uint32_t begin, uint32_t end, uint32_t& moved);
+    private:
+        uint32_t mThreadCount;
+        uint32_t mSceneNodeCount = 0;
+        // by slot, in depth order; parents are slots too, NO_PARENT for roots.
+        std::vector<uint32_t> mParents;
+        std::vector<glm::mat4> mLocal;
+        std::vector<glm::mat4> mWorld;
+        std::vector<uint8_t> mDirty;
+        // handle -> slot, objects' handles in draw order.
+        std::vector<uint32_t> mSlots;
+        // scene object -> handle.
+        std::vector<uint32_t> mObjectHandles;
+        // first slot of every level, then the slot count.
+        std::vector<uint32_t> mLevelStarts;
+        // the shallowest level with a dirty node, UINT32_MAX when clean.
+        uint32_t mFirstDirtyLevel = UINT32_MAX;
+        std::vector<uint32_t> mChunkCounts;
+        std::vector<uint32_t> mChunkMoved;
+        static constexpr uint32_t NO_OBJECT = UINT32_MAX;
+        // by slot, the object it holds or NO_OBJECT for scene nodes.
+        std::vector<uint32_t> mSlotObjects;
+        // by slot, each update range lists its moved objects in its own slots.
+        std::vector<uint32_t> mMovedScratch;
+        std::vector<uint32_t> mMovedObjects;
+    };
+
+    // The objects moved since each of several copies of them, one per swapchain image, was last
+    // written, so a copy catches up on what moved in every frame it missed and on nothing else. The
+    // lists are sized for every object at Init, queueing never allocates.
+    class MovedObjectQueues{
+    public:
+        void Init(uint32_t queueCount, uint32_t objectCount);
+        // queues every moved object on every queue, once per queue until that queue is cleared.
+        void Add(const std::vector<uint32_t>& moved);
+        const std::vector<uint32_t>& Get(uint32_t queue) const {return mQueues[queue];}
+        void Clear(uint32_t queue);
+    private:
+        std::vector<std::vector<uint32_t> > mQueues;
+        // queue * object count + object, 1 while queued.
+        std::vector<uint8_t> mQueued;
+        uint32_t mObjectCount = 0;
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace ProjectJ{
+    // Fixed window of the most recent samples, used for avg/percentile reporting.
+    class RollingStats{
+    public:
+        RollingStats(size_t capacity = 256)
+            :mCapacity(capacity){
+            mSamples.reserve(capacity);
+        }
+        void Add(double sample){
+            if(mSamples.size() < mCapacity){
+                mSamples.push_back(sample);
+            }
+            else{
+                mSamples[mNext] = sample;
+            }
+            mNext = (mNext + 1) % mCapacity;
+        }
+        void Clear(){
+            mSamples.clear();
+            mNext = 0;
+        }
+        size_t Count() const {return mSamples.size();}
+        double Average() const{
+            if(mSamples.empty()) return 0.0;
+            double sum = 0.0;
+            for(double s : mSamples){
+                sum += s;
+            }
+            return sum / mSamples.size();
+        }
+        // p in [0,1]
+        double Percentile(double p) const{
+            if(mSamples.empty()) return 0.0;
+            std::vector<double> sorted(mSamples);
+            size_t n = std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+            std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+            return sorted[n];
+        }
+    private:
+        std::vector<double> mSamples;
+        size_t mCapacity;
+        size_t mNext = 0;
+    };
+}
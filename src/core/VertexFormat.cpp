@@ -0,0 +1,81 @@
+#include <Jpch.h>
+#include "VertexFormat.h"
+#include <cmath>
+#include <cstring>
+
+namespace ProjectJ{
+    uint16_t EncodeHalf(float value){
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t exponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+        if(exponent == 0xff){
+            return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+        }
+        int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+        if(halfExponent >= 31){
+            return static_cast<uint16_t>(sign | 0x7c00);
+        }
+        uint32_t shift = 13;
+        uint32_t half;
+        if(halfExponent <= 0){
+            // below the smallest normal half, becomes subnormal or zero.
+            if(halfExponent < -10){
+                return static_cast<uint16_t>(sign);
+            }
+            mantissa |= 0x800000;
+            shift = static_cast<uint32_t>(14 - halfExponent);
+            half = mantissa >> shift;
+        }
+        else{
+            half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> shift);
+        }
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        // a carry out of the mantissa correctly bumps the exponent, up to infinity.
+        if(remainder > halfway || (remainder == halfway && (half & 1))){
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    float DecodeHalf(uint16_t value){
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1f;
+        uint32_t mantissa = value & 0x3ff;
+        if(exponent == 0){
+            float subnormal = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign ? -subnormal : subnormal;
+        }
+        float result;
+        uint32_t bits = sign | (exponent == 31 ? 0x7f800000 | (mantissa << 13) : ((exponent + 127 - 15) << 23) | (mantissa << 13));
+        std::memcpy(&result, &bits, sizeof(bits));
+        return result;
+    }
+    uint8_t EncodeUnorm8(float value){
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+    int8_t EncodeSnorm8(float value){
+        return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+    }
+    int16_t EncodeSnorm16(float value){
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    const char* ToString(VertexEncoding encoding){
+        switch(encoding){
+            case VertexEncoding::Float:         return "float";
+            case VertexEncoding::Packed:        return "packed";
+            case VertexEncoding::PackedSplit:   return "split";
+        }
+        return "unknown";
+    }
+    VertexEncoding ParseVertexEncoding(const std::string& name){
+        for(VertexEncoding encoding : {VertexEncoding::Float, VertexEncoding::Packed, VertexEncoding::PackedSplit}){
+            if(name == ToString(encoding)){
+                return encoding;
+            }
+        }
+        throw std::runtime_error("unknown vertex format " + name);
+    }
+}
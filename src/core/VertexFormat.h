@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+namespace ProjectJ{
+    // Quantized vertex components. The GPU expands them to floats on fetch (SFLOAT, UNORM and SNORM
+    // formats), so shaders read them exactly like the float originals.
+    struct Half2{
+        uint16_t x, y;
+    };
+    struct Unorm8x4{
+        uint8_t x, y, z, w;
+    };
+    struct Snorm8x4{
+        int8_t x, y, z, w;
+    };
+    struct Snorm16x4{
+        int16_t x, y, z, w;
+    };
+    // round to nearest even, overflow saturates to infinity.
+    uint16_t EncodeHalf(float value);
+    float DecodeHalf(uint16_t value);
+    // clamp to [0,1] / [-1,1], then round to nearest.
+    uint8_t EncodeUnorm8(float value);
+    int8_t EncodeSnorm8(float value);
+    int16_t EncodeSnorm16(float value);
+
+    // One shader input of a vertex struct. Vertex structs list theirs in a static constexpr
+    // Attributes() so backends can derive their input layout from the struct at compile time, e.g.
+    // the Vulkan formats come from VulkanVertexFormat<T>.
+    template<typename V, typename T>
+    struct VertexAttribute{
+        using VertexType = V;
+        using ComponentType = T;
+        T V::* member;
+        uint32_t location;
+    };
+    template<typename V, typename T>
+    constexpr VertexAttribute<V, T> MakeVertexAttribute(T V::* member, uint32_t location){
+        return {member, location};
+    }
+    // every vertex struct puts its 3D position here, vertex shaders read it as at least a vec3.
+    constexpr uint32_t VERTEX_POSITION_LOCATION = 0;
+
+    // How MeshPool stores vertices for the GPU; converted once when a mesh is added.
+    enum class VertexEncoding{
+        // Vertex as is, 32 bytes.
+        Float,
+        // PackedVertex, 16 bytes.
+        Packed,
+        // PackedPosition + PackedAttributes in two streams, 8 + 8 bytes, so position-only passes
+        // fetch half as much.
+        PackedSplit
+    };
+    const char* ToString(VertexEncoding encoding);
+    // "float", "packed" or "split", throws on anything else.
+    VertexEncoding ParseVertexEncoding(const std::string& name);
+
+    // Positions are snorm relative to the mesh bounds, MeshRange::positionOffset/positionScale map them
+    // back to object space. w is always 1.
+    struct PackedVertex{
+        Snorm16x4 pos;
+        Unorm8x4 color;
+        Half2 texCoord;
+        static constexpr auto Attributes(){
+            return std::make_tuple(
+                MakeVertexAttribute(&PackedVertex::pos, VERTEX_POSITION_LOCATION),
+                MakeVertexAttribute(&PackedVertex::color, 1),
+                MakeVertexAttribute(&PackedVertex::texCoord, 2));
+        }
+    };
+    struct PackedPosition{
+        Snorm16x4 pos;
+        static constexpr auto Attributes(){
+            return std::make_tuple(MakeVertexAttribute(&PackedPosition::pos, VERTEX_POSITION_LOCATION));
+        }
+    };
+    struct PackedAttributes{
+        Unorm8x4 color;
+        Half2 texCoord;
+        static constexpr auto Attributes(){
+            return std::make_tuple(
+                MakeVertexAttribute(&PackedAttributes::color, 1),
+                MakeVertexAttribute(&PackedAttributes::texCoord, 2));
+        }
+    };
+    static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed");
+    static_assert(sizeof(PackedPosition) + sizeof(PackedAttributes) == sizeof(PackedVertex), "split streams must add up to PackedVertex");
+}
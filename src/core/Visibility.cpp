@@ -0,0 +1,191 @@
+#include <Jpch.h>
+#include "Visibility.h"
+#include <cfloat>
+#include <cmath>
+#if defined(__AVX__)
+    #define J_CULL_AVX
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define J_CULL_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace ProjectJ{
+    namespace{
+        // objects per parallel job, big enough that scheduling is noise next to the tests.
+        constexpr uint32_t CHUNK_SIZE = 16384;
+        static_assert(CHUNK_SIZE % CULL_BATCH == 0, "chunks must hold whole batches");
+
+        // appends base + lane for every set bit of mask without branching on it.
+        inline uint32_t HEmitVisible(uint32_t* out, uint32_t count, uint32_t base, int mask, uint32_t lanes){
+            for(uint32_t lane = 0; lane < lanes; lane++){
+                out[count] = base + lane;
+                count += (mask >> lane) & 1;
+            }
+            return count;
+        }
+
+        void HSetObjectBounds(const SceneObject& object, const MeshPool& pool, BoundingSpheres& bounds, uint32_t index){
+            const glm::mat4& model = object.model;
+            const MeshRange& range = pool.GetRange(object.meshIndex);
+            glm::vec4 center = model * glm::vec4(range.boundsCenter, 1.0f);
+            // the largest axis scale keeps the sphere conservative under non-uniform scaling.
+            float scale = 0.0f;
+            for(int axis = 0; axis < 3; axis++){
+                const glm::vec4& column = model[axis];
+                scale = std::max(scale, column.x * column.x + column.y * column.y + column.z * column.z);
+            }
+            bounds.Set(index, glm::vec3(center.x, center.y, center.z), range.boundsRadius * std::sqrt(scale));
+        }
+    }
+
+    void BoundingSpheres::Resize(uint32_t newCount){
+        count = newCount;
+        size_t padded = (static_cast<size_t>(newCount) + CULL_BATCH - 1) / CULL_BATCH * CULL_BATCH;
+        centerX.resize(padded, 0.0f);
+        centerY.resize(padded, 0.0f);
+        centerZ.resize(padded, 0.0f);
+        radius.resize(padded, 0.0f);
+        // padding lanes fail every plane test.
+        std::fill(radius.begin() + newCount, radius.end(), -FLT_MAX);
+    }
+
+    Frustum ExtractFrustum(const glm::mat4& viewProj){
+        // Gribb/Hartmann: clip space bounds as combinations of the matrix rows.
+        auto row = [&viewProj](int i){
+            return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        };
+        Frustum frustum;
+        frustum.planes[0] = row(3) + row(0);
+        frustum.planes[1] = row(3) - row(0);
+        frustum.planes[2] = row(3) + row(1);
+        frustum.planes[3] = row(3) - row(1);
+        // depth is 0..w in Vulkan, not -w..w.
+        frustum.planes[4] = row(2);
+        frustum.planes[5] = row(3) - row(2);
+        for(auto& plane : frustum.planes){
+            float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+            if(length > 0.0f){
+                plane = plane * (1.0f / length);
+            }
+        }
+        return frustum;
+    }
+
+    void ComputeObjectBounds(const std::vector<SceneObject>& objects, const MeshPool& pool, BoundingSpheres& bounds){
+        J_PROFILE_FUNCTION();
+        bounds.Resize(static_cast<uint32_t>(objects.size()));
+        for(uint32_t i = 0; i < bounds.count; i++){
+            HSetObjectBounds(objects[i], pool, bounds, i);
+        }
+    }
+    void UpdateObjectBounds(const std::vector<SceneObject>& objects, const std::vector<uint32_t>& moved, const MeshPool& pool, BoundingSpheres& bounds){
+        J_PROFILE_FUNCTION();
+        for(uint32_t i : moved){
+            HSetObjectBounds(objects[i], pool, bounds, i);
+        }
+    }
+
+    FrustumCuller::FrustumCuller(uint32_t threadCount, bool useSimd)
+        :mThreadCount(std::min(threadCount == 0 ? UINT32_MAX : threadCount, JobSystem::Get().GetThreadCount())), mUseSimd(useSimd){
+    }
+    const char* FrustumCuller::GetSimdName() const{
+        if(!mUseSimd){
+            return "scalar";
+        }
+#if defined(J_CULL_AVX)
+        return "AVX";
+#elif defined(J_CULL_SSE2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    void FrustumCuller::Cull(const BoundingSpheres& bounds, const Frustum& frustum, std::vector<uint32_t>& visible){
+        J_PROFILE_FUNCTION();
+        uint32_t padded = static_cast<uint32_t>(bounds.radius.size());
+        uint32_t chunkCount = (padded + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        // every chunk writes at its own offset, the results are packed afterwards in chunk order.
+        visible.resize(padded);
+        mChunkCounts.resize(chunkCount);
+        JobSystem::Get().ParallelFor(chunkCount, [&](uint32_t chunk){
+            uint32_t begin = chunk * CHUNK_SIZE;
+            uint32_t end = std::min(begin + CHUNK_SIZE, padded);
+            mChunkCounts[chunk] = PCullRange(bounds, frustum, begin, end, visible.data() + begin);
+        }, mThreadCount);
+        uint32_t visibleCount = 0;
+        for(uint32_t chunk = 0; chunk < chunkCount; chunk++){
+            uint32_t* source = visible.data() + chunk * CHUNK_SIZE;
+            if(visibleCount != chunk * CHUNK_SIZE){
+                std::copy(source, source + mChunkCounts[chunk], visible.data() + visibleCount);
+            }
+            visibleCount += mChunkCounts[chunk];
+        }
+        visible.resize(visibleCount);
+    }
+
+    uint32_t FrustumCuller::PCullRange(const BoundingSpheres& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* out) const{
+        const float* cx = bounds.centerX.data();
+        const float* cy = bounds.centerY.data();
+        const float* cz = bounds.centerZ.data();
+        const float* r = bounds.radius.data();
+        uint32_t count = 0;
+        if(mUseSimd){
+#if defined(J_CULL_AVX)
+            __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+            for(int p = 0; p < 6; p++){
+                planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+                planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+                planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+                planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+            }
+            for(uint32_t i = begin; i < end; i += 8){
+                __m256 x = _mm256_loadu_ps(cx + i);
+                __m256 y = _mm256_loadu_ps(cy + i);
+                __m256 z = _mm256_loadu_ps(cz + i);
+                __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+                __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for(int p = 0; p < 6; p++){
+                    __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                        _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+                    inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+                }
+                count = HEmitVisible(out, count, i, _mm256_movemask_ps(inside), 8);
+            }
+            return count;
+#elif defined(J_CULL_SSE2)
+            __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+            for(int p = 0; p < 6; p++){
+                planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+                planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+                planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+                planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+            }
+            for(uint32_t i = begin; i < end; i += 4){
+                __m128 x = _mm_loadu_ps(cx + i);
+                __m128 y = _mm_loadu_ps(cy + i);
+                __m128 z = _mm_loadu_ps(cz + i);
+                __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for(int p = 0; p < 6; p++){
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                        _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+                }
+                count = HEmitVisible(out, count, i, _mm_movemask_ps(inside), 4);
+            }
+            return count;
+#endif
+        }
+        for(uint32_t i = begin; i < end; i++){
+            bool inside = true;
+            for(const auto& plane : frustum.planes){
+                inside &= (plane.x * cx[i] + plane.y * cy[i]) + (plane.z * cz[i] + plane.w) >= -r[i];
+            }
+            out[count] = i;
+            count += inside ? 1 : 0;
+        }
+        return count;
+    }
+}
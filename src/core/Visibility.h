@@ -0,0 +1,62 @@
+#pragma once
+#include "Scene.h"
+#include "JobSystem.h"
+#include <glm/vec4.hpp>
+
+namespace ProjectJ{
+    // World space bounding spheres as structure of arrays, so one SIMD load brings in a coordinate of
+    // several objects. Arrays are padded to a multiple of CULL_BATCH with spheres of negative radius
+    // that fail every plane, the culling loop has no tail.
+    struct BoundingSpheres{
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> centerZ;
+        std::vector<float> radius;
+        uint32_t count = 0;
+
+        void Resize(uint32_t newCount);
+        void Set(uint32_t index, const glm::vec3& center, float sphereRadius){
+            centerX[index] = center.x;
+            centerY[index] = center.y;
+            centerZ[index] = center.z;
+            radius[index] = sphereRadius;
+        }
+    };
+    // the widest batch any Cull path uses.
+    constexpr uint32_t CULL_BATCH = 8;
+
+    // Planes of a Vulkan clip space frustum (0 <= z <= w), normalized, pointing inwards:
+    // dot(plane.xyz, p) + plane.w >= 0 inside.
+    struct Frustum{
+        glm::vec4 planes[6];
+    };
+    Frustum ExtractFrustum(const glm::mat4& viewProj);
+
+    // the bounds of every object in world space, recomputed whenever model matrices change.
+    void ComputeObjectBounds(const std::vector<SceneObject>& objects, const MeshPool& pool, BoundingSpheres& bounds);
+    // recomputes only the moved objects' bounds, bounds already holds every object's.
+    void UpdateObjectBounds(const std::vector<SceneObject>& objects, const std::vector<uint32_t>& moved, const MeshPool& pool, BoundingSpheres& bounds);
+
+    // Frustum tests bounding spheres in SIMD batches (AVX when compiled in, SSE2, or scalar) over
+    // JobSystem threads and writes the indices of the visible ones in ascending order.
+    class FrustumCuller{
+    public:
+        // threads of the shared JobSystem to use, 0 for all of them, 1 culls on the calling thread only.
+        FrustumCuller(uint32_t threadCount = 0, bool useSimd = true);
+        FrustumCuller(const FrustumCuller&) = delete;
+        FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+        // visible is resized to the visible count.
+        void Cull(const BoundingSpheres& bounds, const Frustum& frustum, std::vector<uint32_t>& visible);
+        uint32_t GetThreadCount() const {return mThreadCount;}
+        // "AVX", "SSE2" or "scalar".
+        const char* GetSimdName() const;
+    private:
+        // culls [begin, end), a multiple of CULL_BATCH, into out; returns the visible count.
+        uint32_t PCullRange(const BoundingSpheres& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* out) const;
+    private:
+        uint32_t mThreadCount;
+        bool mUseSimd;
+        std::vector<uint32_t> mChunkCounts;
+    };
+}
@@ -1,9 +1,113 @@
 #include <Jpch.h>
 #include "core/Application.h"
 
-int main(char* argv,char** args) {
+int main(int argc, char** argv) {
     ProjectJ::AppInfo appInfo;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--headless"){
+            appInfo.headless = true;
+        }
+        else if(arg == "--no-validation"){
+            appInfo.enableValidationLayer = false;
+        }
+        else if(arg == "--frames" && hasValue){
+            appInfo.frameCount = std::stoull(argv[++i]);
+        }
+        else if(arg == "--mesh" && hasValue){
+            appInfo.meshPath = argv[++i];
+        }
+        else if(arg == "--fixed-timestep" && hasValue){
+            appInfo.fixedTimeStep = std::stof(argv[++i]);
+        }
+        else if(arg == "--vertex-format" && hasValue){
+            appInfo.vertexEncoding = ProjectJ::ParseVertexEncoding(argv[++i]);
+        }
+        else if(arg == "--instancing"){
+            appInfo.enableInstancing = true;
+        }
+        else if(arg == "--frustum-culling"){
+            appInfo.enableFrustumCulling = true;
+        }
+        else if(arg == "--gpu-culling"){
+            appInfo.enableGPUCulling = true;
+        }
+        else if(arg == "--depth"){
+            appInfo.enableDepth = true;
+        }
+        else if(arg == "--reverse-z"){
+            appInfo.reverseZ = true;
+        }
+        else if(arg == "--depth-prepass"){
+            appInfo.enableDepthPrepass = true;
+        }
+        else if(arg == "--occlusion-culling"){
+            appInfo.enableOcclusionCulling = true;
+        }
+        else if(arg == "--lod"){
+            appInfo.enableLod = true;
+        }
+        else if(arg == "--lod-pixel-error" && hasValue){
+            appInfo.lodPixelError = std::stof(argv[++i]);
+        }
+        else if(arg == "--lod-budget-ms" && hasValue){
+            appInfo.lodFrameBudgetMs = std::stof(argv[++i]);
+        }
+        else if(arg == "--render-thread"){
+            appInfo.renderThread = true;
+        }
+        else if(arg == "--frame-packets" && hasValue){
+            appInfo.framePackets = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if(arg == "--width" && hasValue){
+            appInfo.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if(arg == "--height" && hasValue){
+            appInfo.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if(arg == "--stats-interval" && hasValue){
+            appInfo.statsLogInterval = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if(arg == "--readback"){
+            appInfo.enableReadback = true;
+        }
+        else if(arg == "--capture" && hasValue){
+            appInfo.enableCapture = true;
+            appInfo.capture.directory = argv[++i];
+        }
+        else if(arg == "--capture-format" && hasValue){
+            std::string format = argv[++i];
+            if(format == "png"){
+                appInfo.capture.format = ProjectJ::CaptureFormat::Png;
+            }
+            else if(format == "jpg"){
+                appInfo.capture.format = ProjectJ::CaptureFormat::Jpeg;
+            }
+            else if(format == "raw"){
+                appInfo.capture.format = ProjectJ::CaptureFormat::Raw;
+            }
+            else{
+                JLOG_ERROR("unknown capture format {}, expected png, jpg or raw", format);
+                return 1;
+            }
+        }
+        else if(arg == "--capture-workers" && hasValue){
+            appInfo.capture.workerCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if(arg == "--capture-drop"){
+            appInfo.capture.overflow = ProjectJ::CaptureOverflow::Drop;
+        }
+        else if(arg == "--trace" && hasValue){
+            appInfo.traceOutputPath = argv[++i];
+        }
+        else{
+            // also an option missing its value, a typo would otherwise run with the defaults.
+            JLOG_ERROR("unknown argument {}", arg);
+            return 1;
+        }
+    }
     ProjectJ::Application app(appInfo);
     app.Run();
     return 0;
-}
\ No newline at end of file
+}